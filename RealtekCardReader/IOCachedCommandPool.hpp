@@ -0,0 +1,686 @@
+//
+//  IOCachedCommandPool.hpp
+//  RealtekCardReader
+//
+//  Created by FireWolf on 10/16/26.
+//
+
+#ifndef IOCachedCommandPool_hpp
+#define IOCachedCommandPool_hpp
+
+#include <IOKit/IOLocks.h>
+#include <IOKit/IOCommand.h>
+#include <libkern/OSAtomic.h>
+#include <kern/queue.h>
+#include "IOEnhancedCommandPool.hpp"
+#include "Debug.hpp"
+
+///
+/// Represents a command pool that keeps a small cache of free commands per submitting context in front of a shared depot
+///
+/// @tparam Command Specify the type of commands in the pool (must be a subclass of `IOCommand`).
+/// @tparam CommandCreator Specify the type of a callable object that creates a command dynamically;
+///                        The creator should overload the operator `()` which takes no arguments and returns a `Command` pointer;
+///                        By default, the command pool uses the `IOCommandCreator` that allocates an instance of `Command`.
+/// @tparam CommandDeleter Specify the type of a callable object that deletes a dynamically allocated command;
+///                        The deleter should overload the operator `()` which takes a non-null `Command` pointer and returns void;
+///                        By default, the command pool uses the `IOCommandDeleter` that releases any instances of `IOCommand`.
+/// @note A thread allocates and returns commands through the cache selected by its kernel stack,
+///       so concurrent submitters rarely contend on the same lock.
+///       The kext only links against the IOKit and libkern KPIs, which do not export the current processor number,
+///       so caches are selected by the submitting thread rather than the current processor.
+/// @note The pool grows on demand when both the cache and the depot are empty, up to the given maximum number of commands.
+///       A new command is allocated outside the depot lock and is counted against the limit before the lock is released.
+///       A thread is blocked waiting for a command only if the pool has reached its limit.
+/// @note Free commands are linked via `IOCommand::fCommandChain` while they are owned by the pool.
+///
+template <typename Command, typename CommandCreator = IOCommandCreator<Command>, typename CommandDeleter = IOCommandDeleter>
+class IOCachedCommandPool
+{
+    //
+    // MARK: - Constants
+    //
+    
+    /// The number of caches in front of the depot (must be a power of 2)
+    static constexpr IOItemCount kNumCaches = 8;
+    
+    /// The maximum number of free commands in each cache
+    static constexpr IOItemCount kCacheCapacity = 4;
+    
+    /// The number of low bits to discard from a stack address to identify the kernel stack of a thread
+    static constexpr UInt32 kStackAddressShift = 14;
+    
+    static_assert((kNumCaches & (kNumCaches - 1)) == 0, "The number of caches must be a power of 2.");
+    
+    //
+    // MARK: - Type Definitions
+    //
+    
+    /// A cache of free commands that is protected by a spin lock
+    struct Cache
+    {
+        /// The lock that protects the cache
+        IOSimpleLock* lock;
+        
+        /// The number of free commands in the cache
+        IOItemCount count;
+        
+        /// Free commands in the cache
+        Command* commands[kCacheCapacity];
+    };
+    
+    //
+    // MARK: - Private Properties
+    //
+    
+    /// Caches of free commands
+    Cache caches[kNumCaches];
+    
+    /// The lock that protects the depot and the number of allocated commands
+    IOLock* depotLock;
+    
+    /// The depot of free commands
+    queue_head_t depot;
+    
+    ///
+    /// The number of threads waiting for a free command
+    ///
+    /// @note This counter is modified with the depot lock held and read with the lock of a cache held.
+    ///
+    volatile UInt32 numWaiters;
+    
+    /// The number of commands allocated by the pool
+    IOItemCount numAllocated;
+    
+    /// The maximum number of commands that the pool can allocate
+    IOItemCount maxNumAllocated;
+    
+    /// The number of commands currently owned by clients
+    volatile SInt32 numInUse;
+    
+    /// The maximum number of commands owned by clients simultaneously
+    volatile SInt32 highWaterMark;
+    
+    /// The number of commands served from a cache
+    volatile SInt32 numCacheHits;
+    
+    /// The number of threads that have been blocked waiting for a command
+    volatile SInt32 numStalls;
+    
+    //
+    // MARK: - Cache Management
+    //
+    
+private:
+    ///
+    /// Get the cache associated with the calling thread
+    ///
+    /// @return A non-null cache.
+    ///
+    Cache* getCurrentCache()
+    {
+        UInt8 marker;
+        
+        uintptr_t stack = reinterpret_cast<uintptr_t>(&marker) >> kStackAddressShift;
+        
+        return &this->caches[(stack ^ (stack >> 3)) & (kNumCaches - 1)];
+    }
+    
+    ///
+    /// Take a free command from the given cache
+    ///
+    /// @param cache A non-null cache
+    /// @return A free command on success, `nullptr` if the cache is empty.
+    ///
+    Command* takeFromCache(Cache* cache)
+    {
+        Command* command = nullptr;
+        
+        IOSimpleLockLock(cache->lock);
+        
+        if (cache->count > 0)
+        {
+            cache->count -= 1;
+            
+            command = cache->commands[cache->count];
+        }
+        
+        IOSimpleLockUnlock(cache->lock);
+        
+        return command;
+    }
+    
+    ///
+    /// Put the given free command in the given cache
+    ///
+    /// @param cache A non-null cache
+    /// @param command A non-null free command
+    /// @return `true` on success, `false` if the cache is full or a thread is waiting for a free command.
+    ///
+    bool putInCache(Cache* cache, Command* command)
+    {
+        bool retVal = false;
+        
+        IOSimpleLockLock(cache->lock);
+        
+        // Waiters only observe commands in the depot
+        if (cache->count < kCacheCapacity && this->numWaiters == 0)
+        {
+            cache->commands[cache->count] = command;
+            
+            cache->count += 1;
+            
+            retVal = true;
+        }
+        
+        IOSimpleLockUnlock(cache->lock);
+        
+        return retVal;
+    }
+    
+    ///
+    /// Move all free commands in caches to the depot
+    ///
+    /// @note This function must be invoked with the depot lock held.
+    ///
+    void flushCachesToDepot()
+    {
+        for (IOItemCount index = 0; index < kNumCaches; index += 1)
+        {
+            Cache* cache = &this->caches[index];
+            
+            IOSimpleLockLock(cache->lock);
+            
+            while (cache->count > 0)
+            {
+                cache->count -= 1;
+                
+                IOCommand* command = cache->commands[cache->count];
+                
+                queue_enter(&this->depot, command, IOCommand*, fCommandChain);
+            }
+            
+            IOSimpleLockUnlock(cache->lock);
+        }
+    }
+    
+    ///
+    /// Take a free command from the depot and refill the given cache
+    ///
+    /// @param cache A non-null cache
+    /// @return A free command on success, `nullptr` if the depot is empty.
+    /// @note This function must be invoked with the depot lock held.
+    ///
+    Command* takeFromDepot(Cache* cache)
+    {
+        if (queue_empty(&this->depot))
+        {
+            return nullptr;
+        }
+        
+        IOCommand* command = nullptr;
+        
+        queue_remove_first(&this->depot, command, IOCommand*, fCommandChain);
+        
+        // Move up to half of the cache capacity so that subsequent allocations are served by the cache
+        IOSimpleLockLock(cache->lock);
+        
+        while (cache->count < kCacheCapacity / 2 && !queue_empty(&this->depot))
+        {
+            IOCommand* spare = nullptr;
+            
+            queue_remove_first(&this->depot, spare, IOCommand*, fCommandChain);
+            
+            cache->commands[cache->count] = static_cast<Command*>(spare);
+            
+            cache->count += 1;
+        }
+        
+        IOSimpleLockUnlock(cache->lock);
+        
+        return static_cast<Command*>(command);
+    }
+    
+    ///
+    /// Record that the given number of commands are owned by clients
+    ///
+    /// @param numCommands The number of commands currently owned by clients
+    ///
+    void updateHighWaterMark(SInt32 numCommands)
+    {
+        SInt32 mark;
+        
+        do
+        {
+            mark = this->highWaterMark;
+            
+            if (numCommands <= mark)
+            {
+                return;
+            }
+        }
+        while (!OSCompareAndSwap(static_cast<UInt32>(mark), static_cast<UInt32>(numCommands), reinterpret_cast<volatile UInt32*>(&this->highWaterMark)));
+    }
+    
+    //
+    // MARK: Startup Routines
+    //
+    
+private:
+    ///
+    /// Setup the locks and the depot
+    ///
+    /// @return `true` on success, `false` otherwise.
+    ///
+    bool setupStorage()
+    {
+        this->depotLock = IOLockAlloc();
+        
+        if (this->depotLock == nullptr)
+        {
+            return false;
+        }
+        
+        queue_init(&this->depot);
+        
+        for (IOItemCount index = 0; index < kNumCaches; index += 1)
+        {
+            this->caches[index].lock = nullptr;
+            
+            this->caches[index].count = 0;
+        }
+        
+        for (IOItemCount index = 0; index < kNumCaches; index += 1)
+        {
+            this->caches[index].lock = IOSimpleLockAlloc();
+            
+            if (this->caches[index].lock == nullptr)
+            {
+                this->tearDownStorage();
+                
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    ///
+    /// Preallocate the given number of commands and put them in the depot
+    ///
+    /// @param capacity The number of preallocated commands
+    /// @return `true` on success, `false` otherwise.
+    ///
+    bool setupCommands(IOItemCount capacity)
+    {
+        for (IOItemCount index = 0; index < capacity; index += 1)
+        {
+            IOCommand* command = CommandCreator{}();
+            
+            if (command == nullptr)
+            {
+                perr("[%02d] Failed to preallocate a command.", index);
+                
+                this->tearDownCommands();
+                
+                return false;
+            }
+            
+            queue_enter(&this->depot, command, IOCommand*, fCommandChain);
+            
+            this->numAllocated += 1;
+        }
+        
+        return true;
+    }
+    
+    //
+    // MARK: Tear Down Routines
+    //
+    
+private:
+    ///
+    /// Tear down the locks
+    ///
+    void tearDownStorage()
+    {
+        for (IOItemCount index = 0; index < kNumCaches; index += 1)
+        {
+            if (this->caches[index].lock != nullptr)
+            {
+                IOSimpleLockFree(this->caches[index].lock);
+                
+                this->caches[index].lock = nullptr;
+            }
+        }
+        
+        if (this->depotLock != nullptr)
+        {
+            IOLockFree(this->depotLock);
+            
+            this->depotLock = nullptr;
+        }
+    }
+    
+    ///
+    /// Release all free commands
+    ///
+    /// @note All commands must have been returned to the pool at this moment.
+    ///
+    void tearDownCommands()
+    {
+        this->flushCachesToDepot();
+        
+        while (!queue_empty(&this->depot))
+        {
+            IOCommand* command = nullptr;
+            
+            queue_remove_first(&this->depot, command, IOCommand*, fCommandChain);
+            
+            CommandDeleter{}(static_cast<Command*>(command));
+            
+            this->numAllocated -= 1;
+        }
+        
+        psoftassert(this->numAllocated == 0, "Detected %u commands that have not been returned to the pool.", this->numAllocated);
+    }
+    
+    //
+    // MARK: Initializer & Finalizer
+    //
+    
+public:
+    ///
+    /// Initialize a command pool with the given capacity
+    ///
+    /// @param capacity The number of preallocated commands
+    /// @param maxCapacity The maximum number of commands that the pool can allocate on demand
+    /// @return `true` on success, `false` otherwise.
+    ///
+    bool init(IOItemCount capacity, IOItemCount maxCapacity)
+    {
+        this->numWaiters = 0;
+        
+        this->numAllocated = 0;
+        
+        this->maxNumAllocated = max(capacity, maxCapacity);
+        
+        this->numInUse = 0;
+        
+        this->highWaterMark = 0;
+        
+        this->numCacheHits = 0;
+        
+        this->numStalls = 0;
+        
+        // Guard: Allocate the locks
+        if (!this->setupStorage())
+        {
+            perr("Failed to allocate the locks.");
+            
+            return false;
+        }
+        
+        // Guard: Preallocate an array of commands
+        if (!this->setupCommands(capacity))
+        {
+            perr("Failed to preallocate an array of commands.");
+            
+            this->tearDownStorage();
+            
+            return false;
+        }
+        
+        return true;
+    }
+    
+    ///
+    /// Tear down the command pool
+    ///
+    void free()
+    {
+        this->tearDownCommands();
+        
+        this->tearDownStorage();
+    }
+    
+    //
+    // MARK: Command Pool Factory
+    //
+    
+public:
+    ///
+    /// Create a command pool with the given capacity
+    ///
+    /// @param capacity The number of preallocated commands
+    /// @param maxCapacity The maximum number of commands that the pool can allocate on demand
+    /// @return A non-null command pool on success, `nullptr` otherwise.
+    ///
+    static IOCachedCommandPool* createWithCapacity(IOItemCount capacity, IOItemCount maxCapacity)
+    {
+        auto instance = new IOCachedCommandPool;
+        
+        if (instance == nullptr)
+        {
+            return nullptr;
+        }
+        
+        if (!instance->init(capacity, maxCapacity))
+        {
+            delete instance;
+            
+            return nullptr;
+        }
+        
+        return instance;
+    }
+    
+    ///
+    /// Destory the given command pool
+    ///
+    /// @param pool A non-null command pool returned by `IOCachedCommandPool::createWithCapacity()`.
+    ///
+    static void destory(IOCachedCommandPool* pool NONNULL)
+    {
+        pool->free();
+        
+        delete pool;
+    }
+    
+    ///
+    /// Destory a command pool safely
+    ///
+    /// @param pool A nullable command pool returned by `IOCachedCommandPool::createWithCapacity()`.
+    /// @note This function mimics the macro `OSSafeReleaseNULL()`.
+    ///
+    static void safeDestory(IOCachedCommandPool*& pool)
+    {
+        if (pool != nullptr)
+        {
+            IOCachedCommandPool::destory(pool);
+            
+            pool = nullptr;
+        }
+    }
+    
+    //
+    // MARK: Manage Commands
+    //
+    
+public:
+    ///
+    /// Get a command from the pool
+    ///
+    /// @param blockForCommand Pass `true` if the caller should be blocked waiting for a command
+    /// @return A non-null command if `blockForCommand` is `true`, otherwise a nullable command.
+    /// @note The semantics is identical to `IOCommandPool::getCommand()`.
+    ///
+    Command* getCommand(bool blockForCommand = true)
+    {
+        Cache* cache = this->getCurrentCache();
+        
+        // Fast path: Take a command from the cache
+        Command* command = this->takeFromCache(cache);
+        
+        if (command != nullptr)
+        {
+            OSIncrementAtomic(&this->numCacheHits);
+            
+            this->updateHighWaterMark(OSIncrementAtomic(&this->numInUse) + 1);
+            
+            return command;
+        }
+        
+        // Slow path: Take a command from the depot or grow the pool
+        IOLockLock(this->depotLock);
+        
+        while (true)
+        {
+            command = this->takeFromDepot(cache);
+            
+            if (command != nullptr)
+            {
+                break;
+            }
+            
+            if (this->numAllocated < this->maxNumAllocated)
+            {
+                // Reserve a slot for the new command and allocate it without holding the depot lock,
+                // since the allocator may block and other threads may return commands in the meantime
+                this->numAllocated += 1;
+                
+                IOLockUnlock(this->depotLock);
+                
+                command = CommandCreator{}();
+                
+                IOLockLock(this->depotLock);
+                
+                if (command != nullptr)
+                {
+                    pinfo("The pool has grown to %u commands.", this->numAllocated);
+                    
+                    break;
+                }
+                
+                perr("Failed to allocate a command on demand.");
+                
+                // Release the reserved slot and let waiters try to grow the pool
+                this->numAllocated -= 1;
+                
+                if (this->numWaiters != 0)
+                {
+                    IOLockWakeup(this->depotLock, &this->depot, false);
+                }
+            }
+            
+            if (!blockForCommand)
+            {
+                break;
+            }
+            
+            // Free commands may be held by other caches
+            // Returned commands go to the depot once the waiter is registered
+            this->numWaiters += 1;
+            
+            this->flushCachesToDepot();
+            
+            if (queue_empty(&this->depot))
+            {
+                OSIncrementAtomic(&this->numStalls);
+                
+                IOLockSleep(this->depotLock, &this->depot, THREAD_UNINT);
+            }
+            
+            this->numWaiters -= 1;
+        }
+        
+        IOLockUnlock(this->depotLock);
+        
+        if (command != nullptr)
+        {
+            this->updateHighWaterMark(OSIncrementAtomic(&this->numInUse) + 1);
+        }
+        
+        return command;
+    }
+    
+    ///
+    /// Return a command to the pool
+    ///
+    /// @param command A non-null command that is previously returned by `IOCachedCommandPool::getCommand()`
+    ///
+    void returnCommand(Command* command NONNULL)
+    {
+        OSDecrementAtomic(&this->numInUse);
+        
+        // Fast path: Put the command in the cache
+        if (this->putInCache(this->getCurrentCache(), command))
+        {
+            return;
+        }
+        
+        // Slow path: Put the command in the depot and wake up a waiter if any
+        IOLockLock(this->depotLock);
+        
+        IOCommand* base = command;
+        
+        queue_enter(&this->depot, base, IOCommand*, fCommandChain);
+        
+        if (this->numWaiters != 0)
+        {
+            IOLockWakeup(this->depotLock, &this->depot, true);
+        }
+        
+        IOLockUnlock(this->depotLock);
+    }
+    
+    ///
+    /// Run the given action with a command from the pool
+    ///
+    /// @param blockForCommand Pass `true` if the caller should be blocked waiting for a command
+    /// @param action A callable action that takes a command from the pool and returns an `IOReturn` code;
+    ///               Whether the command is null or not depends on the `blockForCommand` specified by the caller.
+    /// @return The value returned by the given action.
+    /// @note This function returns the command passed to the action routine to the pool automatically.
+    ///       The caller should not use the command after the action routine returns.
+    /// @note Signature of the action routine: `IOReturn operator()(Command*)` while `Command` is the actual command type.
+    ///
+    template <typename Action>
+    IOReturn withCommand(Action action, bool blockForCommand = true)
+    {
+        Command* command = this->getCommand(blockForCommand);
+        
+        IOReturn retVal = action(command);
+        
+        if (command != nullptr)
+        {
+            this->returnCommand(command);
+        }
+        
+        return retVal;
+    }
+    
+    //
+    // MARK: Statistics
+    //
+    
+public:
+    ///
+    /// Print the statistics of the pool
+    ///
+    /// @param name The name of the pool
+    ///
+    void printStatistics(const char* name)
+    {
+        IOLockLock(this->depotLock);
+        
+        IOItemCount numAllocated = this->numAllocated;
+        
+        IOLockUnlock(this->depotLock);
+        
+        pmesg("%s: Allocated = %u; Max = %u; In Use = %d; High Water Mark = %d; Cache Hits = %d; Stalls = %d.",
+              name, numAllocated, this->maxNumAllocated, this->numInUse, this->highWaterMark, this->numCacheHits, this->numStalls);
+    }
+};
+
+#endif /* IOCachedCommandPool_hpp */
@@ -7,22 +7,110 @@
 
 #include "IOSDBlockRequestQueue.hpp"
 #include "Debug.hpp"
-#include "IOCommandGate.hpp"
+#include <libkern/OSAtomic.h>
 #include <kern/queue.h>
 
 //
 // MARK: - Meta Class Definitions
 //
 
-OSDefineMetaClassAndStructors(IOSDBlockRequestQueue, IOCommandPool);
+OSDefineMetaClassAndStructors(IOSDBlockRequestQueue, OSObject);
 
 ///
-/// Create an empty queue protected by the given work loop
+/// [Helper] Move all submitted requests to the list of pending requests
+///
+/// @note This function must be invoked with the consumer lock held.
+///
+void IOSDBlockRequestQueue::collectSubmissions()
+{
+    // Guard: Detach the list of submissions
+    IOSDBlockRequest* head = nullptr;
+    
+    do
+    {
+        head = this->submissions;
+        
+        if (head == nullptr)
+        {
+            return;
+        }
+    }
+    while (!OSCompareAndSwapPtr(head, nullptr, reinterpret_cast<void* volatile*>(&this->submissions)));
+    
+    // The detached list is in the reverse order of submission
+    IOSDBlockRequest* reversed = nullptr;
+    
+    while (head != nullptr)
+    {
+        auto next = reinterpret_cast<IOSDBlockRequest*>(head->fCommandChain.next);
+        
+        head->fCommandChain.next = reinterpret_cast<queue_entry_t>(reversed);
+        
+        reversed = head;
+        
+        head = next;
+    }
+    
+    // Append the requests to the list of pending requests in their submission order
+    while (reversed != nullptr)
+    {
+        auto next = reinterpret_cast<IOSDBlockRequest*>(reversed->fCommandChain.next);
+        
+        IOCommand* command = reversed;
+        
+        queue_enter(&this->pendingRequests, command, IOCommand*, fCommandChain);
+        
+        reversed = next;
+    }
+}
+
+///
+/// Initialize an empty queue
+///
+/// @return `true` on success, `false` otherwise.
+///
+bool IOSDBlockRequestQueue::init()
+{
+    if (!super::init())
+    {
+        return false;
+    }
+    
+    this->consumerLock = IOLockAlloc();
+    
+    if (this->consumerLock == nullptr)
+    {
+        return false;
+    }
+    
+    this->submissions = nullptr;
+    
+    queue_init(&this->pendingRequests);
+    
+    return true;
+}
+
+///
+/// Release the queue
+///
+void IOSDBlockRequestQueue::free()
+{
+    if (this->consumerLock != nullptr)
+    {
+        IOLockFree(this->consumerLock);
+        
+        this->consumerLock = nullptr;
+    }
+    
+    super::free();
+}
+
+///
+/// Create an empty queue
 ///
-/// @param workLoop The workloop that the queue should synchronize with
 /// @return A non-null queue on success, `nullptr` otherwise.
 ///
-IOSDBlockRequestQueue* IOSDBlockRequestQueue::create(IOWorkLoop* workLoop)
+IOSDBlockRequestQueue* IOSDBlockRequestQueue::create()
 {
     auto queue = OSTypeAlloc(IOSDBlockRequestQueue);
     
@@ -31,7 +119,7 @@ IOSDBlockRequestQueue* IOSDBlockRequestQueue::create(IOWorkLoop* workLoop)
         return nullptr;
     }
     
-    if (!queue->initWithWorkLoop(workLoop))
+    if (!queue->init())
     {
         queue->release();
         
@@ -48,16 +136,82 @@ IOSDBlockRequestQueue* IOSDBlockRequestQueue::create(IOWorkLoop* workLoop)
 ///
 bool IOSDBlockRequestQueue::isEmpty()
 {
-    bool empty = false;
+    IOLockLock(this->consumerLock);
+    
+    bool empty = queue_empty(&this->pendingRequests) && this->submissions == nullptr;
+    
+    IOLockUnlock(this->consumerLock);
+    
+    return empty;
+}
+
+///
+/// Peek the block request that will be dequeued next
+///
+/// @return The block request at the head of the queue, `nullptr` if the queue is empty.
+/// @note The request remains in the queue.
+///
+IOSDBlockRequest* IOSDBlockRequestQueue::peekRequest()
+{
+    IOSDBlockRequest* request = nullptr;
+    
+    IOLockLock(this->consumerLock);
+    
+    this->collectSubmissions();
+    
+    if (!queue_empty(&this->pendingRequests))
+    {
+        request = OSDynamicCast(IOSDBlockRequest, reinterpret_cast<IOCommand*>(queue_first(&this->pendingRequests)));
+    }
+    
+    IOLockUnlock(this->consumerLock);
+    
+    return request;
+}
+
+///
+/// Enqueue the given block request
+///
+/// @param request A block request
+/// @return `true` if the queue had no submission that the consumer has not observed yet,
+///         in which case the caller must notify the consumer; `false` otherwise.
+/// @note This function is lock-free and can be invoked by multiple threads concurrently.
+///
+bool IOSDBlockRequestQueue::enqueueRequest(IOSDBlockRequest* request)
+{
+    IOSDBlockRequest* head = nullptr;
     
-    auto action = [&]() -> IOReturn
+    do
     {
-        empty = queue_empty(&this->fQueueHead);
+        head = this->submissions;
         
-        return kIOReturnSuccess;
-    };
+        request->fCommandChain.next = reinterpret_cast<queue_entry_t>(head);
+    }
+    while (!OSCompareAndSwapPtr(head, request, reinterpret_cast<void* volatile*>(&this->submissions)));
     
-    IOCommandGateRunAction(this->fSerializer, action);
+    return head == nullptr;
+}
+
+///
+/// Dequeue a block request
+///
+/// @return A non-null block request, `nullptr` if the queue is empty.
+/// @warning The calling thread will not be blocked waiting for a request.
+///
+IOSDBlockRequest* IOSDBlockRequestQueue::dequeueRequest()
+{
+    IOCommand* command = nullptr;
     
-    return empty;
+    IOLockLock(this->consumerLock);
+    
+    this->collectSubmissions();
+    
+    if (!queue_empty(&this->pendingRequests))
+    {
+        queue_remove_first(&this->pendingRequests, command, IOCommand*, fCommandChain);
+    }
+    
+    IOLockUnlock(this->consumerLock);
+    
+    return OSDynamicCast(IOSDBlockRequest, command);
 }
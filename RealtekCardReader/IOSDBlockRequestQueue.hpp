@@ -8,25 +8,67 @@
 #ifndef IOSDBlockRequestQueue_hpp
 #define IOSDBlockRequestQueue_hpp
 
-#include <IOKit/IOCommandPool.h>
+#include <IOKit/IOLocks.h>
 #include "IOSDBlockRequest.hpp"
+#include <kern/queue.h>
 
+///
 /// Represents a thread-safe queue of SD block requests
-class IOSDBlockRequestQueue: public IOCommandPool
+///
+/// @note The queue has multiple producers (i.e. threads that submit block requests) and a single consumer (i.e. the processor workloop).
+///       Producers push requests onto a lock-free list of submissions without taking any lock.
+///       The consumer moves submissions to a private list in their submission order before it accesses pending requests,
+///       so requests can still be peeked and dequeued by a predicate.
+/// @note Functions other than `enqueueRequest()` are consumer operations.
+///       They are serialized by a lock that producers never take,
+///       so that the host driver can recycle pending requests while the processor workloop is idle.
+///
+class IOSDBlockRequestQueue: public OSObject
 {
     /// Constructors & Destructors
     OSDeclareDefaultStructors(IOSDBlockRequestQueue);
     
-    using super = IOCommand;
+    using super = OSObject;
+    
+    ///
+    /// The list of requests submitted but not yet observed by the consumer
+    ///
+    /// @note Requests are linked in the reverse order of their submission via `IOCommand::fCommandChain.next`.
+    ///
+    IOSDBlockRequest* volatile submissions;
+    
+    /// The list of pending requests observed by the consumer in their submission order
+    queue_head_t pendingRequests;
+    
+    /// A lock that serializes consumer operations
+    IOLock* consumerLock;
+    
+    ///
+    /// [Helper] Move all submitted requests to the list of pending requests
+    ///
+    /// @note This function must be invoked with the consumer lock held.
+    ///
+    void collectSubmissions();
+    
+    ///
+    /// Initialize an empty queue
+    ///
+    /// @return `true` on success, `false` otherwise.
+    ///
+    bool init() override;
     
 public:
     ///
-    /// Create an empty queue protected by the given work loop
+    /// Release the queue
+    ///
+    void free() override;
+    
+    ///
+    /// Create an empty queue
     ///
-    /// @param workLoop The workloop that the queue should synchronize with
     /// @return A non-null queue on success, `nullptr` otherwise.
     ///
-    static IOSDBlockRequestQueue* create(IOWorkLoop* workLoop);
+    static IOSDBlockRequestQueue* create();
     
     ///
     /// Check whether the queue is empty
@@ -35,25 +77,104 @@ public:
     ///
     bool isEmpty();
     
+    ///
+    /// Peek the block request that will be dequeued next
+    ///
+    /// @return The block request at the head of the queue, `nullptr` if the queue is empty.
+    /// @note The request remains in the queue.
+    ///
+    IOSDBlockRequest* peekRequest();
+    
     ///
     /// Enqueue the given block request
     ///
     /// @param request A block request
+    /// @return `true` if the queue had no submission that the consumer has not observed yet,
+    ///         in which case the caller must notify the consumer; `false` otherwise.
+    /// @note This function is lock-free and can be invoked by multiple threads concurrently.
     ///
-    inline void enqueueRequest(IOSDBlockRequest* request)
-    {
-        this->returnCommand(request);
-    }
+    bool enqueueRequest(IOSDBlockRequest* request);
     
     ///
     /// Dequeue a block request
     ///
-    /// @return A non-null block request.
+    /// @return A non-null block request, `nullptr` if the queue is empty.
     /// @warning The calling thread will not be blocked waiting for a request.
     ///
-    inline IOSDBlockRequest* dequeueRequest()
+    IOSDBlockRequest* dequeueRequest();
+    
+    ///
+    /// Dequeue the first block request that satisfies the given predicate
+    ///
+    /// @param predicate A callable object that takes a non-null block request and returns `true` if the request should be dequeued
+    /// @return The block request that satisfies the given predicate, `nullptr` if no such request.
+    /// @note The predicate is invoked with the queue lock held, so it must not access the queue.
+    /// @warning The calling thread will not be blocked waiting for a request.
+    ///
+    template <typename Predicate>
+    IOSDBlockRequest* dequeueRequest(Predicate predicate)
+    {
+        IOSDBlockRequest* result = nullptr;
+        
+        IOLockLock(this->consumerLock);
+        
+        this->collectSubmissions();
+        
+        IOCommand* command;
+        
+        queue_iterate(&this->pendingRequests, command, IOCommand*, fCommandChain)
+        {
+            IOSDBlockRequest* request = OSDynamicCast(IOSDBlockRequest, command);
+            
+            if (request != nullptr && predicate(request))
+            {
+                queue_remove(&this->pendingRequests, command, IOCommand*, fCommandChain);
+                
+                result = request;
+                
+                break;
+            }
+        }
+        
+        IOLockUnlock(this->consumerLock);
+        
+        return result;
+    }
+    
+    ///
+    /// Check whether the queue contains a block request that satisfies the given predicate
+    ///
+    /// @param predicate A callable object that takes a non-null block request and returns `true` if the request matches
+    /// @return `true` if at least one pending request satisfies the given predicate, `false` otherwise.
+    /// @note The predicate is invoked with the queue lock held, so it must not access the queue.
+    ///       Requests remain in the queue.
+    ///
+    template <typename Predicate>
+    bool containsRequest(Predicate predicate)
     {
-        return OSDynamicCast(IOSDBlockRequest, this->getCommand(false));
+        bool result = false;
+        
+        IOLockLock(this->consumerLock);
+        
+        this->collectSubmissions();
+        
+        IOCommand* command;
+        
+        queue_iterate(&this->pendingRequests, command, IOCommand*, fCommandChain)
+        {
+            IOSDBlockRequest* request = OSDynamicCast(IOSDBlockRequest, command);
+            
+            if (request != nullptr && predicate(request))
+            {
+                result = true;
+                
+                break;
+            }
+        }
+        
+        IOLockUnlock(this->consumerLock);
+        
+        return result;
     }
 };
 
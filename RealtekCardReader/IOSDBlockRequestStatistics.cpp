@@ -0,0 +1,363 @@
+//
+//  IOSDBlockRequestStatistics.cpp
+//  RealtekCardReader
+//
+//  Created by FireWolf on 10/16/26.
+//
+
+#include "IOSDBlockRequestStatistics.hpp"
+#include <kern/clock.h>
+#include "OSDictionary.hpp"
+#include "Debug.hpp"
+
+/// The name of each size class
+static const char* kSizeClassNames[IOSDBlockRequestStatistics::kNumSizeClasses] = { "<=4K", "<=64K", "<=512K", ">512K" };
+
+//
+// MARK: - Entry
+//
+
+///
+/// Reset all statistics to zero
+///
+void IOSDBlockRequestStatistics::Entry::reset()
+{
+    this->numRequests = 0;
+    
+    this->numErrors = 0;
+    
+    this->numBytes = 0;
+    
+    this->totalLatency = 0;
+    
+    this->maxLatency = 0;
+    
+    bzero(this->latencyHistogram, sizeof(this->latencyHistogram));
+    
+    this->numTimeouts = 0;
+    
+    this->numSlowRequests = 0;
+    
+    this->maxTimeout = 0;
+    
+    this->counters.reset();
+}
+
+///
+/// Get an upper bound of the latency percentile
+///
+/// @param permille The percentile in permille, e.g. 500 for p50 and 999 for p99.9
+/// @return The upper bound of the bucket where the given percentile falls in microseconds, 0 if no request has been serviced.
+///
+UInt64 IOSDBlockRequestStatistics::Entry::getLatencyPercentile(UInt32 permille) const
+{
+    if (this->numRequests == 0)
+    {
+        return 0;
+    }
+    
+    // The rank of the request at the given percentile (rounded up)
+    UInt64 rank = (this->numRequests * permille + 999) / 1000;
+    
+    UInt64 count = 0;
+    
+    for (UInt32 index = 0; index < kNumLatencyBuckets; index += 1)
+    {
+        count += this->latencyHistogram[index];
+        
+        if (count >= rank)
+        {
+            return 1ULL << (index + 1);
+        }
+    }
+    
+    return this->maxLatency;
+}
+
+///
+/// Serialize the statistics into a dictionary
+///
+/// @return A non-null dictionary on success, `nullptr` otherwise.
+/// @note The dictionary contains the same fields as the kernel log, but the host-side work is reported in totals.
+/// @note The caller is responsible for releasing the returned dictionary.
+///
+OSDictionary* IOSDBlockRequestStatistics::Entry::serialize() const
+{
+    OSDictionary* dictionary = OSDictionary::withCapacity(17);
+    
+    if (dictionary != nullptr &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Requests", this->numRequests) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Errors", this->numErrors) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Bytes", this->numBytes) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Average Latency (us)", this->totalLatency / this->numRequests) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "P50 Latency (us)", this->getLatencyPercentile(500)) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "P99 Latency (us)", this->getLatencyPercentile(990)) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "P99.9 Latency (us)", this->getLatencyPercentile(999)) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Max Latency (us)", this->maxLatency) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Timeouts", this->numTimeouts) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Slow Requests", this->numSlowRequests) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Max Timeout (ms)", this->maxTimeout) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Register Accesses", this->counters.numRegisterAccesses) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Host Commands", this->counters.numHostCommands) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Command Transfers", this->counters.numCommandTransfers) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "DMA Transfers", this->counters.numDMATransfers) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Interrupts", this->counters.numInterrupts) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Polled Completions", this->counters.numPolledCompletions))
+    {
+        return dictionary;
+    }
+    
+    OSSafeReleaseNULL(dictionary);
+    
+    return nullptr;
+}
+
+//
+// MARK: - Collect Statistics
+//
+
+///
+/// Get the size class of a block request
+///
+/// @param nblocks The number of blocks to transfer
+/// @return The size class.
+///
+IOSDBlockRequestStatistics::SizeClass IOSDBlockRequestStatistics::getSizeClass(UInt64 nblocks)
+{
+    if (nblocks <= 8)
+    {
+        return kUpTo4KB;
+    }
+    
+    if (nblocks <= 128)
+    {
+        return kUpTo64KB;
+    }
+    
+    if (nblocks <= 1024)
+    {
+        return kUpTo512KB;
+    }
+    
+    return kLarger;
+}
+
+///
+/// Take a snapshot before the host driver services a block request
+///
+/// @param host A non-null host device that services the request
+/// @param snapshot The snapshot on return
+///
+void IOSDBlockRequestStatistics::takeSnapshot(IOSDHostDevice* host, Snapshot& snapshot)
+{
+    host->getTransferCounters(snapshot.counters);
+    
+    clock_get_uptime(&snapshot.timestamp);
+}
+
+///
+/// Record a block request that has been serviced
+///
+/// @param host A non-null host device that services the request
+/// @param snapshot The snapshot taken before the host driver services the request
+/// @param direction The transfer direction of the request
+/// @param nblocks The number of blocks to transfer
+/// @param status The service status of the request
+/// @param timeout The longest data timeout in milliseconds applied to a transaction of the request
+/// @param budget The sum of data timeouts in milliseconds applied to all transactions of the request
+/// @note Both timeouts are zero if the request has been serviced without a data transfer (e.g. by the read-ahead cache).
+///
+void IOSDBlockRequestStatistics::record(IOSDHostDevice* host, const Snapshot& snapshot, IODirection direction, UInt64 nblocks, IOReturn status, UInt32 timeout, UInt64 budget)
+{
+    // Calculate the latency
+    UInt64 now;
+    
+    UInt64 latency;
+    
+    clock_get_uptime(&now);
+    
+    absolutetime_to_nanoseconds(now - snapshot.timestamp, &latency);
+    
+    latency /= 1000;
+    
+    // Calculate the work performed by the host device
+    IOSDHostDevice::TransferCounters counters;
+    
+    host->getTransferCounters(counters);
+    
+    // Update the entry
+    Entry& entry = (direction == kIODirectionIn ? this->reads : this->writes)[IOSDBlockRequestStatistics::getSizeClass(nblocks)];
+    
+    entry.numRequests += 1;
+    
+    if (status == kIOReturnSuccess)
+    {
+        entry.numBytes += nblocks * 512;
+    }
+    else
+    {
+        entry.numErrors += 1;
+    }
+    
+    entry.totalLatency += latency;
+    
+    if (latency > entry.maxLatency)
+    {
+        entry.maxLatency = latency;
+    }
+    
+    UInt32 bucket = 0;
+    
+    while (bucket < kNumLatencyBuckets - 1 && (latency >> (bucket + 1)) != 0)
+    {
+        bucket += 1;
+    }
+    
+    entry.latencyHistogram[bucket] += 1;
+    
+    // Track how close requests come to their data timeout, so that overly tight timeouts can be told apart from real card failures
+    if (status == kIOReturnTimeout)
+    {
+        entry.numTimeouts += 1;
+    }
+    
+    if (budget != 0 && latency * 2 > budget * 1000)
+    {
+        entry.numSlowRequests += 1;
+    }
+    
+    if (timeout > entry.maxTimeout)
+    {
+        entry.maxTimeout = timeout;
+    }
+    
+    entry.counters.numRegisterAccesses += counters.numRegisterAccesses - snapshot.counters.numRegisterAccesses;
+    
+    entry.counters.numHostCommands += counters.numHostCommands - snapshot.counters.numHostCommands;
+    
+    entry.counters.numCommandTransfers += counters.numCommandTransfers - snapshot.counters.numCommandTransfers;
+    
+    entry.counters.numDMATransfers += counters.numDMATransfers - snapshot.counters.numDMATransfers;
+    
+    entry.counters.numInterrupts += counters.numInterrupts - snapshot.counters.numInterrupts;
+    
+    entry.counters.numPolledCompletions += counters.numPolledCompletions - snapshot.counters.numPolledCompletions;
+}
+
+///
+/// Reset all statistics to zero
+///
+void IOSDBlockRequestStatistics::reset()
+{
+    for (UInt32 index = 0; index < kNumSizeClasses; index += 1)
+    {
+        this->reads[index].reset();
+        
+        this->writes[index].reset();
+    }
+}
+
+///
+/// Print all statistics to the kernel log
+///
+/// @param title The title printed before the statistics
+///
+void IOSDBlockRequestStatistics::print(const char* title) const
+{
+    pmesg("%s: Latencies are in microseconds; Timeouts are in milliseconds; Other columns are per-request averages.", title);
+    
+    pmesg("DIR  SIZE    REQUESTS   ERRORS      BYTES    AVG    P50    P99   P999    MAX TMOUTS   SLOW  BUDGET   REGS   CMDS  XFERS   DMAS   IRQS  POLLS");
+    
+    for (UInt32 direction = 0; direction < 2; direction += 1)
+    {
+        const Entry* entries = direction == 0 ? this->reads : this->writes;
+        
+        for (UInt32 index = 0; index < kNumSizeClasses; index += 1)
+        {
+            const Entry& entry = entries[index];
+            
+            if (entry.numRequests == 0)
+            {
+                continue;
+            }
+            
+            pmesg("%s %-6s %10llu %8llu %10llu %6llu %6llu %6llu %6llu %6llu %6llu %6llu %7llu %6llu %6llu %6llu %6llu %6llu %6llu",
+                  direction == 0 ? "READ " : "WRITE",
+                  kSizeClassNames[index],
+                  entry.numRequests,
+                  entry.numErrors,
+                  entry.numBytes,
+                  entry.totalLatency / entry.numRequests,
+                  entry.getLatencyPercentile(500),
+                  entry.getLatencyPercentile(990),
+                  entry.getLatencyPercentile(999),
+                  entry.maxLatency,
+                  entry.numTimeouts,
+                  entry.numSlowRequests,
+                  entry.maxTimeout,
+                  entry.counters.numRegisterAccesses / entry.numRequests,
+                  entry.counters.numHostCommands / entry.numRequests,
+                  entry.counters.numCommandTransfers / entry.numRequests,
+                  entry.counters.numDMATransfers / entry.numRequests,
+                  entry.counters.numInterrupts / entry.numRequests,
+                  entry.counters.numPolledCompletions / entry.numRequests);
+        }
+    }
+}
+
+///
+/// Serialize all statistics into a dictionary that can be published in the I/O Registry
+///
+/// @return A non-null dictionary on success, `nullptr` otherwise.
+/// @note Directions and size classes without any request are omitted.
+/// @note The caller is responsible for releasing the returned dictionary.
+///
+OSDictionary* IOSDBlockRequestStatistics::serialize() const
+{
+    OSDictionary* dictionary = OSDictionary::withCapacity(2);
+    
+    if (dictionary == nullptr)
+    {
+        return nullptr;
+    }
+    
+    for (UInt32 direction = 0; direction < 2; direction += 1)
+    {
+        const Entry* entries = direction == 0 ? this->reads : this->writes;
+        
+        OSDictionary* classes = OSDictionary::withCapacity(kNumSizeClasses);
+        
+        if (classes == nullptr)
+        {
+            OSSafeReleaseNULL(dictionary);
+            
+            return nullptr;
+        }
+        
+        for (UInt32 index = 0; index < kNumSizeClasses; index += 1)
+        {
+            if (entries[index].numRequests == 0)
+            {
+                continue;
+            }
+            
+            OSDictionary* entry = entries[index].serialize();
+            
+            if (entry != nullptr)
+            {
+                classes->setObject(kSizeClassNames[index], entry);
+                
+                entry->release();
+            }
+        }
+        
+        if (classes->getCount() != 0)
+        {
+            dictionary->setObject(direction == 0 ? "Reads" : "Writes", classes);
+        }
+        
+        classes->release();
+    }
+    
+    return dictionary;
+}
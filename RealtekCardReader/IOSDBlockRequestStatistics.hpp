@@ -0,0 +1,174 @@
+//
+//  IOSDBlockRequestStatistics.hpp
+//  RealtekCardReader
+//
+//  Created by FireWolf on 10/16/26.
+//
+
+#ifndef IOSDBlockRequestStatistics_hpp
+#define IOSDBlockRequestStatistics_hpp
+
+#include <IOKit/IOTypes.h>
+#include <libkern/c++/OSDictionary.h>
+#include "IOSDHostDevice.hpp"
+
+/// IORegistry Keys
+static const char* kIOSDBlockRequestStatistics = "Block Request Statistics";
+static const char* kIOSDBlockRequestStatisticsOpenEnded = "Block Request Statistics (Open-ended Transfers)";
+
+///
+/// Statistics of block requests serviced by the host driver
+///
+/// @note Requests are grouped by their transfer direction and size class,
+///       so that the per-request overhead of small random accesses can be told apart from the one of large sequential accesses.
+/// @note Statistics are updated on the processor workloop only, so no extra synchronization is needed.
+///
+struct IOSDBlockRequestStatistics
+{
+    /// Enumerates all size classes of block requests
+    enum SizeClass: UInt32
+    {
+        /// Requests that transfer up to 4 KB
+        kUpTo4KB = 0,
+        
+        /// Requests that transfer up to 64 KB
+        kUpTo64KB = 1,
+        
+        /// Requests that transfer up to 512 KB
+        kUpTo512KB = 2,
+        
+        /// Requests that transfer more than 512 KB
+        kLarger = 3,
+        
+        /// The number of size classes
+        kNumSizeClasses = 4,
+    };
+    
+    ///
+    /// The number of buckets in the latency histogram
+    ///
+    /// @note The bucket `i` counts requests that complete in [2^i, 2^(i + 1)) microseconds,
+    ///       and the last bucket also counts all requests that take longer.
+    ///
+    static constexpr UInt32 kNumLatencyBuckets = 24;
+    
+    /// The state captured right before the host driver starts to service a block request
+    struct Snapshot
+    {
+        /// The time when the service starts (in absolute time units)
+        UInt64 timestamp;
+        
+        /// Counters of the work performed by the host device so far
+        IOSDHostDevice::TransferCounters counters;
+    };
+    
+    /// Statistics of block requests that share the same direction and size class
+    struct Entry
+    {
+        /// The number of requests serviced
+        UInt64 numRequests;
+        
+        /// The number of requests that failed
+        UInt64 numErrors;
+        
+        /// The number of bytes transferred by successful requests
+        UInt64 numBytes;
+        
+        /// The total latency in microseconds
+        UInt64 totalLatency;
+        
+        /// The maximum latency in microseconds
+        UInt64 maxLatency;
+        
+        /// A histogram of latencies on a log2 scale
+        UInt64 latencyHistogram[kNumLatencyBuckets];
+        
+        /// The number of requests that failed due to a timeout
+        UInt64 numTimeouts;
+        
+        /// The number of requests that took longer than half of the sum of data timeouts applied to their transactions
+        UInt64 numSlowRequests;
+        
+        /// The maximum data timeout in milliseconds applied to a single transaction
+        UInt64 maxTimeout;
+        
+        /// The total work performed by the host device to service these requests
+        IOSDHostDevice::TransferCounters counters;
+        
+        /// Reset all statistics to zero
+        void reset();
+        
+        ///
+        /// Get an upper bound of the latency percentile
+        ///
+        /// @param permille The percentile in permille, e.g. 500 for p50 and 999 for p99.9
+        /// @return The upper bound of the bucket where the given percentile falls in microseconds, 0 if no request has been serviced.
+        ///
+        UInt64 getLatencyPercentile(UInt32 permille) const;
+        
+        ///
+        /// Serialize the statistics into a dictionary
+        ///
+        /// @return A non-null dictionary on success, `nullptr` otherwise.
+        /// @note The caller is responsible for releasing the returned dictionary.
+        ///
+        OSDictionary* serialize() const;
+    };
+    
+    /// Statistics of read requests indexed by the size class
+    Entry reads[kNumSizeClasses];
+    
+    /// Statistics of write requests indexed by the size class
+    Entry writes[kNumSizeClasses];
+    
+    ///
+    /// Get the size class of a block request
+    ///
+    /// @param nblocks The number of blocks to transfer
+    /// @return The size class.
+    ///
+    static SizeClass getSizeClass(UInt64 nblocks);
+    
+    ///
+    /// Take a snapshot before the host driver services a block request
+    ///
+    /// @param host A non-null host device that services the request
+    /// @param snapshot The snapshot on return
+    ///
+    static void takeSnapshot(IOSDHostDevice* host, Snapshot& snapshot);
+    
+    ///
+    /// Record a block request that has been serviced
+    ///
+    /// @param host A non-null host device that services the request
+    /// @param snapshot The snapshot taken before the host driver services the request
+    /// @param direction The transfer direction of the request
+    /// @param nblocks The number of blocks to transfer
+    /// @param status The service status of the request
+    /// @param timeout The longest data timeout in milliseconds applied to a transaction of the request
+    /// @param budget The sum of data timeouts in milliseconds applied to all transactions of the request
+    /// @note Both timeouts are zero if the request has been serviced without a data transfer (e.g. by the read-ahead cache).
+    ///
+    void record(IOSDHostDevice* host, const Snapshot& snapshot, IODirection direction, UInt64 nblocks, IOReturn status, UInt32 timeout, UInt64 budget);
+    
+    /// Reset all statistics to zero
+    void reset();
+    
+    ///
+    /// Print all statistics to the kernel log
+    ///
+    /// @param title The title printed before the statistics
+    ///
+    void print(const char* title) const;
+    
+    ///
+    /// Serialize all statistics into a dictionary that can be published in the I/O Registry
+    ///
+    /// @return A non-null dictionary on success, `nullptr` otherwise.
+    /// @note Directions and size classes without any request are omitted.
+    /// @note The caller is responsible for releasing the returned dictionary.
+    ///
+    OSDictionary* serialize() const;
+};
+
+#endif /* IOSDBlockRequestStatistics_hpp */
@@ -7,6 +7,7 @@
 
 #include "IOSDBlockStorageDevice.hpp"
 #include <IOKit/storage/IOBlockStorageDriver.h>
+#include <IOKit/storage/IOStorageDeviceCharacteristics.h>
 
 //
 // MARK: - Meta Class Definitions
@@ -76,6 +77,39 @@ bool IOSDBlockStorageDevice::fetchCardCharacteristics()
     return true;
 }
 
+///
+/// Publish the storage features supported by the current card
+///
+/// @note The unmap feature is advertised only if the card supports erase commands.
+///
+void IOSDBlockStorageDevice::publishStorageFeatures()
+{
+    bool supportsErase = false;
+    
+    if (this->driver->isCardEraseSupported(supportsErase) != kIOReturnSuccess)
+    {
+        pinfo("The card is not present. Will not advertise the unmap feature.");
+    }
+    
+    OSDictionary* features = OSDictionary::withCapacity(1);
+    
+    if (features == nullptr)
+    {
+        perr("Failed to allocate the dictionary of storage features.");
+        
+        return;
+    }
+    
+    // The file system reports freed blocks to the card only if the card can erase them
+    features->setObject(kIOStorageFeatureUnmap, supportsErase ? kOSBooleanTrue : kOSBooleanFalse);
+    
+    this->setProperty(kIOStorageFeaturesKey, features);
+    
+    features->release();
+    
+    pinfo("The unmap feature is %s.", supportsErase ? "advertised" : "not advertised");
+}
+
 //
 // MARK: - Card Events
 //
@@ -114,6 +148,8 @@ IOReturn IOSDBlockStorageDevice::message(UInt32 type, IOService* provider, void*
             
             psoftassert(this->fetchCardCharacteristics(), "Failed to fetch characteristics of the card inserted.");
             
+            this->publishStorageFeatures();
+            
             break;
         }
             
@@ -409,6 +445,99 @@ IOReturn IOSDBlockStorageDevice::doAsyncReadWrite(IOMemoryDescriptor* buffer, UI
     }
 }
 
+///
+/// Delete unused data from the media
+///
+/// @param extents A non-null list of extents to be unmapped
+/// @param extentsCount The number of extents in the list
+/// @param options Options of the unmap operation
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Adjacent extents are coalesced, so that the card receives as few erase sequences as possible.
+/// @seealso `IOBlockStorageDriver::unmap()`.
+///
+IOReturn IOSDBlockStorageDevice::doUnmap(IOBlockStorageDeviceExtent* extents, UInt32 extentsCount, IOStorageUnmapOptions options)
+{
+    pinfo("The storage subsystem requests to unmap %u extents.", extentsCount);
+    
+    // Guard: Reject the request if the block device has been terminated
+    if (this->isInactive())
+    {
+        perr("The block storage device has been terminated.");
+        
+        return kIOReturnNotAttached;
+    }
+    
+    UInt32 index = 0;
+    
+    while (index < extentsCount)
+    {
+        UInt64 block = extents[index].blockStart;
+        
+        UInt64 nblocks = extents[index].blockCount;
+        
+        // Coalesce the following extents that are adjacent to or overlap the current range
+        for (index += 1; index < extentsCount; index += 1)
+        {
+            const IOBlockStorageDeviceExtent& next = extents[index];
+            
+            if (next.blockStart < block || next.blockStart > block + nblocks)
+            {
+                break;
+            }
+            
+            if (next.blockStart + next.blockCount > block + nblocks)
+            {
+                nblocks = next.blockStart + next.blockCount - block;
+            }
+        }
+        
+        // Guard: Ensure that the range does not exceed the card capacity
+        if (nblocks == 0 || block + nblocks > this->numBlocks)
+        {
+            perr("The extent [%llu, %llu) is invalid.", block, block + nblocks);
+            
+            return kIOReturnBadArgument;
+        }
+        
+        IOReturn retVal = this->driver->discardBlocks(block, nblocks);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to discard %llu blocks from the block at %llu. Error = 0x%x.", nblocks, block, retVal);
+            
+            return retVal;
+        }
+    }
+    
+    return kIOReturnSuccess;
+}
+
+///
+/// Flush the cache of the media
+///
+/// @param block The starting block number of the range to be flushed
+/// @param nblks The number of blocks in the range (0 if the entire media should be flushed)
+/// @param options Options of the synchronize operation
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note The card flushes its entire cache regardless of the given range.
+/// @note The storage subsystem also invokes this function to emulate writes with the FUA (force unit access) attribute.
+/// @seealso `IOBlockStorageDriver::synchronize()`.
+///
+IOReturn IOSDBlockStorageDevice::doSynchronize(UInt64 block, UInt64 nblks, IOStorageSynchronizeOptions options)
+{
+    pinfo("The storage subsystem requests to synchronize %llu blocks from the block at %llu. Options = 0x%x.", nblks, block, options);
+    
+    // Guard: Reject the request if the block device has been terminated
+    if (this->isInactive())
+    {
+        perr("The block storage device has been terminated.");
+        
+        return kIOReturnNotAttached;
+    }
+    
+    return this->driver->flushCardCache();
+}
+
 //
 // MARK: - IOService Implementations
 //
@@ -444,6 +573,9 @@ bool IOSDBlockStorageDevice::start(IOService* provider)
     
     this->driver->retain();
     
+    // Advertise the unmap feature if the card present now supports erase commands
+    this->publishStorageFeatures();
+    
     // Publish the service to start the storage subsystem
     this->registerService();
     
@@ -60,6 +60,13 @@ private:
     ///
     bool fetchCardCharacteristics();
     
+    ///
+    /// Publish the storage features supported by the current card
+    ///
+    /// @note The unmap feature is advertised only if the card supports erase commands.
+    ///
+    void publishStorageFeatures();
+    
     //
     // MARK: - Card Events
     //
@@ -205,6 +212,31 @@ public:
     ///
     IOReturn doAsyncReadWrite(IOMemoryDescriptor* buffer, UInt64 block, UInt64 nblks, IOStorageAttributes* attributes, IOStorageCompletion* completion) override;
     
+    ///
+    /// Delete unused data from the media
+    ///
+    /// @param extents A non-null list of extents to be unmapped
+    /// @param extentsCount The number of extents in the list
+    /// @param options Options of the unmap operation
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Adjacent extents are coalesced, so that the card receives as few erase sequences as possible.
+    /// @seealso `IOBlockStorageDriver::unmap()`.
+    ///
+    IOReturn doUnmap(IOBlockStorageDeviceExtent* extents, UInt32 extentsCount, IOStorageUnmapOptions options = 0) override;
+    
+    ///
+    /// Flush the cache of the media
+    ///
+    /// @param block The starting block number of the range to be flushed
+    /// @param nblks The number of blocks in the range (0 if the entire media should be flushed)
+    /// @param options Options of the synchronize operation
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note The card flushes its entire cache regardless of the given range.
+    /// @note The storage subsystem also invokes this function to emulate writes with the FUA (force unit access) attribute.
+    /// @seealso `IOBlockStorageDriver::synchronize()`.
+    ///
+    IOReturn doSynchronize(UInt64 block, UInt64 nblks, IOStorageSynchronizeOptions options = 0) override;
+    
     //
     // MARK: - IOService Implementations
     //
@@ -524,6 +524,44 @@ struct CSD
         35, 40, 45, 50, 55, 60, 70, 80, // 3.5 - 8.0x
     };
     
+    ///
+    /// Get the maximum amount of time for the card to start sending a block or to finish programming a block
+    ///
+    /// @param direction `kIODirectionIn` for reads or `kIODirectionOut` for writes
+    /// @param clock The current bus clock in Hz
+    /// @return The data access timeout in microseconds.
+    /// @note Port: This function replaces the SD portion of `mmc_set_data_timeout()` defined in `core.c`.
+    ///       The typical access time specified by TAAC and NSAC is multiplied by 100 (and by 2^R2W_FACTOR for writes),
+    ///       and is limited to 100 ms for reads as per the SD specification and to 3 seconds for writes as Linux does,
+    ///       since many cards exceed the 250 ms (SDSC/SDHC) or 500 ms (SDXC) write timeout specified by the SD specification.
+    ///       Block-addressed cards always use these limits, since their TAAC and NSAC fields are fixed values.
+    ///
+    inline UInt32 getDataAccessTimeout(IODirection direction, UInt32 clock) const
+    {
+        UInt32 limit = direction == kIODirectionIn ? 100000 : 3000000;
+        
+        if (this->isBlockAddressed)
+        {
+            return limit;
+        }
+        
+        UInt64 multiplier = 100;
+        
+        if (direction != kIODirectionIn)
+        {
+            multiplier <<= this->writeSpeedFactor;
+        }
+        
+        UInt64 timeout = static_cast<UInt64>(this->taacTimeNanosecs) * multiplier / 1000;
+        
+        if (clock != 0)
+        {
+            timeout += static_cast<UInt64>(this->taacTimeClocks) * multiplier * 1000000 / clock;
+        }
+        
+        return timeout > limit ? limit : static_cast<UInt32>(timeout);
+    }
+    
     ///
     /// Decode from the given raw data
     ///
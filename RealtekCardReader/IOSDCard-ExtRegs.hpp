@@ -0,0 +1,199 @@
+//
+//  IOSDCard-ExtRegs.hpp
+//  RealtekCardReader
+//
+//  Created by FireWolf on 10/16/26.
+//
+
+#ifndef IOSDCard_ExtRegs_hpp
+#define IOSDCard_ExtRegs_hpp
+
+#include "Utilities.hpp"
+
+///
+/// The address of an extension register set accessed via CMD48 and CMD49
+///
+/// @note Port: This struct replaces the `fno`, `page` and `offset` fields of `sd_ext_reg` defined in `card.h`.
+///
+struct ExtensionRegister
+{
+    /// The function number
+    UInt8 fno;
+    
+    /// The page number
+    UInt8 page;
+    
+    /// The offset of the register set in the page
+    UInt16 offset;
+    
+    ///
+    /// Get the argument of CMD48 or CMD49 that accesses the register at the given offset
+    ///
+    /// @param position The offset of the register relative to the start of this register set
+    /// @param length The number of bytes to read (CMD48) or 1 (CMD49)
+    /// @return The command argument.
+    /// @note Port: This function replaces the argument calculation in `sd_read_ext_reg()` and `sd_write_ext_reg()` defined in `sd_ops.c`.
+    ///
+    inline UInt32 getCommandArgument(UInt32 position, UInt32 length) const
+    {
+        // The 17-bit address consists of the page number and the offset in the page
+        UInt32 address = (static_cast<UInt32>(this->page) << 9) + this->offset + position;
+        
+        return static_cast<UInt32>(this->fno) << 27 | (address & 0x1FFFF) << 9 | ((length - 1) & 0x1FF);
+    }
+};
+
+///
+/// The general information of extension registers (512 bytes)
+///
+/// @note Only the revision 0 is supported, so the driver parses at most 512 bytes.
+///
+struct ExtensionGeneralInfo
+{
+    /// The address of the general information
+    static constexpr ExtensionRegister kAddress = { 0, 0, 0 };
+    
+    /// The standard function code of the power management function
+    static constexpr UInt16 kPowerManagement = 0x0001;
+    
+    /// The standard function code of the performance enhancement function
+    static constexpr UInt16 kPerformanceEnhancement = 0x0002;
+    
+    ///
+    /// Find the register set of the given standard function
+    ///
+    /// @param data An array of 512 bytes returned by the CMD48 that reads the general information
+    /// @param sfc The standard function code
+    /// @param preg The address of the register set on return
+    /// @return `true` if the card supports the given function, `false` otherwise.
+    /// @note Port: This function replaces `sd_read_ext_regs()` and `sd_parse_ext_reg()` defined in `sd.c`.
+    ///
+    static bool find(const UInt8* data, UInt16 sfc, ExtensionRegister& preg)
+    {
+        UInt16 revision = data[0] | data[1] << 8;
+        
+        UInt16 length = data[2] | data[3] << 8;
+        
+        UInt8 numExtensions = data[4];
+        
+        if (revision != 0 || length > 512)
+        {
+            perr("Unsupported general information: Revision = %u; Length = %u.", revision, length);
+            
+            return false;
+        }
+        
+        // The first extension starts immediately after the 16-byte header
+        UInt32 address = 16;
+        
+        for (UInt8 index = 0; index < numExtensions; index += 1)
+        {
+            // Each extension is followed by the description of its first register set (48 bytes in total)
+            if (address > 464)
+            {
+                perr("The extension %u at 0x%x exceeds the general information.", index, address);
+                
+                return false;
+            }
+            
+            UInt16 code = data[address] | data[address + 1] << 8;
+            
+            UInt32 next = data[address + 40] | data[address + 41] << 8;
+            
+            UInt8 numRegisters = data[address + 42];
+            
+            UInt32 reg = data[address + 44] | data[address + 45] << 8 | data[address + 46] << 16 | static_cast<UInt32>(data[address + 47]) << 24;
+            
+            pinfo("Extension %u: SFC = 0x%04x; Number of Registers = %u; Register Address = 0x%08x.", index, code, numRegisters, reg);
+            
+            // Standard functions define only one register set
+            if (code == sfc && numRegisters == 1)
+            {
+                preg.offset = reg & 0x1FF;
+                
+                preg.page = (reg >> 9) & 0xFF;
+                
+                preg.fno = (reg >> 18) & 0x0F;
+                
+                return true;
+            }
+            
+            address = next;
+        }
+        
+        return false;
+    }
+};
+
+///
+/// The register set of the performance enhancement function (512 bytes)
+///
+/// @note Port: This struct replaces `sd_ext_reg` and `sd_parse_ext_reg_perf()` defined in `card.h` and `sd.c`.
+///
+struct PerformanceEnhancement
+{
+    /// The offset of the register that enables the cache
+    static constexpr UInt32 kCacheEnable = 260;
+    
+    /// The offset of the register that flushes the cache
+    static constexpr UInt32 kFlushCache = 261;
+    
+    /// The offset of the register that enables the command queue
+    static constexpr UInt32 kCommandQueueMode = 262;
+    
+    /// The address of the register set
+    ExtensionRegister address;
+    
+    /// The revision of the register set
+    UInt8 revision;
+    
+    /// `True` if the card supports the function extension event
+    bool supportsFXEvent;
+    
+    /// `True` if the card supports the card initiated self-maintenance
+    bool supportsCardMaintenance;
+    
+    /// `True` if the card supports the host initiated self-maintenance
+    bool supportsHostMaintenance;
+    
+    /// `True` if the card supports the volatile cache
+    bool supportsCache;
+    
+    /// The number of tasks the command queue can hold (0 if the command queue is not supported)
+    UInt8 commandQueueDepth;
+    
+    ///
+    /// Decode from the given raw data
+    ///
+    /// @param data An array of 512 bytes returned by the CMD48 that reads the register set
+    /// @param address The address of the register set
+    /// @param pper The parsed register set on return
+    /// @return `true` on success, `false` otherwise.
+    ///
+    static bool decode(const UInt8* data, const ExtensionRegister& address, PerformanceEnhancement& pper)
+    {
+        pper.address = address;
+        
+        pper.revision = data[0];
+        
+        pper.supportsFXEvent = data[1] & 0x01;
+        
+        pper.supportsCardMaintenance = data[2] & 0x01;
+        
+        pper.supportsHostMaintenance = data[2] & 0x02;
+        
+        pper.supportsCache = data[4] & 0x01;
+        
+        // The field stores the queue depth minus one, and 0 indicates that the command queue is not supported
+        UInt8 depth = data[6] & 0x1F;
+        
+        pper.commandQueueDepth = depth == 0 ? 0 : depth + 1;
+        
+        pinfo("Performance Enhancement: Revision = %u; FX Event = %d; Maintenance (Card/Host) = %d/%d; Cache = %d; Queue Depth = %u.",
+              pper.revision, pper.supportsFXEvent, pper.supportsCardMaintenance, pper.supportsHostMaintenance, pper.supportsCache, pper.commandQueueDepth);
+        
+        return true;
+    }
+};
+
+#endif /* IOSDCard_ExtRegs_hpp */
@@ -134,10 +134,23 @@ struct PACKED SCR
         pscr.spec4                = (data[2] & 0x04) >> 2;
         pscr.spec5                = (data[2] & 0x03) << 2;
         pscr.spec5               |= (data[3] & 0xC0) >> 6;
-        pscr.supportsCMD5859      = (data[3] & 0x0F) >> 3;
-        pscr.supportsCMD4849      = (data[3] & 0x0F) >> 2;
-        pscr.supportsCMD23        = (data[3] & 0x0F) >> 1;
-        pscr.supportsCMD20        = (data[3] & 0x0F) >> 0;
+        
+        // The command support bits are defined since the version 3.00
+        // Cards that comply with earlier versions may leave garbage in these reserved bits
+        if (pscr.spec3)
+        {
+            pscr.supportsCMD5859  = (data[3] & 0x08) >> 3;
+            pscr.supportsCMD4849  = (data[3] & 0x04) >> 2;
+            pscr.supportsCMD23    = (data[3] & 0x02) >> 1;
+            pscr.supportsCMD20    = (data[3] & 0x01) >> 0;
+        }
+        else
+        {
+            pscr.supportsCMD5859  = false;
+            pscr.supportsCMD4849  = false;
+            pscr.supportsCMD23    = false;
+            pscr.supportsCMD20    = false;
+        }
         
         return true;
     }
@@ -100,18 +100,166 @@ struct PACKED SSR
     ///
     static bool decode(const UInt8* data, SSR& pssr)
     {
-        // Note that the driver needs the speed classes only at this moment
+        // The register value is transferred in big endian, i.e. `data[0]` contains the bits [511:504]
+        pssr.busWidth = (data[0] & 0xC0) >> 6;
+        
+        pssr.securedMode = data[0] & 0x20;
+        
+        pssr.cardType = static_cast<UInt16>(data[2] << 8 | data[3]);
+        
+        pssr.protectedAreaSize = static_cast<UInt32>(data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7]);
+        
         pssr.speedClass = data[8];
         
+        pssr.movePerformance = data[9];
+        
+        pssr.auSize = (data[10] & 0xF0) >> 4;
+        
+        pssr.eraseSize = static_cast<UInt16>(data[11] << 8 | data[12]);
+        
+        pssr.eraseTimeout = (data[13] & 0xFC) >> 2;
+        
+        pssr.eraseOffset = data[13] & 0x03;
+        
         pssr.uhsSpeedGrade = (data[14] & 0xF0) >> 4;
         
+        pssr.uhsAuSize = data[14] & 0x0F;
+        
         pssr.videoSpeedClass = data[15];
         
-        pinfo("Speed Class = %d; UHS Speed Grade = %d; Video Speed Class = %d.",
-              pssr.speedClass, pssr.uhsSpeedGrade, pssr.videoSpeedClass);
+        pssr.vscAuSize = static_cast<UInt16>((data[16] & 0x03) << 8 | data[17]);
+        
+        pssr.suspensionAddress = static_cast<UInt32>(data[18] << 14 | data[19] << 6 | data[20] >> 2);
+        
+        pssr.appPerformanceClass = data[21] & 0x0F;
+        
+        pssr.performanceEnhance = data[22];
+        
+        pssr.supportsDiscard = data[24] & 0x02;
+        
+        pssr.supportsFULE = data[24] & 0x01;
+        
+        pinfo("Speed Class = %d; UHS Speed Grade = %d; Video Speed Class = %d; Application Performance Class = %d.",
+              pssr.speedClass, pssr.uhsSpeedGrade, pssr.videoSpeedClass, pssr.appPerformanceClass);
+        
+        pinfo("AU Size = %d; UHS AU Size = %d; VSC AU Size = %d MB.", pssr.auSize, pssr.uhsAuSize, pssr.vscAuSize);
+        
+        pinfo("Erase Size = %d; Erase Timeout = %d; Erase Offset = %d; Discard = %d.",
+              pssr.eraseSize, pssr.eraseTimeout, pssr.eraseOffset, pssr.supportsDiscard);
         
         return true;
     }
+    
+    ///
+    /// Convert the given encoded size of an allocation unit to the number of blocks
+    ///
+    /// @param value The value of the field `AU_SIZE` or `UHS_AU_SIZE`
+    /// @return The number of 512-byte blocks in an allocation unit, 0 if the size is not defined.
+    ///
+    static inline UInt32 decodeAUSize(UInt8 value)
+    {
+        // 12MB, 16MB, 24MB, 32MB and 64MB in number of blocks
+        static constexpr UInt32 kLargeAUSizes[] = { 24576, 32768, 49152, 65536, 131072 };
+        
+        if (value == 0)
+        {
+            return 0;
+        }
+        
+        // 16KB, 32KB, ..., 8MB
+        if (value <= 0x0A)
+        {
+            return 32 << (value - 1);
+        }
+        
+        return kLargeAUSizes[value - 0x0B];
+    }
+    
+    ///
+    /// Get the size of an allocation unit
+    ///
+    /// @return The number of 512-byte blocks in an allocation unit, 0 if the card does not define the size.
+    ///
+    inline UInt32 getAUSize() const
+    {
+        return SSR::decodeAUSize(this->auSize);
+    }
+    
+    ///
+    /// Get the size of an allocation unit that the card uses in the UHS-I mode
+    ///
+    /// @return The number of 512-byte blocks in an allocation unit, 0 if the card does not define the size.
+    ///
+    inline UInt32 getUHSAUSize() const
+    {
+        return SSR::decodeAUSize(this->uhsAuSize);
+    }
+    
+    ///
+    /// Get the size of an allocation unit that the card uses for the video speed class
+    ///
+    /// @return The number of 512-byte blocks in an allocation unit, 0 if the card does not support the video speed class.
+    ///
+    inline UInt32 getVSCAUSize() const
+    {
+        // The field is specified in MB
+        return static_cast<UInt32>(this->vscAuSize) * 2048;
+    }
+    
+    ///
+    /// Get the size of an allocation unit that the host should align sequential writes to
+    ///
+    /// @return The number of 512-byte blocks in an allocation unit, 0 if the card does not define the size.
+    /// @note The speed classes are measured by writing whole allocation units.
+    ///       UHS-I cards report a separate size that takes precedence over the one defined by the original speed classes.
+    ///
+    inline UInt32 getWriteAlignment() const
+    {
+        UInt32 size = this->getUHSAUSize();
+        
+        return size != 0 ? size : this->getAUSize();
+    }
+    
+    ///
+    /// Check whether the card meets the application performance class 2
+    ///
+    /// @return `true` if the card is A2 compliant, `false` otherwise.
+    /// @note A2 cards must support the command queue and the cache defined by the performance enhancement function.
+    ///
+    inline bool isA2Compliant() const
+    {
+        return this->appPerformanceClass >= 2;
+    }
+    
+    ///
+    /// Get the amount of time to erase the given number of allocation units
+    ///
+    /// @param numAUs The number of allocation units to be erased
+    /// @return The erase timeout in milliseconds (at least 1 second).
+    /// @note Port: This function replaces `mmc_sd_erase_timeout()` defined in `core.c`.
+    ///       The timeout is `eraseTimeout / eraseSize * numAUs + eraseOffset` seconds if the card specifies these parameters,
+    ///       otherwise the driver assumes 250 ms per allocation unit.
+    ///
+    inline UInt32 getEraseTimeout(UInt32 numAUs) const
+    {
+        UInt64 timeout;
+        
+        if (this->eraseSize != 0 && this->eraseTimeout != 0)
+        {
+            timeout = static_cast<UInt64>(this->eraseTimeout) * 1000 * numAUs / this->eraseSize + this->eraseOffset * 1000;
+        }
+        else
+        {
+            timeout = static_cast<UInt64>(numAUs) * 250;
+        }
+        
+        if (timeout < 1000)
+        {
+            timeout = 1000;
+        }
+        
+        return timeout > UINT32_MAX ? UINT32_MAX : static_cast<UInt32>(timeout);
+    }
 };
 
 static_assert(sizeof(SSR) == 64, "SSR should be 64 bytes long.");
@@ -75,7 +75,9 @@ OSDictionaryPtr IOSDCard::getCardCharacteristics() const
         OSDictionaryAddDataToDictionary(dictionary, "Application ID", &this->cid.oem, sizeof(this->cid.oem)) &&
         OSDictionaryAddDataToDictionary(dictionary, "Speed Class", &this->ssr.speedClass, sizeof(this->ssr.speedClass)) &&
         OSDictionaryAddIntegerToDictionary(dictionary, "UHS Speed Grade", this->ssr.uhsSpeedGrade) &&
-        OSDictionaryAddIntegerToDictionary(dictionary, "Video Speed Class", this->ssr.videoSpeedClass))
+        OSDictionaryAddIntegerToDictionary(dictionary, "Video Speed Class", this->ssr.videoSpeedClass) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Application Performance Class", this->ssr.appPerformanceClass) &&
+        OSDictionaryAddIntegerToDictionary(dictionary, "Allocation Unit Size", this->ssr.getWriteAlignment() * 512))
     {
         return dictionary;
     }
@@ -724,6 +726,94 @@ bool IOSDCard::setUHSBusSpeedMode(SwitchCaps::BusSpeed busSpeed)
     return true;
 }
 
+///
+/// [Helper] Enable the cache and the command queue if the card supports the performance enhancement function
+///
+/// @note Port: This function replaces `sd_read_ext_regs()` and `sd_enable_cache()` defined in `sd.c`.
+/// @note This function is invoked once the card has been initialized at the selected speed mode.
+///       Failures are not fatal, since the card remains fully functional without these features.
+///
+void IOSDCard::initPerformanceEnhancement()
+{
+    this->cacheEnabled = false;
+    
+    this->commandQueueDepth = 0;
+    
+    pinfo("The card is %sA2 compliant. Application Performance Class = %u.", this->ssr.isA2Compliant() ? "" : "not ", this->ssr.appPerformanceClass);
+    
+    // Guard: Check whether the card supports extension registers
+    if (!this->scr.supportsCMD4849)
+    {
+        pinfo("The card does not support the CMD48 and the CMD49.");
+        
+        return;
+    }
+    
+    // Guard: Find the performance enhancement function
+    UInt8 data[512] = {};
+    
+    ExtensionRegister address;
+    
+    if (this->driver->CMD48(ExtensionGeneralInfo::kAddress.getCommandArgument(0, sizeof(data)), data) != kIOReturnSuccess)
+    {
+        perr("Failed to read the general information of extension registers.");
+        
+        return;
+    }
+    
+    if (!ExtensionGeneralInfo::find(data, ExtensionGeneralInfo::kPerformanceEnhancement, address))
+    {
+        pinfo("The card does not support the performance enhancement function.");
+        
+        return;
+    }
+    
+    // Guard: Read the register set of the performance enhancement function
+    if (this->driver->CMD48(address.getCommandArgument(0, sizeof(data)), data) != kIOReturnSuccess)
+    {
+        perr("Failed to read the register set of the performance enhancement function.");
+        
+        return;
+    }
+    
+    if (!PerformanceEnhancement::decode(data, address, this->performanceEnhancement))
+    {
+        perr("Failed to decode the register set of the performance enhancement function.");
+        
+        return;
+    }
+    
+    // Enable the cache if the card supports it
+    if (this->performanceEnhancement.supportsCache && !UserConfigs::Card::NoCardCache)
+    {
+        if (this->driver->writeExtensionRegister(address, PerformanceEnhancement::kCacheEnable, 0x01) == kIOReturnSuccess)
+        {
+            pinfo("The card cache has been enabled.");
+            
+            this->cacheEnabled = true;
+        }
+        else
+        {
+            perr("Failed to enable the card cache.");
+        }
+    }
+    
+    // Enable the command queue if the card supports it and the user requests it
+    if (this->performanceEnhancement.commandQueueDepth > 1 && UNLIKELY(UserConfigs::Card::EnableCommandQueue))
+    {
+        if (this->driver->writeExtensionRegister(address, PerformanceEnhancement::kCommandQueueMode, 0x01) == kIOReturnSuccess)
+        {
+            pinfo("The command queue has been enabled. Queue depth = %u.", this->performanceEnhancement.commandQueueDepth);
+            
+            this->commandQueueDepth = this->performanceEnhancement.commandQueueDepth;
+        }
+        else
+        {
+            perr("Failed to enable the command queue.");
+        }
+    }
+}
+
 ///
 /// [Helper] Initialize the card at the default speed mode
 ///
@@ -739,7 +829,14 @@ IOReturn IOSDCard::initializeCardAtDefaultSpeedMode(SpeedMode& speedMode)
 {
     speedMode = SpeedMode::kDefaultSpeed;
     
-    return this->initDefaultSpeedMode() ? kIOReturnSuccess : kIOReturnNotResponding;
+    if (!this->initDefaultSpeedMode())
+    {
+        return kIOReturnNotResponding;
+    }
+    
+    this->initPerformanceEnhancement();
+    
+    return kIOReturnSuccess;
 }
 
 ///
@@ -757,7 +854,14 @@ IOReturn IOSDCard::initializeCardAtHighSpeedMode(SpeedMode& speedMode)
 {
     speedMode = SpeedMode::kHighSpeed;
     
-    return this->initHighSpeedMode() ? kIOReturnSuccess : kIOReturnNotResponding;
+    if (!this->initHighSpeedMode())
+    {
+        return kIOReturnNotResponding;
+    }
+    
+    this->initPerformanceEnhancement();
+    
+    return kIOReturnSuccess;
 }
 
 ///
@@ -775,7 +879,14 @@ IOReturn IOSDCard::initializeCardAtUltraHighSpeedMode(SpeedMode& speedMode)
 {
     speedMode = SpeedMode::kUltraHighSpeed;
     
-    return this->initUltraHighSpeedMode() ? kIOReturnSuccess : kIOReturnNotResponding;
+    if (!this->initUltraHighSpeedMode())
+    {
+        return kIOReturnNotResponding;
+    }
+    
+    this->initPerformanceEnhancement();
+    
+    return kIOReturnSuccess;
 }
 
 ///
@@ -983,7 +1094,8 @@ IOReturn IOSDCard::initializeCard(UInt32 ocr, SpeedMode& speedMode)
     pinfo("The SD status register value has been fetched.");
     
     // The Linux driver initializes the erase function here,
-    // but our driver does not support this feature.
+    // but our driver derives the erase parameters from the SD status on demand.
+    // See `IOSDHostDriver::discardBlocks()` for details.
     
     // Fetch the switch information from the card
     pinfo("Fetching the switch capabilities from the card...");
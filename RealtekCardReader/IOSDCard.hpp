@@ -15,6 +15,7 @@
 #include "IOSDCard-SCR.hpp"
 #include "IOSDCard-SSR.hpp"
 #include "IOSDCard-SwitchCaps.hpp"
+#include "IOSDCard-ExtRegs.hpp"
 #include "BitOptions.hpp"
 
 /// Forward declaration
@@ -102,6 +103,15 @@ private:
     /// The card relative address
     UInt32 rca;
     
+    /// The performance enhancement function (valid only if the card supports it)
+    PerformanceEnhancement performanceEnhancement;
+    
+    /// `True` if the cache of the card has been enabled
+    bool cacheEnabled;
+    
+    /// The number of tasks the command queue can hold (0 if the command queue has not been enabled)
+    UInt8 commandQueueDepth;
+    
     //
     // MARK: - Query Card Properties
     //
@@ -137,6 +147,24 @@ public:
         return this->rca;
     }
     
+    /// Get the performance enhancement function
+    inline const PerformanceEnhancement& getPerformanceEnhancement() const
+    {
+        return this->performanceEnhancement;
+    }
+    
+    /// Check whether the cache of the card has been enabled
+    inline bool isCacheEnabled() const
+    {
+        return this->cacheEnabled;
+    }
+    
+    /// Get the number of tasks the command queue can hold (0 if the command queue has not been enabled)
+    inline UInt8 getCommandQueueDepth() const
+    {
+        return this->commandQueueDepth;
+    }
+    
     /// Get the card type
     inline const char* getCardType() const
     {
@@ -456,6 +484,15 @@ private:
     ///
     bool setUHSBusSpeedMode(SwitchCaps::BusSpeed busSpeed);
     
+    ///
+    /// [Helper] Enable the cache and the command queue if the card supports the performance enhancement function
+    ///
+    /// @note Port: This function replaces `sd_read_ext_regs()` and `sd_enable_cache()` defined in `sd.c`.
+    /// @note This function is invoked once the card has been initialized at the selected speed mode.
+    ///       Failures are not fatal, since the card remains fully functional without these features.
+    ///
+    void initPerformanceEnhancement();
+    
     ///
     /// [Helper] Initialize the card at the default speed mode
     ///
@@ -6,7 +6,6 @@
 //
 
 #include "IOSDComplexBlockRequest.hpp"
-#include <IOKit/IOSubMemoryDescriptor.h>
 #include "IOMemoryDescriptor.hpp"
 #include "IOSDHostDriver.hpp"
 #include "Utilities.hpp"
@@ -18,6 +17,16 @@
 
 OSDefineMetaClassAndStructors(IOSDComplexBlockRequest, IOSDSimpleBlockRequest);
 
+///
+/// Release this block request
+///
+void IOSDComplexBlockRequest::free()
+{
+    OSSafeReleaseNULL(this->subBuffer);
+    
+    super::free();
+}
+
 ///
 /// Initialize a block request
 ///
@@ -70,25 +79,60 @@ void IOSDComplexBlockRequest::deinit()
 ///
 void IOSDComplexBlockRequest::service()
 {
-    // Guard: A buffer that describes a portion of data to be transfered in the current DMA transaction
-    IOSubMemoryDescriptor* buffer = OSTypeAlloc(IOSubMemoryDescriptor);
+    passert(this->subBuffer != nullptr, "The preallocated sub-buffer should not be null.");
+    
+    pinfo("BREQ: Servicing the complex request: Start index = %llu; Number of blocks = %llu.", this->block, this->nblocks);
     
-    if (buffer == nullptr)
+    IOSDBlockRequestStatistics::Snapshot snapshot;
+    
+    this->driver->willServiceBlockRequest(snapshot);
+    
+    // Service all intermediate transactions while the original buffer is prepared,
+    // so that preparing each portion of the buffer does not page in and wire down the whole buffer again.
+    auto action = [&](IOMemoryDescriptor*) -> IOReturn
     {
-        IOStorage::complete(&this->completion, kIOReturnNoMemory, 0);
-        
-        return;
-    }
+        return this->serviceAllTransactions();
+    };
+    
+    IOReturn status = IOMemoryDescriptorRunActionWhilePrepared(this->fullBuffer, action);
+    
+    this->driver->didServiceBlockRequest(snapshot, this->fullBuffer->getDirection(), this->nblocks, status);
+    
+    // The sub-buffer no longer refers to the original buffer
+    this->buffer = this->fullBuffer;
     
-    this->buffer = buffer;
+    psoftassert(this->subBuffer->initSubRange(nullptr, 0, 0, kIODirectionNone),
+                "Failed to dissociate the sub-buffer from the original buffer.");
     
-    // The service status
-    IOReturn status = kIOReturnSuccess;
+    // Complete the request
+    UInt64 actualByteCount = status == kIOReturnSuccess ? this->nblocks * 512 : 0;
+
+    IOStorage::complete(&this->completion, status, actualByteCount);
     
+    pinfo("The request is completed. Return value = 0x%08x.", status);
+}
+
+///
+/// Service all intermediate transactions of the block request
+///
+/// @return `kIOReturnSuccess` if all transactions complete without errors, other values otherwise.
+/// @note Each transaction transfers a portion of the original buffer described by the preallocated sub-buffer.
+/// @note When writing blocks, the first transaction ends at the next allocation unit boundary,
+///       and each subsequent transaction covers as many whole allocation units as the DMA limit allows,
+///       so that the card writes whole allocation units at its rated speed.
+///       If an allocation unit exceeds the DMA limit (e.g. 4 MB units vs. 512 KB transactions), a single CMD25 cannot cover it,
+///       so each transaction ends at the next multiple of the DMA limit or the allocation unit instead,
+///       and no transaction crosses an allocation unit boundary.
+///
+IOReturn IOSDComplexBlockRequest::serviceAllTransactions()
+{
     // The maximum number of blocks to be transferred in one transaction
     UInt64 maxRequestNumBlocks = this->driver->getHostDevice()->getDMALimits().maxRequestNumBlocks();
     
-    pinfo("BREQ: Servicing the complex request: Start index = %llu; Number of blocks = %llu.", this->block, this->nblocks);
+    // The number of blocks in an allocation unit if transactions should be aligned to absolute block boundaries
+    UInt64 auSize = this->fullBuffer->getDirection() == kIODirectionOut ? this->driver->getWriteAlignment() : 0;
+    
+    this->buffer = this->subBuffer;
     
     // Divide the original request into multiple transactions
     while (this->cblock < this->block + this->nblocks)
@@ -96,43 +140,52 @@ void IOSDComplexBlockRequest::service()
         // Calculate the number of blocks to be transfered
         this->cnblocks = min(maxRequestNumBlocks, this->block + this->nblocks - this->cblock);
         
+        // Guard: Align the transaction to allocation units, so that subsequent transactions start at aligned blocks
+        if (auSize != 0 && auSize <= maxRequestNumBlocks)
+        {
+            // The first transaction ends at the next allocation unit boundary if the request starts in the middle of a unit
+            // Subsequent transactions cover as many whole allocation units as the DMA limit allows
+            UInt64 offset = this->cblock % auSize;
+            
+            this->cnblocks = min(this->cnblocks, offset != 0 ? auSize - offset : maxRequestNumBlocks / auSize * auSize);
+        }
+        else if (auSize != 0)
+        {
+            // A single transaction cannot cover a whole allocation unit
+            // End the transaction at the next boundary, so that it never crosses an allocation unit boundary
+            UInt64 boundary = min((this->cblock / maxRequestNumBlocks + 1) * maxRequestNumBlocks, (this->cblock / auSize + 1) * auSize);
+            
+            this->cnblocks = min(this->cnblocks, boundary - this->cblock);
+        }
+        
         pinfo("BREQ: Servicing the intermediate transaction: Current start index = %llu; Number of blocks = %llu.", this->cblock, this->cnblocks);
         
         // Specify the portion of data to be transfered
-        if (!buffer->initSubRange(this->fullBuffer, (this->cblock - this->block) * 512, this->cnblocks * 512, this->fullBuffer->getDirection()))
+        if (!this->subBuffer->initSubRange(this->fullBuffer, (this->cblock - this->block) * 512, this->cnblocks * 512, this->fullBuffer->getDirection()))
         {
             perr("Failed to initialize the sub-memory descriptor.");
             
-            status = kIOReturnError;
-            
-            break;
+            return kIOReturnError;
         }
         
         // Service the intermediate request
-        status = this->serviceOnce();
+        IOReturn status = this->serviceOnce();
         
         if (status != kIOReturnSuccess)
         {
             perr("Failed to process the intermediate transaction. Error = 0x%x.", status);
             
-            break;
+            return status;
         }
         
         // Guard: Complete the intermediate request
         pinfo("BREQ: Serviced the intermediate transaction: Current start index = %llu; Number of blocks = %llu.", this->cblock, this->cnblocks);
         
         // The intermediate request completes without errors
-        this->cblock += maxRequestNumBlocks;
+        this->cblock += this->cnblocks;
     }
     
-    // Complete the request
-    UInt64 actualByteCount = status == kIOReturnSuccess ? this->nblocks * 512 : 0;
-
-    IOStorage::complete(&this->completion, status, actualByteCount);
-    
-    OSSafeReleaseNULL(this->buffer);
-    
-    pinfo("The request is completed. Return value = 0x%08x.", status);
+    return kIOReturnSuccess;
 }
 
 ///
@@ -154,3 +207,33 @@ UInt64 IOSDComplexBlockRequest::getNumBlocks()
 {
     return this->cnblocks;
 }
+
+///
+/// Create a block request along with its preallocated sub-buffer
+///
+/// @return A non-null block request on success, `nullptr` otherwise.
+///
+IOSDComplexBlockRequest* IOSDComplexBlockRequest::create()
+{
+    IOSDComplexBlockRequest* request = OSTypeAlloc(IOSDComplexBlockRequest);
+    
+    if (request == nullptr)
+    {
+        perr("Failed to allocate the complex block request.");
+        
+        return nullptr;
+    }
+    
+    request->subBuffer = OSTypeAlloc(IOSubMemoryDescriptor);
+    
+    if (request->subBuffer == nullptr)
+    {
+        perr("Failed to preallocate the sub-buffer.");
+        
+        request->release();
+        
+        return nullptr;
+    }
+    
+    return request;
+}
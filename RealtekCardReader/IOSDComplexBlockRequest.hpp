@@ -8,6 +8,7 @@
 #ifndef IOSDComplexBlockRequest_hpp
 #define IOSDComplexBlockRequest_hpp
 
+#include <IOKit/IOSubMemoryDescriptor.h>
 #include "IOSDSimpleBlockRequest.hpp"
 
 ///
@@ -26,6 +27,14 @@ class IOSDComplexBlockRequest: public IOSDSimpleBlockRequest
     /// The original buffer that contains all data to be transfered
     IOMemoryDescriptor* fullBuffer;
     
+    ///
+    /// A preallocated buffer that describes a portion of data to be transfered in the current DMA transaction
+    ///
+    /// @note The buffer is allocated along with the request and reused by all requests serviced by this instance.
+    ///       It refers to the original buffer only while the request is being serviced.
+    ///
+    IOSubMemoryDescriptor* subBuffer;
+    
     /// The current starting block number
     UInt64 cblock;
     
@@ -33,6 +42,11 @@ class IOSDComplexBlockRequest: public IOSDSimpleBlockRequest
     UInt64 cnblocks;
     
 public:
+    ///
+    /// Release this block request
+    ///
+    void free() override;
+    
     ///
     /// Initialize a block request
     ///
@@ -67,6 +81,17 @@ public:
     ///
     void service() override;
     
+private:
+    ///
+    /// Service all intermediate transactions of the block request
+    ///
+    /// @return `kIOReturnSuccess` if all transactions complete without errors, other values otherwise.
+    /// @note Each transaction transfers a portion of the original buffer described by the preallocated sub-buffer.
+    ///
+    IOReturn serviceAllTransactions();
+    
+public:
+    
     ///
     /// Get the index of the start block to service the request
     ///
@@ -80,6 +105,22 @@ public:
     /// @note This function is invoked by the processor routine to service the request either fully or partially.
     ///
     UInt64 getNumBlocks() override;
+    
+    ///
+    /// Create a block request along with its preallocated sub-buffer
+    ///
+    /// @return A non-null block request on success, `nullptr` otherwise.
+    ///
+    static IOSDComplexBlockRequest* create();
+};
+
+/// The creator that allocates a complex block request for the request pool
+struct IOSDComplexBlockRequestCreator
+{
+    IOSDComplexBlockRequest* operator()()
+    {
+        return IOSDComplexBlockRequest::create();
+    }
 };
 
 #endif /* IOSDComplexBlockRequest_hpp */
@@ -42,6 +42,67 @@ IOReturn IOSDHostDevice::postprocessRequest(IOSDHostRequest& request)
     return kIOReturnSuccess;
 }
 
+//
+// MARK: - Transfer Statistics
+//
+
+///
+/// Get the counters of the work performed by the host device
+///
+/// @param counters The counters on return
+/// @note The default implementation reports zeros for all counters.
+///       The concrete host device should override this function if it keeps track of the work it performs.
+///
+void IOSDHostDevice::getTransferCounters(TransferCounters& counters)
+{
+    counters.reset();
+}
+
+//
+// MARK: - Request Pipelining
+//
+
+///
+/// Prepare the DMA transfer of the given memory descriptor ahead of time
+///
+/// @param descriptor A non-null memory descriptor of the next pending block request
+/// @return `kIOReturnSuccess` on success, `kIOReturnUnsupported` if the host device cannot prepare a DMA transfer ahead of time.
+/// @note This function is invoked by the host driver while the current DMA transfer is in flight.
+///       The default implementation does nothing and returns `kIOReturnUnsupported`.
+///
+IOReturn IOSDHostDevice::prepareDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    return kIOReturnUnsupported;
+}
+
+///
+/// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+///
+/// @param descriptor A non-null memory descriptor of a block request that has been serviced
+/// @note This function is invoked by the host driver once a block request has been serviced,
+///       since the request may be serviced without the transfer prepared for it (e.g. by the read-ahead cache).
+///       The default implementation does nothing.
+///
+void IOSDHostDevice::discardDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    // Nothing has been prepared ahead of time by default
+}
+
+///
+/// [UPCALL] Notify the host device that a DMA transfer has started and is now in flight
+///
+/// @note This callback function is invoked on the processor workloop after the transfer has started
+///       and before the host device waits for its completion, so it runs outside the gate of the card reader controller.
+///       The default implementation notifies the host driver so that it can prepare the next pending request.
+///
+void IOSDHostDevice::onDMATransferInFlight()
+{
+    if (this->driver != nullptr)
+    {
+        this->driver->onDMATransferInFlight();
+    }
+}
+
 //
 // MARK: - Card Events Callbacks
 //
@@ -67,6 +67,49 @@ public:
         }
     };
     
+    ///
+    /// Counters of the work performed by the host device to service requests
+    ///
+    /// @note Counters increase monotonically while the host device is running.
+    ///       The host driver takes a snapshot before and after a request to measure its overhead.
+    ///
+    struct TransferCounters
+    {
+        /// The number of registers accessed individually
+        UInt64 numRegisterAccesses;
+        
+        /// The number of commands queued for the hardware
+        UInt64 numHostCommands;
+        
+        /// The number of round trips to the hardware to execute queued commands
+        UInt64 numCommandTransfers;
+        
+        /// The number of DMA transfers initiated by the host
+        UInt64 numDMATransfers;
+        
+        /// The number of hardware interrupts serviced by the host
+        UInt64 numInterrupts;
+        
+        /// The number of transfers whose completion was detected by polling instead of an interrupt
+        UInt64 numPolledCompletions;
+        
+        /// Reset all counters to zero
+        inline void reset()
+        {
+            this->numRegisterAccesses = 0;
+            
+            this->numHostCommands = 0;
+            
+            this->numCommandTransfers = 0;
+            
+            this->numDMATransfers = 0;
+            
+            this->numInterrupts = 0;
+            
+            this->numPolledCompletions = 0;
+        }
+    };
+    
     ///
     /// Enumerates all host device capabilities
     ///
@@ -367,6 +410,54 @@ public:
         return this->factory;
     }
     
+    //
+    // MARK: - Transfer Statistics
+    //
+    
+public:
+    ///
+    /// Get the counters of the work performed by the host device
+    ///
+    /// @param counters The counters on return
+    /// @note The default implementation reports zeros for all counters.
+    ///       The concrete host device should override this function if it keeps track of the work it performs.
+    ///
+    virtual void getTransferCounters(TransferCounters& counters);
+    
+    //
+    // MARK: - Request Pipelining
+    //
+    
+public:
+    ///
+    /// Prepare the DMA transfer of the given memory descriptor ahead of time
+    ///
+    /// @param descriptor A non-null memory descriptor of the next pending block request
+    /// @return `kIOReturnSuccess` on success, `kIOReturnUnsupported` if the host device cannot prepare a DMA transfer ahead of time.
+    /// @note This function is invoked by the host driver while the current DMA transfer is in flight.
+    ///       The default implementation does nothing and returns `kIOReturnUnsupported`.
+    ///
+    virtual IOReturn prepareDMATransferAhead(IOMemoryDescriptor* descriptor);
+    
+    ///
+    /// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+    ///
+    /// @param descriptor A non-null memory descriptor of a block request that has been serviced
+    /// @note This function is invoked by the host driver once a block request has been serviced,
+    ///       since the request may be serviced without the transfer prepared for it (e.g. by the read-ahead cache).
+    ///       The default implementation does nothing.
+    ///
+    virtual void discardDMATransferAhead(IOMemoryDescriptor* descriptor);
+    
+    ///
+    /// [UPCALL] Notify the host device that a DMA transfer has started and is now in flight
+    ///
+    /// @note This callback function is invoked on the processor workloop after the transfer has started
+    ///       and before the host device waits for its completion, so it runs outside the gate of the card reader controller.
+    ///       The default implementation notifies the host driver so that it can prepare the next pending request.
+    ///
+    void onDMATransferInFlight();
+    
     //
     // MARK: - Card Events Callbacks
     //
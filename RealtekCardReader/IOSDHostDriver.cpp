@@ -13,6 +13,7 @@
 #include "IOSDHostDriverUserConfigs.hpp"
 #include "IOCommandGate.hpp"
 #include <IOKit/storage/IOBlockStorageDriver.h>
+#include <kern/clock.h>
 
 //
 // MARK: - Meta Class Definitions
@@ -74,11 +75,850 @@ IOReturn IOSDHostDriver::submitBlockRequest(IOSDBlockRequest::Processor processo
     // Since the event source is disabled, it will not process this request.
     // The request remains in the queue, but the host driver will recycle it when a new card is inserted.
     // See `IOSDHostDriver::attachCard(frequency:)` for details.
-    this->pendingRequests->enqueueRequest(request);
+    // The queue only rings the doorbell when the processor workloop has observed all previous submissions,
+    // otherwise the workloop will find this request before it goes back to sleep.
+    if (this->pendingRequests->enqueueRequest(request))
+    {
+        this->queueEventSource->notify();
+    }
+    
+    return kIOReturnSuccess;
+}
+
+//
+// MARK: - Discard Blocks
+//
+
+///
+/// [Helper] Wait until the card finishes programming and returns to the transfer state
+///
+/// @param timeout The amount of time in milliseconds to wait for the card
+/// @param errors The card status bits that indicate the failure of the previous operation
+/// @return `kIOReturnSuccess` on success, `kIOReturnIOError` if the card reports any of the given errors,
+///         `kIOReturnTimeout` if the card is still busy after the given amount of time, other values otherwise.
+/// @note This function must be invoked on the processor workloop.
+///
+IOReturn IOSDHostDriver::waitForCardReady(UInt32 timeout, UInt32 errors)
+{
+    // Poll the card status until it returns to the transfer state
+    UInt64 deadline;
+    
+    UInt64 now;
+    
+    clock_interval_to_deadline(timeout, kMillisecondScale, &deadline);
+    
+    while (true)
+    {
+        UInt32 status = 0;
+        
+        IOReturn retVal = this->CMD13(this->card->getRCA(), status);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to fetch the card status. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        if ((status & errors) != 0)
+        {
+            perr("The card reports an error. Status = 0x%08x.", status);
+            
+            return kIOReturnIOError;
+        }
+        
+        if (BitOptions(status).contains(R1_READY_FOR_DATA) && R1_CURRENT_STATE(status) != R1_STATE_PRG)
+        {
+            return kIOReturnSuccess;
+        }
+        
+        clock_get_uptime(&now);
+        
+        if (now >= deadline)
+        {
+            perr("Timed out while waiting for the card to finish programming. Status = 0x%08x.", status);
+            
+            return kIOReturnTimeout;
+        }
+        
+        IOSleep(1);
+    }
+}
+
+///
+/// [Helper] Erase the given range of blocks with a single erase sequence
+///
+/// @param block The starting block number
+/// @param nblocks The number of blocks to erase
+/// @param argument The CMD38 argument that specifies the erase function
+/// @param timeout The amount of time in milliseconds to wait for the card to finish the operation
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces `mmc_do_erase()` defined in `core.c`.
+/// @note This function must be invoked on the processor workloop.
+///
+IOReturn IOSDHostDriver::eraseBlocksGated(UInt64 block, UInt64 nblocks, UInt32 argument, UInt32 timeout)
+{
+    pinfo("Erasing %llu blocks from the block at %llu. Argument = %u; Timeout = %u ms.", nblocks, block, argument, timeout);
+    
+    IOReturn retVal = this->CMD32(this->transformBlockOffsetIfNecessary(block));
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to set the start address of the blocks to be erased. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    retVal = this->CMD33(this->transformBlockOffsetIfNecessary(block + nblocks - 1));
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to set the end address of the blocks to be erased. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    retVal = this->CMD38(argument, timeout);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to erase the selected blocks. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    // The card may still be programming after the busy signal is released
+    return this->waitForCardReady(timeout, R1_ERASE_SEQ_ERROR | R1_ERASE_PARAM | R1_WP_ERASE_SKIP | R1_ERROR);
+}
+
+///
+/// Discard the given range of blocks on the card
+///
+/// @param block The starting block number
+/// @param nblocks The number of blocks to discard
+/// @return `kIOReturnSuccess` on success, `kIOReturnNoMedia` if the card is not present,
+///         `kIOReturnUnsupported` if the card does not support erase commands, other values otherwise.
+/// @note This function runs synchronously on the processor workloop, so it is serialized with block requests.
+/// @note The card discards the given blocks if it supports the discard function, otherwise it erases them.
+///       The range is split into multiple erase sequences so that each one is bounded by the erase timeout.
+/// @note If the card erases blocks in units of erase sectors (i.e. `ERASE_BLK_EN` is 0),
+///       the range is shrunk to whole sectors, so blocks that share a sector with the ones outside the range are kept.
+///
+IOReturn IOSDHostDriver::discardBlocks(UInt64 block, UInt64 nblocks)
+{
+    auto action = [&]() -> IOReturn
+    {
+        // Guard: Ensure that the card is still present
+        if (this->card == nullptr)
+        {
+            perr("The card is not present.");
+            
+            return kIOReturnNoMedia;
+        }
+        
+        // Guard: Ensure that the card supports erase commands
+        if (!BitOptions(this->card->getCSD().cardCommandClasses).contains(CSD::CommandClass::kErase))
+        {
+            pinfo("The card does not support erase commands.");
+            
+            return kIOReturnUnsupported;
+        }
+        
+        // Prefetched blocks are no longer valid once they are discarded
+        this->readAheadCache.invalidate(block, nblocks);
+        
+        // The card erases up to `eraseSize` allocation units within the erase timeout it specifies
+        const SSR& ssr = this->card->getSSR();
+        
+        UInt32 argument = kEraseArgumentErase;
+        
+        if (ssr.supportsDiscard)
+        {
+            argument = kEraseArgumentDiscard;
+        }
+        
+        // Guard: A card without the discard function erases whole erase sectors
+        //        Shrink the range to whole sectors (See `mmc_align_erase_size()`)
+        UInt64 eraseSize = this->card->getCSD().eraseSize;
+        
+        if (argument == kEraseArgumentErase && eraseSize > 1)
+        {
+            UInt64 start = (block + eraseSize - 1) / eraseSize * eraseSize;
+            
+            UInt64 end = (block + nblocks) / eraseSize * eraseSize;
+            
+            if (start >= end)
+            {
+                pinfo("The range [%llu, %llu) does not cover any erase sector of %llu blocks.", block, block + nblocks, eraseSize);
+                
+                return kIOReturnSuccess;
+            }
+            
+            pinfo("Aligned the range [%llu, %llu) to [%llu, %llu) for erase sectors of %llu blocks.", block, block + nblocks, start, end, eraseSize);
+            
+            block = start;
+            
+            nblocks = end - start;
+        }
+        
+        UInt64 auSize = ssr.getAUSize();
+        
+        UInt64 maxNumBlocks = auSize == 0 ? kDefaultMaxNumEraseBlocks : auSize * (ssr.eraseSize == 0 ? 1 : ssr.eraseSize);
+        
+        while (nblocks > 0)
+        {
+            UInt64 count = nblocks < maxNumBlocks ? nblocks : maxNumBlocks;
+            
+            // The card reports the discard function done within 250 ms (See `mmc_sd_erase_timeout()`)
+            // The erase timeout depends on the number of allocation units covered by the range
+            UInt32 timeout = 250;
+            
+            if (argument == kEraseArgumentErase)
+            {
+                UInt64 numAUs = auSize == 0 ? count : (block + count - 1) / auSize - block / auSize + 1;
+                
+                timeout = ssr.getEraseTimeout(static_cast<UInt32>(numAUs));
+            }
+            
+            IOReturn retVal = this->eraseBlocksGated(block, count, argument, timeout);
+            
+            if (retVal != kIOReturnSuccess)
+            {
+                perr("Failed to erase %llu blocks from the block at %llu. Error = 0x%x.", count, block, retVal);
+                
+                return retVal;
+            }
+            
+            block += count;
+            
+            nblocks -= count;
+        }
+        
+        return kIOReturnSuccess;
+    };
+    
+    pinfo("Discarding %llu blocks from the block at %llu.", nblocks, block);
+    
+    return IOCommandGateRunAction(this->processorCommandGate, action);
+}
+
+//
+// MARK: - Card Cache
+//
+
+///
+/// [Helper] Flush the cache of the card
+///
+/// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if the card fails to flush its cache in time, other values otherwise.
+/// @note Port: This function replaces `sd_flush_cache()` defined in `sd.c`.
+///       The card may keep the flush bit set for a while after it leaves the busy state,
+///       so this function polls the register with backoff instead of reading it once.
+/// @note This function must be invoked on the processor workloop.
+///
+IOReturn IOSDHostDriver::flushCardCacheGated()
+{
+    const ExtensionRegister& address = this->card->getPerformanceEnhancement().address;
+    
+    IOReturn retVal = this->writeExtensionRegister(address, PerformanceEnhancement::kFlushCache, 0x01, kFlushCacheTimeout);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to request the card to flush its cache. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    // The card clears the register once the cache has been flushed
+    // Poll the register until the bit is cleared, doubling the interval between two reads up to 32 ms
+    UInt64 deadline;
+    
+    UInt64 now;
+    
+    UInt32 interval = 1;
+    
+    clock_interval_to_deadline(kFlushCacheTimeout, kMillisecondScale, &deadline);
+    
+    while (true)
+    {
+        UInt8 value[1] = {};
+        
+        retVal = this->CMD48(address.getCommandArgument(PerformanceEnhancement::kFlushCache, 1), value);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to read the register that flushes the cache. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        if (!BitOptions(value[0]).contains(0x01))
+        {
+            pinfo("The card cache has been flushed.");
+            
+            return kIOReturnSuccess;
+        }
+        
+        clock_get_uptime(&now);
+        
+        if (now >= deadline)
+        {
+            perr("The card is still flushing its cache after %u ms.", kFlushCacheTimeout);
+            
+            return kIOReturnTimeout;
+        }
+        
+        IOSleep(interval);
+        
+        interval = min(interval * 2, 32);
+    }
+}
+
+///
+/// Write the given value to a register in the given extension register set
+///
+/// @param address The address of the extension register set
+/// @param position The offset of the register relative to the start of the register set
+/// @param value The value to be written
+/// @param timeout The amount of time in milliseconds to wait for the card to finish the operation
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces `sd_write_ext_reg()` defined in `sd.c`.
+/// @note This function must be invoked on the processor workloop or while the card is being initialized.
+///
+IOReturn IOSDHostDriver::writeExtensionRegister(const ExtensionRegister& address, UInt32 position, UInt8 value, UInt32 timeout)
+{
+    IOReturn retVal = this->CMD49(address.getCommandArgument(position, 1), value);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to write 0x%02x to the extension register at %u. Error = 0x%x.", value, position, retVal);
+        
+        return retVal;
+    }
+    
+    // The card signals busy while it is programming the register
+    return this->waitForCardReady(timeout, R1_ERROR | R1_ADDRESS_ERROR);
+}
+
+///
+/// Flush the cache of the card
+///
+/// @return `kIOReturnSuccess` on success or if the cache is not enabled, `kIOReturnNoMedia` if the card is not present,
+///         other values otherwise.
+/// @note This function runs synchronously on the processor workloop, so it is serialized with block requests.
+///
+IOReturn IOSDHostDriver::flushCardCache()
+{
+    auto action = [&]() -> IOReturn
+    {
+        // Guard: Ensure that the card is still present
+        if (this->card == nullptr)
+        {
+            perr("The card is not present.");
+            
+            return kIOReturnNoMedia;
+        }
+        
+        // Guard: Ensure that the card cache is enabled
+        if (!this->card->isCacheEnabled())
+        {
+            return kIOReturnSuccess;
+        }
+        
+        return this->flushCardCacheGated();
+    };
+    
+    pinfo("Flushing the card cache.");
+    
+    return IOCommandGateRunAction(this->processorCommandGate, action);
+}
+
+//
+// MARK: - Block Request Statistics
+//
+
+///
+/// [Helper] Publish the given statistics of block requests in the I/O Registry
+///
+/// @param key The name of the property
+/// @param statistics The statistics of block requests serviced so far
+/// @note The property reflects the statistics collected while the last card was present.
+///       It is updated when the card is removed, so that the registry is not touched on the I/O path.
+///
+void IOSDHostDriver::publishBlockRequestStatistics(const char* key, const IOSDBlockRequestStatistics& statistics)
+{
+    OSDictionary* dictionary = statistics.serialize();
+    
+    if (dictionary == nullptr)
+    {
+        perr("Failed to serialize the statistics of block requests.");
+        
+        return;
+    }
+    
+    this->setProperty(key, dictionary);
+    
+    dictionary->release();
+}
+
+///
+/// Notify the host driver that a block request is about to be serviced
+///
+/// @param snapshot The state captured before the request is serviced on return
+/// @note This function is invoked on the processor workloop by the block request itself.
+///
+void IOSDHostDriver::willServiceBlockRequest(IOSDBlockRequestStatistics::Snapshot& snapshot)
+{
+    if (UserConfigs::Card::CollectBlockRequestStatistics)
+    {
+        IOSDBlockRequestStatistics::takeSnapshot(this->host, snapshot);
+    }
+    
+    // Data timeouts are recorded by `setDataTimeout()` while the request is being serviced
+    this->maxAppliedDataTimeout = 0;
+    
+    this->totalAppliedDataTimeout = 0;
+    
+    // Alternate between predefined and open-ended multi-block transfers in the bench mode
+    if (UNLIKELY(UserConfigs::Card::BenchPredefinedTransfers))
+    {
+        this->benchOpenEndedTransfers = !this->benchOpenEndedTransfers;
+    }
+}
+
+///
+/// Notify the host driver that a block request has been serviced
+///
+/// @param snapshot The state captured before the request is serviced
+/// @param direction The transfer direction of the request
+/// @param nblocks The number of blocks to transfer
+/// @param status The service status of the request
+/// @note This function is invoked on the processor workloop by the block request itself.
+///
+void IOSDHostDriver::didServiceBlockRequest(const IOSDBlockRequestStatistics::Snapshot& snapshot, IODirection direction, UInt64 nblocks, IOReturn status)
+{
+    if (UserConfigs::Card::CollectBlockRequestStatistics)
+    {
+        (this->benchOpenEndedTransfers ? this->openEndedStatistics : this->statistics).record(this->host, snapshot, direction, nblocks, status, this->maxAppliedDataTimeout, this->totalAppliedDataTimeout);
+    }
+}
+
+//
+// MARK: - Request Pipelining
+//
+
+///
+/// [UPCALL] Notify the host driver that a DMA transfer has started and is now in flight
+///
+/// @note This callback function is invoked on the processor workloop while the current block request is being serviced.
+///       It runs outside the gate of the card reader controller, so the current transfer may complete in the meantime.
+/// @note The host driver asks the host device to prepare the DMA transfer of the next pending request,
+///       hiding the setup latency of the next request behind the current transfer.
+///
+void IOSDHostDriver::onDMATransferInFlight()
+{
+    if (UserConfigs::Card::NoRequestPipelining || UserConfigs::Card::SeparateAccessBlocksRequest)
+    {
+        return;
+    }
+    
+    // The processor workloop is the only thread that removes a request from the queue,
+    // so the next pending request remains valid until it is serviced by the current thread.
+    IOSDBlockRequest* request = this->pendingRequests->peekRequest();
+    
+    // Guard: A complex request is divided into multiple transactions when it is serviced,
+    //        so only a simple request can be prepared ahead of time.
+    if (request == nullptr || OSTypeIDInst(request) != OSTypeID(IOSDSimpleBlockRequest))
+    {
+        return;
+    }
+    
+    // Guard: Only a request whose buffer will be transferred as is can be prepared ahead of time
+    if (!this->willTransferBlockRequestAsIs(static_cast<IOSDSimpleBlockRequest*>(request)))
+    {
+        pinfo("The next pending request will not be serviced with its own DMA transfer.");
+        
+        return;
+    }
+    
+    IOReturn retVal = this->host->prepareDMATransferAhead(request->getMemoryDescriptor());
+    
+    pinfo("Prepared the next pending request ahead of time. Status = 0x%08x.", retVal);
+}
+
+///
+/// Release the DMA transfer prepared ahead of time for the given request if it has not been performed
+///
+/// @param request A non-null block request that has just been serviced
+/// @note This function is invoked on the processor workloop by the block request itself.
+/// @note A request prepared ahead of time may still be serviced without its own DMA transfer,
+///       e.g. when it is merged with a request submitted after the preparation or it fails before the transfer starts.
+///       The host device must not keep its buffer prepared once the request is completed.
+///
+void IOSDHostDriver::didServiceBlockRequestAhead(IOSDBlockRequest* request)
+{
+    if (UserConfigs::Card::NoRequestPipelining || UserConfigs::Card::SeparateAccessBlocksRequest)
+    {
+        return;
+    }
+    
+    this->host->discardDMATransferAhead(request->getMemoryDescriptor());
+}
+
+///
+/// [Helper] Check whether the given pending request is likely to be serviced by a DMA transfer of its own buffer
+///
+/// @param request A non-null simple block request at the head of the queue
+/// @return `false` if the request will be serviced by the read-ahead cache, merged with another pending request,
+///         or queued along with other random reads, `true` otherwise.
+/// @note This function shares its predicates with the routines that service the request,
+///       so that the host device does not prepare a transfer that will never be performed.
+///
+bool IOSDHostDriver::willTransferBlockRequestAsIs(IOSDSimpleBlockRequest* request)
+{
+    // Guard: Check whether the request will be serviced by the read-ahead cache
+    if (this->isCachedReadRequest(request))
+    {
+        return false;
+    }
+    
+    // Guard: Check whether the request will be merged with another pending one
+    //        The request is still in the queue, so it must be excluded from the candidates
+    if (this->isRequestMergingEnabled())
+    {
+        auto predicate = [&](IOSDBlockRequest* other) -> bool
+        {
+            return other != request && this->canMergeBlockRequests(request, other);
+        };
+        
+        if (this->pendingRequests->containsRequest(predicate))
+        {
+            return false;
+        }
+    }
+    
+    // Guard: Check whether the request will be queued along with other random reads
+    IOItemCount depth = this->getRandomReadQueueDepth();
+    
+    if (depth != 0 && this->isRandomReadRequest(request))
+    {
+        auto predicate = [&](IOSDBlockRequest* other) -> bool
+        {
+            return other != request && this->canQueueBlockRequests(request, other, depth);
+        };
+        
+        if (this->pendingRequests->containsRequest(predicate))
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+///
+/// [Helper] Check whether the given request will be serviced by the blocks stored in the read-ahead cache
+///
+/// @param request A non-null block request
+/// @return `true` if the request reads blocks that are all stored in the cache, `false` otherwise.
+///
+bool IOSDHostDriver::isCachedReadRequest(IOSDBlockRequest* request)
+{
+    return request->getMemoryDescriptor()->getDirection() == kIODirectionIn &&
+           this->readAheadCache.contains(request->getBlockOffset(), request->getNumBlocks());
+}
+
+//
+// MARK: - Request Merging
+//
+
+///
+/// Merge pending requests that access blocks adjacent to the given request into it
+///
+/// @param request A non-null simple block request that is about to be serviced
+/// @note This function is invoked on the processor workloop by the block request itself.
+/// @note Merged requests are removed from the queue and are serviced in one DMA transaction along with the given request.
+///       They are completed individually and are returned to the pool when the given request is finalized.
+///
+void IOSDHostDriver::mergeAdjacentBlockRequests(IOSDSimpleBlockRequest* request)
+{
+    if (!this->isRequestMergingEnabled())
+    {
+        return;
+    }
+    
+    // A merged request accesses multiple blocks regardless of the original processor
+    IOSDBlockRequest::Processor processor = nullptr;
+    
+    if (request->getMemoryDescriptor()->getDirection() == kIODirectionIn)
+    {
+        processor = OSMemberFunctionCast(IOSDBlockRequest::Processor, this, &IOSDHostDriver::processReadBlocksRequest);
+    }
+    else
+    {
+        processor = OSMemberFunctionCast(IOSDBlockRequest::Processor, this, &IOSDHostDriver::processWriteBlocksRequest);
+    }
+    
+    // The queue is not ordered by block numbers, so scan it until no more adjacent request is found.
+    // Each round extends the merged range at either end, so the number of rounds is bounded by the merge limit.
+    while (true)
+    {
+        auto predicate = [&](IOSDBlockRequest* other) -> bool
+        {
+            return this->canMergeBlockRequests(request, other);
+        };
+        
+        auto other = static_cast<IOSDSimpleBlockRequest*>(this->pendingRequests->dequeueRequest(predicate));
+        
+        if (other == nullptr)
+        {
+            break;
+        }
+        
+        request->mergeRequest(other, processor);
+    }
+}
+
+///
+/// [Helper] Check whether pending requests that access adjacent blocks can be merged
+///
+/// @return `true` if the user does not disable request merging, `false` otherwise.
+///
+bool IOSDHostDriver::isRequestMergingEnabled()
+{
+    return !UserConfigs::Card::NoRequestMerging && !UserConfigs::Card::SeparateAccessBlocksRequest;
+}
+
+///
+/// [Helper] Check whether the given pending request can be merged into the given request
+///
+/// @param request A non-null simple block request that is about to be serviced
+/// @param other A non-null pending block request
+/// @return `true` if the other request accesses blocks adjacent to the given request within the DMA limit, `false` otherwise.
+///
+bool IOSDHostDriver::canMergeBlockRequests(IOSDSimpleBlockRequest* request, IOSDBlockRequest* other)
+{
+    return request->canMergeRequest(other, this->host->getDMALimits().maxRequestNumBlocks());
+}
+
+//
+// MARK: - Command Queue
+//
+
+///
+/// Queue pending random reads along with the given request as separate tasks in the command queue of the card
+///
+/// @param request A non-null simple block request that is about to be serviced
+/// @note This function is invoked on the processor workloop by the block request itself.
+/// @note Only small reads that are not serviced by the read-ahead cache are queued,
+///       and nothing is queued unless the user enables the command queue and the card supports it.
+///
+void IOSDHostDriver::queueRandomReadRequests(IOSDSimpleBlockRequest* request)
+{
+    IOItemCount depth = this->getRandomReadQueueDepth();
+    
+    if (depth == 0 || !this->isRandomReadRequest(request))
+    {
+        return;
+    }
+    
+    auto predicate = [&](IOSDBlockRequest* other) -> bool
+    {
+        return this->canQueueBlockRequests(request, other, depth);
+    };
+    
+    while (true)
+    {
+        auto other = static_cast<IOSDSimpleBlockRequest*>(this->pendingRequests->dequeueRequest(predicate));
+        
+        if (other == nullptr)
+        {
+            break;
+        }
+        
+        request->queueRequest(other);
+    }
+}
+
+///
+/// [Helper] Get the number of random reads that can be queued in the command queue of the card
+///
+/// @return The queue depth of the card, 0 if the user does not enable the command queue or if queueing brings no benefit.
+///
+IOItemCount IOSDHostDriver::getRandomReadQueueDepth()
+{
+    if (LIKELY(!UserConfigs::Card::EnableCommandQueue) || UserConfigs::Card::SeparateAccessBlocksRequest || this->card == nullptr)
+    {
+        return 0;
+    }
     
-    this->queueEventSource->notify();
+    IOItemCount depth = this->card->getCommandQueueDepth();
     
-    return kIOReturnSuccess;
+    // Queueing a single task brings nothing but overhead
+    return depth < 2 ? 0 : depth;
+}
+
+///
+/// [Helper] Check whether the given request is a small random read that can be queued in the command queue of the card
+///
+/// @param request A non-null block request
+/// @return `true` if the request is a small read that is not serviced by the read-ahead cache, `false` otherwise.
+/// @note Sequential reads are better serviced by the read-ahead cache or by a single CMD18.
+///
+bool IOSDHostDriver::isRandomReadRequest(IOSDBlockRequest* request)
+{
+    return request->getMemoryDescriptor()->getDirection() == kIODirectionIn &&
+           request->getNumBlocks() <= kMaxNumQueuedReadBlocks &&
+           !this->isCachedReadRequest(request);
+}
+
+///
+/// [Helper] Check whether the given pending request can be queued along with the given request
+///
+/// @param request A non-null simple block request that is a random read
+/// @param other A non-null pending block request
+/// @param depth The queue depth returned by `getRandomReadQueueDepth()`
+/// @return `true` if the other request is a random read that fits in the command queue along with the given request, `false` otherwise.
+///
+bool IOSDHostDriver::canQueueBlockRequests(IOSDSimpleBlockRequest* request, IOSDBlockRequest* other, IOItemCount depth)
+{
+    return request->canQueueRequest(other, depth) && this->isRandomReadRequest(other);
+}
+
+///
+/// Process the given read requests as separate tasks in the command queue of the card
+///
+/// @param requests A non-null array of simple block requests to read blocks
+/// @param count The number of requests (must not exceed the queue depth of the card)
+/// @param statuses A non-null array that stores the service status of each request on return
+/// @return `kIOReturnSuccess` if all requests complete without errors, other values otherwise.
+/// @note This function is invoked on the processor workloop by the block request itself.
+/// @note The index of each request in the given array is used as its task ID.
+///       Requests that are not serviced due to an earlier error are aborted.
+///
+IOReturn IOSDHostDriver::processQueuedReadRequests(IOSDSimpleBlockRequest** requests, IOItemCount count, IOReturn* statuses)
+{
+    passert(count <= this->card->getCommandQueueDepth(), "The number of requests should not exceed the queue depth.");
+    
+    IOReturn retVal = kIOReturnSuccess;
+    
+    // Tasks that have been queued but not executed yet
+    UInt32 pending = 0;
+    
+    for (IOItemCount index = 0; index < count; index += 1)
+    {
+        statuses[index] = kIOReturnAborted;
+    }
+    
+    // Queue all tasks
+    for (IOItemCount index = 0; index < count; index += 1)
+    {
+        IOSDSimpleBlockRequest* request = requests[index];
+        
+        UInt32 argument = kQueueTaskDirectionRead | index << 16 | static_cast<UInt32>(request->getNumBlocks());
+        
+        retVal = this->CMD44(argument);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("[%02u] Failed to queue the task. Error = 0x%x.", index, retVal);
+            
+            break;
+        }
+        
+        retVal = this->CMD45(this->transformBlockOffsetIfNecessary(request->getBlockOffset()));
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("[%02u] Failed to specify the start address of the task. Error = 0x%x.", index, retVal);
+            
+            break;
+        }
+        
+        pending |= 1 << index;
+    }
+    
+    // Execute each task as soon as the card reports that it is ready
+    UInt64 deadline;
+    
+    UInt64 now;
+    
+    clock_interval_to_deadline(kQueuedTaskTimeout, kMillisecondScale, &deadline);
+    
+    while (retVal == kIOReturnSuccess && pending != 0)
+    {
+        UInt32 qsr = 0;
+        
+        retVal = this->CMD13q(this->card->getRCA(), qsr);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to fetch the queue status. Error = 0x%x.", retVal);
+            
+            break;
+        }
+        
+        qsr &= pending;
+        
+        if (qsr == 0)
+        {
+            clock_get_uptime(&now);
+            
+            if (now >= deadline)
+            {
+                perr("Timed out while waiting for queued tasks to become ready. Pending = 0x%08x.", pending);
+                
+                retVal = kIOReturnTimeout;
+                
+                break;
+            }
+            
+            // Back off so that polling the queue status does not saturate the bus
+            IOSleep(1);
+            
+            continue;
+        }
+        
+        for (IOItemCount index = 0; index < count && retVal == kIOReturnSuccess; index += 1)
+        {
+            if (!BitOptions(qsr).contains(1 << index))
+            {
+                continue;
+            }
+            
+            IOSDSimpleBlockRequest* request = requests[index];
+            
+            // Feed the sequential detector of the read-ahead cache as if the request were serviced by a CMD17/18
+            this->readAheadCache.recordRead(request->getBlockOffset(), request->getNumBlocks());
+            
+            auto action = [&](IOMemoryDescriptor* descriptor) -> IOReturn
+            {
+                auto creq = this->host->getRequestFactory().CMD46(index, descriptor, request->getNumBlocks());
+                
+                this->setDataTimeout(creq, kIODirectionIn);
+                
+                return this->waitForRequest(creq);
+            };
+            
+            statuses[index] = IOMemoryDescriptorRunActionWhilePrepared(request->getMemoryDescriptor(), action);
+            
+            pending &= ~(1 << index);
+            
+            if (statuses[index] != kIOReturnSuccess)
+            {
+                perr("[%02u] Failed to execute the task. Error = 0x%x.", index, statuses[index]);
+                
+                retVal = statuses[index];
+            }
+        }
+    }
+    
+    // Abort remaining tasks so that the card is ready for the next request
+    if (retVal != kIOReturnSuccess && pending != 0)
+    {
+        psoftassert(this->CMD43(kQueueManagementAbortAll) == kIOReturnSuccess, "Failed to abort queued tasks.");
+    }
+    
+    return retVal;
 }
 
 //
@@ -116,6 +956,89 @@ UInt32 IOSDHostDriver::transformBlockOffsetIfNecessary(UInt64 block)
     return static_cast<UInt32>(block);
 }
 
+///
+/// Process the given request to read blocks with the read-ahead cache
+///
+/// @param request A non-null block request
+/// @return `kIOReturnSuccess` if the request is serviced by the cache,
+///         `kIOReturnUnsupported` if the request should be serviced by the card,
+///         other values if the driver fails to service the request.
+/// @note When this function is invoked, the memory descriptor is guaranteed to be non-null and prepared.
+/// @note If the request is part of a sequential stream but the requested blocks are not cached,
+///       this function prefetches the requested blocks along with the following ones with a single CMD18.
+///
+IOReturn IOSDHostDriver::processReadRequestWithReadAhead(IOSDBlockRequest* request)
+{
+    // Guard: Check whether the read-ahead cache is enabled
+    if (!this->readAheadCache.isEnabled())
+    {
+        return kIOReturnUnsupported;
+    }
+    
+    UInt64 block = request->getBlockOffset();
+    
+    UInt64 nblocks = request->getNumBlocks();
+    
+    bool sequential = this->readAheadCache.recordRead(block, nblocks);
+    
+    // Guard: Check whether the requested blocks have been prefetched
+    if (this->isCachedReadRequest(request))
+    {
+        pinfo("Servicing the request [%llu, %llu) with the read-ahead cache.", block, block + nblocks);
+        
+        return this->readAheadCache.copyBlocks(request->getMemoryDescriptor(), block, nblocks);
+    }
+    
+    // Guard: Prefetch blocks only for small requests of a sequential stream
+    //        A large request already amortizes the command overhead by itself
+    if (!sequential || nblocks * 2 > this->readAheadCache.getCapacity())
+    {
+        return kIOReturnUnsupported;
+    }
+    
+    // Guard: Do not prefetch blocks beyond the end of the card
+    passert(this->card != nullptr, "The card should be non-null at this moment.");
+    
+    UInt64 numCardBlocks = static_cast<UInt64>(this->card->getCSD().capacity) << (this->card->getCSD().readBlockLength - 9);
+    
+    UInt64 count = this->readAheadCache.getCapacity();
+    
+    if (block + count > numCardBlocks)
+    {
+        count = numCardBlocks - block;
+    }
+    
+    if (count <= nblocks)
+    {
+        return kIOReturnUnsupported;
+    }
+    
+    // Prefetch the requested blocks along with the following ones
+    pinfo("Prefetching blocks [%llu, %llu) for the sequential read [%llu, %llu).", block, block + count, block, block + nblocks);
+    
+    // The cache buffer no longer stores valid blocks once the prefetch starts
+    // Note that the sequential detector fed above remains armed for the next request
+    this->readAheadCache.fill(block, 0);
+    
+    auto action = [&](IOMemoryDescriptor* buffer) -> IOReturn
+    {
+        return this->readBlocks(block, buffer, count);
+    };
+    
+    IOReturn retVal = IOMemoryDescriptorRunActionWhilePrepared(this->readAheadCache.getBuffer(), action);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to prefetch blocks. Will service the request without the cache. Error = 0x%x.", retVal);
+        
+        return kIOReturnUnsupported;
+    }
+    
+    this->readAheadCache.fill(block, count);
+    
+    return this->readAheadCache.copyBlocks(request->getMemoryDescriptor(), block, nblocks);
+}
+
 ///
 /// Process the given request to read a single block
 ///
@@ -126,10 +1049,20 @@ UInt32 IOSDHostDriver::transformBlockOffsetIfNecessary(UInt64 block)
 ///
 IOReturn IOSDHostDriver::processReadBlockRequest(IOSDBlockRequest* request)
 {
+    // Guard: Check whether the request can be serviced by the read-ahead cache
+    IOReturn retVal = this->processReadRequestWithReadAhead(request);
+    
+    if (retVal != kIOReturnUnsupported)
+    {
+        return retVal;
+    }
+    
     pinfo("Processing the request that reads a single block...");
     
     auto creq = this->host->getRequestFactory().CMD17(this->transformBlockOffsetIfNecessary(request->getBlockOffset()), request->getMemoryDescriptor());
     
+    this->setDataTimeout(creq, kIODirectionIn);
+    
     return this->waitForRequest(creq);
 }
 
@@ -151,11 +1084,17 @@ IOReturn IOSDHostDriver::processReadBlocksRequest(IOSDBlockRequest* request)
         return this->processReadBlocksRequestSeparately(request);
     }
     
-    pinfo("Processing the request that reads multiple blocks...");
+    // Guard: Check whether the request can be serviced by the read-ahead cache
+    IOReturn retVal = this->processReadRequestWithReadAhead(request);
+    
+    if (retVal != kIOReturnUnsupported)
+    {
+        return retVal;
+    }
     
-    auto creq = this->host->getRequestFactory().CMD18(this->transformBlockOffsetIfNecessary(request->getBlockOffset()), request->getMemoryDescriptor(), request->getNumBlocks());
+    pinfo("Processing the request that reads multiple blocks...");
     
-    return this->waitForRequest(creq);
+    return this->readBlocks(request->getBlockOffset(), request->getMemoryDescriptor(), request->getNumBlocks());
 }
 
 ///
@@ -163,37 +1102,239 @@ IOReturn IOSDHostDriver::processReadBlocksRequest(IOSDBlockRequest* request)
 ///
 /// @param request A non-null block request
 /// @return `kIOReturnSuccess` on success, other values otherwise.
-/// @note The return value will be passed to the storage completion routine.
-/// @note When this function is invoked, the memory descriptor is guaranteed to be non-null and prepared.
-/// @note This function separates a CMD18 request into multiple CMD17 ones.
+/// @note The return value will be passed to the storage completion routine.
+/// @note When this function is invoked, the memory descriptor is guaranteed to be non-null and prepared.
+/// @note This function separates a CMD18 request into multiple CMD17 ones.
+///
+IOReturn IOSDHostDriver::processReadBlocksRequestSeparately(IOSDBlockRequest* request)
+{
+    pinfo("Processing the request that reads multiple blocks separately...");
+    
+    auto builder = [&](UInt32 offset, IOMemoryDescriptor* data) -> IOSDSingleBlockRequest
+    {
+        auto creq = this->host->getRequestFactory().CMD17(offset, data);
+        
+        this->setDataTimeout(creq, kIODirectionIn);
+        
+        return creq;
+    };
+    
+    return this->processAccessBlocksRequestSeparately(request, builder);
+}
+
+///
+/// Process the given request to write a single block
+///
+/// @param request A non-null block request
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note The return value will be passed to the storage completion routine.
+/// @note When this function is invoked, the memory descriptor is guaranteed to be non-null and prepared.
+///
+IOReturn IOSDHostDriver::processWriteBlockRequest(IOSDBlockRequest* request)
+{
+    pinfo("Processing the request that writes a single block...");
+    
+    this->readAheadCache.invalidate(request->getBlockOffset(), request->getNumBlocks());
+    
+    auto creq = this->host->getRequestFactory().CMD24(this->transformBlockOffsetIfNecessary(request->getBlockOffset()), request->getMemoryDescriptor());
+    
+    this->setDataTimeout(creq, kIODirectionOut);
+    
+    return this->waitForRequest(creq);
+}
+
+///
+/// [Helper] Check whether the driver should set the number of blocks to be transferred via a CMD23
+///
+/// @return `true` if the card supports the CMD23 and the current block request should use a predefined multi-block transfer, `false` otherwise.
+/// @note The card stops a predefined transfer by itself, so the driver no longer needs to send the CMD12 after the data transfer.
+///
+bool IOSDHostDriver::shouldUsePredefinedTransfer()
+{
+    return this->card->getSCR().supportsCMD23 && !UserConfigs::Card::NoCMD23 && !this->benchOpenEndedTransfers;
+}
+
+///
+/// [Helper] Get the amount of time to wait for a data transfer
+///
+/// @param direction The transfer direction
+/// @param nblocks The number of blocks to transfer
+/// @return The data timeout in milliseconds.
+/// @note The timeout consists of the data access timeout specified by the card,
+///       twice the amount of time to transfer the data at the current bus clock and bus width,
+///       and a constant slack that covers the host-side overhead.
+///       Writes allow the card to stall once more per megabyte (e.g. when it crosses an erase block).
+///       The timeout is no longer than `kMaxDataTimeout`, and write timeouts are no shorter than `kMinDataTimeout`.
+///
+UInt32 IOSDHostDriver::getDataTimeout(IODirection direction, UInt64 nblocks)
+{
+    const IOSDBusConfig& config = this->host->getHostBusConfig();
+    
+    // The amount of time for the card to start sending or to finish programming a block
+    UInt64 accessTimeout = this->card->getCSD().getDataAccessTimeout(direction, config.clock);
+    
+    if (direction != kIODirectionIn)
+    {
+        accessTimeout *= 1 + nblocks / kNumBlocksPerWriteStall;
+    }
+    
+    // The amount of time to transfer the data at the current bus clock and bus width
+    // The rate is capped, since the bus clock may be zero and the host interface (e.g. USB) may be slower than the bus
+    UInt64 busWidth = 1;
+    
+    if (config.busWidth == IOSDBusConfig::BusWidth::k4Bit)
+    {
+        busWidth = 4;
+    }
+    else if (config.busWidth == IOSDBusConfig::BusWidth::k8Bit)
+    {
+        busWidth = 8;
+    }
+    
+    UInt64 rate = static_cast<UInt64>(config.clock) * busWidth / 8;
+    
+    if (rate == 0 || rate > kMaxDataTimeoutTransferRate)
+    {
+        rate = kMaxDataTimeoutTransferRate;
+    }
+    
+    UInt64 transferTimeout = nblocks * 512 * 1000000 / rate;
+    
+    UInt64 timeout = (accessTimeout + transferTimeout * 2 + 999) / 1000 + kDataTimeoutSlack;
+    
+    // Writes are bounded below, since the card may stall while it programs the data (e.g. for garbage collection)
+    // Reads keep the computed budget, so that a card that stops responding is detected sooner
+    if (direction != kIODirectionIn && timeout < kMinDataTimeout)
+    {
+        return kMinDataTimeout;
+    }
+    
+    return timeout > kMaxDataTimeout ? kMaxDataTimeout : static_cast<UInt32>(timeout);
+}
+
+///
+/// [Helper] Set the data timeout of the given request that accesses a single block
+///
+/// @param request A request that reads or writes a single block
+/// @param direction The transfer direction
+/// @note The timeout is recorded in the statistics of the block request being serviced.
+///
+void IOSDHostDriver::setDataTimeout(IOSDSingleBlockRequest& request, IODirection direction)
+{
+    UInt32 timeout = this->getDataTimeout(direction, request.data.getNumBlocks());
+    
+    request.data.setTimeout(timeout);
+    
+    // Record the timeout actually applied, since a block request may be serviced with multiple transactions
+    this->maxAppliedDataTimeout = max(this->maxAppliedDataTimeout, timeout);
+    
+    this->totalAppliedDataTimeout += timeout;
+}
+
+///
+/// [Helper] Set the data timeout and the busy timeout of the given request that accesses multiple blocks
+///
+/// @param request A request that reads or writes multiple blocks
+/// @param direction The transfer direction
+/// @note The card may program the last blocks after a write is stopped,
+///       so the busy timeout of the STOP command is the write access timeout but no less than `kMinDataTimeout`.
+///
+void IOSDHostDriver::setDataTimeout(IOSDMultiBlocksRequest& request, IODirection direction)
+{
+    this->setDataTimeout(static_cast<IOSDSingleBlockRequest&>(request), direction);
+    
+    if (direction != kIODirectionIn)
+    {
+        UInt32 accessTimeout = this->card->getCSD().getDataAccessTimeout(direction, this->host->getHostBusConfig().clock);
+        
+        UInt32 busyTimeout = (accessTimeout + 999) / 1000 + kDataTimeoutSlack;
+        
+        request.stopCommand.setBusyTimeout(busyTimeout < kMinDataTimeout ? kMinDataTimeout : busyTimeout);
+    }
+}
+
+///
+/// [Helper] Read multiple blocks to the given buffer with a single CMD18
+///
+/// @param block The starting block number
+/// @param data A non-null, prepared memory descriptor that stores the data read from the card
+/// @param nblocks The number of blocks to read
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note The host device sends the CMD23 along with the CMD18 in the same session if the card supports it.
+///
+IOReturn IOSDHostDriver::readBlocks(UInt64 block, IOMemoryDescriptor* data, UInt64 nblocks)
+{
+    auto creq = this->host->getRequestFactory().CMD18(this->transformBlockOffsetIfNecessary(block), data, nblocks);
+    
+    this->setDataTimeout(creq, kIODirectionIn);
+    
+    // Guard: Check if the driver should set the number of blocks for the incoming request
+    if (this->shouldUsePredefinedTransfer())
+    {
+        pinfo("Will issue a CMD23 to set the number of blocks to be read.");
+        
+        creq.setBlockCount();
+    }
+    
+    return this->waitForRequest(creq);
+}
+
+///
+/// [Helper] Write the given data to multiple blocks with a single CMD25
+///
+/// @param block The starting block number
+/// @param data A non-null, prepared memory descriptor that contains the data to be written
+/// @param nblocks The number of blocks to write
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note The host device sends the CMD23 or the CMD55 + ACMD23 along with the CMD25 in the same session unless the user disables it.
 ///
-IOReturn IOSDHostDriver::processReadBlocksRequestSeparately(IOSDBlockRequest* request)
+IOReturn IOSDHostDriver::writeBlocks(UInt64 block, IOMemoryDescriptor* data, UInt64 nblocks)
 {
-    pinfo("Processing the request that reads multiple blocks separately...");
+    auto creq = this->host->getRequestFactory().CMD25(this->transformBlockOffsetIfNecessary(block), data, nblocks);
     
-    auto builder = [&](UInt32 offset, IOMemoryDescriptor* data) -> IOSDSingleBlockRequest
+    this->setDataTimeout(creq, kIODirectionOut);
+    
+    // Guard: Check if the driver should set the number of blocks for the incoming request
+    // The host device sends the CMD23 or the CMD55 + ACMD23 along with the CMD25 in the same session.
+    if (LIKELY(!UserConfigs::Card::NoACMD23))
     {
-        return this->host->getRequestFactory().CMD17(offset, data);
-    };
+        passert(nblocks <= ((1 << 23) - 1), "The number of blocks should be less than 2^23 - 1.");
+        
+        if (this->shouldUsePredefinedTransfer())
+        {
+            pinfo("Will issue a CMD23 to set the number of blocks to be written.");
+            
+            creq.setBlockCount();
+        }
+        else
+        {
+            pinfo("Will issue an ACMD23 to set the number of pre-erased blocks.");
+            
+            creq.setPreEraseBlockCount(this->card->getRCA());
+        }
+    }
+    else
+    {
+        pinfo("User requests not to issue the ACMD23 before the CMD25.");
+    }
     
-    return this->processAccessBlocksRequestSeparately(request, builder);
+    return this->waitForRequest(creq);
 }
 
 ///
-/// Process the given request to write a single block
+/// Get the number of blocks that the transactions of a large write should be aligned to
 ///
-/// @param request A non-null block request
-/// @return `kIOReturnSuccess` on success, other values otherwise.
-/// @note The return value will be passed to the storage completion routine.
-/// @note When this function is invoked, the memory descriptor is guaranteed to be non-null and prepared.
+/// @return The number of 512-byte blocks in an allocation unit of the card, 0 if writes should not be aligned.
+/// @note This function is invoked on the processor workloop by the block request itself.
 ///
-IOReturn IOSDHostDriver::processWriteBlockRequest(IOSDBlockRequest* request)
+UInt64 IOSDHostDriver::getWriteAlignment()
 {
-    pinfo("Processing the request that writes a single block...");
-    
-    auto creq = this->host->getRequestFactory().CMD24(this->transformBlockOffsetIfNecessary(request->getBlockOffset()), request->getMemoryDescriptor());
+    if (UserConfigs::Card::NoAUAlignedWrites || this->card == nullptr)
+    {
+        return 0;
+    }
     
-    return this->waitForRequest(creq);
+    return this->card->getSSR().getWriteAlignment();
 }
 
 ///
@@ -206,6 +1347,13 @@ IOReturn IOSDHostDriver::processWriteBlockRequest(IOSDBlockRequest* request)
 ///
 IOReturn IOSDHostDriver::processWriteBlocksRequest(IOSDBlockRequest* request)
 {
+    UInt64 block = request->getBlockOffset();
+    
+    UInt64 nblocks = request->getNumBlocks();
+    
+    // Invalidate prefetched blocks that are about to be overwritten
+    this->readAheadCache.invalidate(block, nblocks);
+    
     // Guard: Check if the driver should separate the incoming request
     if (UNLIKELY(UserConfigs::Card::SeparateAccessBlocksRequest))
     {
@@ -214,38 +1362,10 @@ IOReturn IOSDHostDriver::processWriteBlocksRequest(IOSDBlockRequest* request)
         return this->processWriteBlocksRequestSeparately(request);
     }
     
-    // Guard: Check if the driver should issue the ACMD23 for the incoming request
-    if (LIKELY(!UserConfigs::Card::NoACMD23))
-    {
-        // Issue the ACMD23 to set the number of pre-erased blocks
-        pinfo("Issuing an ACMD23 to set the number of pre-erased blocks...");
-        
-        passert(request->getNumBlocks() <= ((1 << 23) - 1), "The number of blocks should be less than 2^23 - 1.");
-        
-        auto preq = this->host->getRequestFactory().ACMD23(static_cast<UInt32>(request->getNumBlocks()));
-        
-        IOReturn retVal = this->waitForAppRequest(preq, this->card->getRCA());
-        
-        if (retVal != kIOReturnSuccess)
-        {
-            perr("Failed to issue the ACMD23 to set the number of pre-erased blocks. Error = 0x%x.", retVal);
-            
-            return retVal;
-        }
-        
-        pinfo("The ACMD23 has been issued.");
-    }
-    else
-    {
-        pinfo("User requests not to issue the ACMD23 before the CMD25.");
-    }
-    
     // Process the block request
     pinfo("Processing the request that writes multiple blocks...");
     
-    auto creq = this->host->getRequestFactory().CMD25(this->transformBlockOffsetIfNecessary(request->getBlockOffset()), request->getMemoryDescriptor(), request->getNumBlocks());
-    
-    return this->waitForRequest(creq);
+    return this->writeBlocks(block, request->getMemoryDescriptor(), nblocks);
 }
 
 ///
@@ -263,7 +1383,11 @@ IOReturn IOSDHostDriver::processWriteBlocksRequestSeparately(IOSDBlockRequest* r
     
     auto builder = [&](UInt32 offset, IOMemoryDescriptor* data) -> IOSDSingleBlockRequest
     {
-        return this->host->getRequestFactory().CMD24(offset, data);
+        auto creq = this->host->getRequestFactory().CMD24(offset, data);
+        
+        this->setDataTimeout(creq, kIODirectionOut);
+        
+        return creq;
     };
     
     return this->processAccessBlocksRequestSeparately(request, builder);
@@ -280,6 +1404,21 @@ void IOSDHostDriver::finalizeBlockRequest(IOSDBlockRequest* request)
 {
     pinfo("The given request has been processed.");
     
+    // Finalize requests that have been merged into the given one
+    IOSDSimpleBlockRequest* sreq = OSDynamicCast(IOSDSimpleBlockRequest, request);
+    
+    if (sreq != nullptr)
+    {
+        IOSDSimpleBlockRequest* mreq = nullptr;
+        
+        while ((mreq = sreq->detachMergedRequest()) != nullptr)
+        {
+            mreq->deinit();
+            
+            this->releaseBlockRequestToPool(mreq);
+        }
+    }
+    
     request->deinit();
     
     this->releaseBlockRequestToPool(request);
@@ -1346,6 +2485,179 @@ IOReturn IOSDHostDriver::CMD13(UInt32 rca, UInt32& status)
     return kIOReturnSuccess;
 }
 
+///
+/// CMD13: Send the queue status
+///
+/// @param rca The card relative address
+/// @param qsr The queue status on return (i.e. one bit per task that is ready for execution)
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+///
+IOReturn IOSDHostDriver::CMD13q(UInt32 rca, UInt32& qsr)
+{
+    auto request = this->host->getRequestFactory().CMD13q(rca);
+    
+    IOReturn retVal = this->waitForRequest(request);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to initiate the CMD13. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    qsr = request.command.reinterpretResponseAs<IOSDHostResponse1>()->getStatus();
+    
+    return kIOReturnSuccess;
+}
+
+///
+/// CMD32: Set the address of the first block to be erased
+///
+/// @param offset The starting block number (SDHC/XC) or byte offset (SDSC)
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces a portion of `mmc_do_erase()` defined in `core.c`.
+///
+IOReturn IOSDHostDriver::CMD32(UInt32 offset)
+{
+    auto request = this->host->getRequestFactory().CMD32(offset);
+    
+    return this->waitForRequest(request);
+}
+
+///
+/// CMD33: Set the address of the last block to be erased
+///
+/// @param offset The last block number (SDHC/XC) or byte offset (SDSC)
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces a portion of `mmc_do_erase()` defined in `core.c`.
+///
+IOReturn IOSDHostDriver::CMD33(UInt32 offset)
+{
+    auto request = this->host->getRequestFactory().CMD33(offset);
+    
+    return this->waitForRequest(request);
+}
+
+///
+/// CMD38: Erase the blocks selected by the CMD32 and the CMD33
+///
+/// @param argument The erase function (i.e. `kEraseArgumentErase` or `kEraseArgumentDiscard`)
+/// @param timeout The amount of time in milliseconds to wait for the card to release the busy signal
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces a portion of `mmc_do_erase()` defined in `core.c`.
+///
+IOReturn IOSDHostDriver::CMD38(UInt32 argument, UInt32 timeout)
+{
+    auto request = this->host->getRequestFactory().CMD38(argument, timeout);
+    
+    return this->waitForRequest(request);
+}
+
+///
+/// CMD43: Manage the command queue
+///
+/// @param argument The queue management operation (e.g. `kQueueManagementAbortAll`)
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+///
+IOReturn IOSDHostDriver::CMD43(UInt32 argument)
+{
+    auto request = this->host->getRequestFactory().CMD43(argument);
+    
+    return this->waitForRequest(request);
+}
+
+///
+/// CMD44: Queue a task and specify its parameters
+///
+/// @param argument The transfer direction, the task ID and the number of blocks
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+///
+IOReturn IOSDHostDriver::CMD44(UInt32 argument)
+{
+    auto request = this->host->getRequestFactory().CMD44(argument);
+    
+    return this->waitForRequest(request);
+}
+
+///
+/// CMD45: Specify the start address of the task queued by the preceding CMD44
+///
+/// @param offset The starting block number (SDHC/XC) or byte offset (SDSC)
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+///
+IOReturn IOSDHostDriver::CMD45(UInt32 offset)
+{
+    auto request = this->host->getRequestFactory().CMD45(offset);
+    
+    return this->waitForRequest(request);
+}
+
+///
+/// CMD48: Read an extension register
+///
+/// @param argument The function number, the address and the length of the register
+/// @param buffer A non-null buffer that stores the register value on return
+/// @param length Specify the number of bytes read from the register (must not exceed 512 bytes)
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces `sd_read_ext_reg()` defined in `sd.c`.
+/// @note This function allocates an internal 512-byte DMA capable buffer to store the data block from the card.
+///       The register value is then copied to the given `buffer`.
+///
+IOReturn IOSDHostDriver::CMD48(UInt32 argument, UInt8* buffer, IOByteCount length)
+{
+    auto action = [&](IOMemoryDescriptor* descriptor) -> IOReturn
+    {
+        auto request = this->host->getRequestFactory().CMD48(argument, descriptor);
+        
+        IOReturn retVal = this->waitForRequest(request);
+        
+        if (retVal == kIOReturnSuccess)
+        {
+            // Copy the register value from the memory descriptor
+            length = min(length, 512);
+            
+            retVal = descriptor->readBytes(0, buffer, length) == length ? kIOReturnSuccess : kIOReturnError;
+        }
+        
+        return retVal;
+    };
+    
+    return IOMemoryDescriptorRunActionWithWiredBuffer(512, kIODirectionInOut, action);
+}
+
+///
+/// CMD49: Write a single byte to an extension register
+///
+/// @param argument The function number, the address and the length of the register
+/// @param value The value to be written
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces a portion of `sd_write_ext_reg()` defined in `sd.c`.
+/// @note This function allocates an internal 512-byte DMA capable buffer to send the data block to the card.
+///
+IOReturn IOSDHostDriver::CMD49(UInt32 argument, UInt8 value)
+{
+    auto action = [&](IOMemoryDescriptor* descriptor) -> IOReturn
+    {
+        // The card takes the value from the first byte and ignores the rest of the data block
+        UInt8 data[512] = {};
+        
+        data[0] = value;
+        
+        if (descriptor->writeBytes(0, data, sizeof(data)) != sizeof(data))
+        {
+            perr("Failed to copy the value to the data block.");
+            
+            return kIOReturnError;
+        }
+        
+        auto request = this->host->getRequestFactory().CMD49(argument, descriptor);
+        
+        return this->waitForRequest(request);
+    };
+    
+    return IOMemoryDescriptorRunActionWithWiredBuffer(512, kIODirectionInOut, action);
+}
+
 ///
 /// CMD55: Tell the card that the next command is an application command
 ///
@@ -1969,6 +3281,12 @@ void IOSDHostDriver::detachCard(IOSDCard::Completion* completion, IOSDCard::Even
         // Cache the card identification data when the computer sleeps
         this->pcid = this->card->getCID();
         
+        // The card is still present when the computer sleeps, so write back data held in its cache before it loses power
+        if (options.contains(IOSDCard::EventOption::kPowerManagementContext) && this->card->isCacheEnabled())
+        {
+            psoftassert(this->flushCardCacheGated() == kIOReturnSuccess, "Failed to flush the card cache before the computer sleeps.");
+        }
+        
         pinfo("Stopping the card device...");
         
         this->card->stop(this);
@@ -1992,6 +3310,32 @@ void IOSDHostDriver::detachCard(IOSDCard::Completion* completion, IOSDCard::Even
     // Recycle all pending requests
     this->recyclePendingBlockRequest();
     
+    // Blocks prefetched from the card are no longer valid
+    this->readAheadCache.invalidate();
+    
+    // Print, publish and reset the statistics of block requests serviced so far
+    if (UserConfigs::Card::CollectBlockRequestStatistics)
+    {
+        this->statistics.print(UserConfigs::Card::BenchPredefinedTransfers ? "Block Request Statistics (Predefined Transfers)" : kIOSDBlockRequestStatistics);
+        
+        this->publishBlockRequestStatistics(kIOSDBlockRequestStatistics, this->statistics);
+        
+        this->statistics.reset();
+        
+        if (UserConfigs::Card::BenchPredefinedTransfers)
+        {
+            this->openEndedStatistics.print(kIOSDBlockRequestStatisticsOpenEnded);
+            
+            this->publishBlockRequestStatistics(kIOSDBlockRequestStatisticsOpenEnded, this->openEndedStatistics);
+            
+            this->openEndedStatistics.reset();
+        }
+        
+        this->simpleBlockRequestPool->printStatistics("Simple Block Request Pool");
+        
+        this->complexBlockRequestPool->printStatistics("Complex Block Request Pool");
+    }
+    
     // Power off the bus
     psoftassert(this->powerOff() == kIOReturnSuccess, "Failed to power off the bus.");
     
@@ -2288,34 +3632,35 @@ IOReturn IOSDHostDriver::getCardSerialNumber(UInt32& serial)
     return IOCommandGateRunAction(this->processorCommandGate, action);
 }
 
-//
-// MARK: - Startup Routines
-//
-
 ///
-/// Setup the shared work loop to protect the pool and the queue
+/// Check whether the card supports erase commands
 ///
-/// @return `true` on success, `false` otherwise.
-/// @note Upon an unsuccessful return, all resources allocated by this function are released.
+/// @param result Set `true` if the card supports the erase command class, `false` otherwise.
+/// @return `kIOReturnSuccess` on success, `kIOReturnNoMedia` if the card is not present.
 ///
-bool IOSDHostDriver::setupSharedWorkLoop()
+IOReturn IOSDHostDriver::isCardEraseSupported(bool& result)
 {
-    pinfo("Creating the shared work loop...");
-    
-    this->sharedWorkLoop = IOWorkLoop::workLoop();
-    
-    if (this->sharedWorkLoop == nullptr)
+    auto action = [&]() -> IOReturn
     {
-        perr("Failed to create the shared work loop.");
+        if (this->card == nullptr)
+        {
+            perr("The card is not present.");
+            
+            return kIOReturnNoMedia;
+        }
         
-        return false;
-    }
-    
-    pinfo("The shared work loop has been created.");
+        result = BitOptions(this->card->getCSD().cardCommandClasses).contains(CSD::CommandClass::kErase);
+        
+        return kIOReturnSuccess;
+    };
     
-    return true;
+    return IOCommandGateRunAction(this->processorCommandGate, action);
 }
 
+//
+// MARK: - Startup Routines
+//
+
 ///
 /// Setup the SD block request pool
 ///
@@ -2326,7 +3671,7 @@ bool IOSDHostDriver::setupBlockRequestPool()
 {
     pinfo("Creating the block request pool...");
     
-    this->simpleBlockRequestPool = IOSDSimpleBlockRequestPool::createWithCapacity(this->sharedWorkLoop, IOSDHostDriver::kDefaultPoolSize);
+    this->simpleBlockRequestPool = IOSDSimpleBlockRequestPool::createWithCapacity(IOSDHostDriver::kDefaultPoolSize, IOSDHostDriver::kMaxPoolSize);
     
     if (this->simpleBlockRequestPool == nullptr)
     {
@@ -2335,7 +3680,7 @@ bool IOSDHostDriver::setupBlockRequestPool()
         return false;
     }
     
-    this->complexBlockRequestPool = IOSDComplexBlockRequestPool::createWithCapacity(this->sharedWorkLoop, IOSDHostDriver::kDefaultPoolSize);
+    this->complexBlockRequestPool = IOSDComplexBlockRequestPool::createWithCapacity(IOSDHostDriver::kDefaultPoolSize, IOSDHostDriver::kMaxPoolSize);
     
     if (this->complexBlockRequestPool == nullptr)
     {
@@ -2363,7 +3708,7 @@ bool IOSDHostDriver::setupBlockRequestQueue()
 {
     pinfo("Creating the block request queue...");
     
-    this->pendingRequests = IOSDBlockRequestQueue::create(this->sharedWorkLoop);
+    this->pendingRequests = IOSDBlockRequestQueue::create();
     
     if (this->pendingRequests == nullptr)
     {
@@ -2614,14 +3959,6 @@ bool IOSDHostDriver::setupCard()
 // MARK: - Teardown Routines
 //
 
-///
-/// Tear down the shared workloop
-///
-void IOSDHostDriver::tearDownSharedWorkLoop()
-{
-    OSSafeReleaseNULL(this->sharedWorkLoop);
-}
-
 ///
 /// Tear down the SD block request pool
 ///
@@ -2769,40 +4106,56 @@ bool IOSDHostDriver::start(IOService* provider)
     
     this->host->retain();
     
-    // Setup the shared work loop
-    if (!this->setupSharedWorkLoop())
+    this->statistics.reset();
+    
+    this->openEndedStatistics.reset();
+    
+    this->benchOpenEndedTransfers = false;
+    
+    this->maxAppliedDataTimeout = 0;
+    
+    this->totalAppliedDataTimeout = 0;
+    
+    // Setup the read-ahead cache
+    // The cache is filled by a single CMD18, so its capacity is limited by the maximum DMA transaction size
+    // The driver can still service requests without the cache if it fails to allocate the buffer
+    UInt64 nblocks = this->host->getDMALimits().maxRequestNumBlocks();
+    
+    if (UserConfigs::Card::ReadAheadNumBlocks < nblocks)
     {
-        goto error1;
+        nblocks = UserConfigs::Card::ReadAheadNumBlocks;
     }
     
+    psoftassert(this->readAheadCache.setUp(nblocks), "Failed to set up the read-ahead cache.");
+    
     // Create the block request pool
     if (!this->setupBlockRequestPool())
     {
-        goto error2;
+        goto error1;
     }
     
     // Create the request queue
     if (!this->setupBlockRequestQueue())
     {
-        goto error3;
+        goto error2;
     }
     
     // Create the processor work loop
     if (!this->setupProcessorWorkLoop())
     {
-        goto error4;
+        goto error3;
     }
     
     // Create the block request event source
     if (!this->setupBlockRequestEventSource())
     {
-        goto error5;
+        goto error4;
     }
     
     // Create the card insertion and removal event sources
     if (!this->setupCardEventSources())
     {
-        goto error6;
+        goto error5;
     }
     
     // Publish the service to start the block storage device
@@ -2817,22 +4170,21 @@ bool IOSDHostDriver::start(IOService* provider)
     
     return true;
     
-error6:
-    this->tearDownBlockRequestEventSource();
-    
 error5:
-    this->tearDownProcessorWorkLoop();
+    this->tearDownBlockRequestEventSource();
     
 error4:
-    this->tearDownBlockRequestQueue();
+    this->tearDownProcessorWorkLoop();
     
 error3:
-    this->tearDownBlockRequestPool();
+    this->tearDownBlockRequestQueue();
     
 error2:
-    this->tearDownSharedWorkLoop();
+    this->tearDownBlockRequestPool();
     
 error1:
+    this->readAheadCache.tearDown();
+    
     OSSafeReleaseNULL(this->host);
     
     pinfo("===================================");
@@ -2861,7 +4213,7 @@ void IOSDHostDriver::stop(IOService* provider)
     
     this->tearDownBlockRequestPool();
     
-    this->tearDownSharedWorkLoop();
+    this->readAheadCache.tearDown();
     
     OSSafeReleaseNULL(this->host);
     
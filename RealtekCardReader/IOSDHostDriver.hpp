@@ -11,7 +11,7 @@
 #include <IOKit/IOCommandGate.h>
 #include <IOKit/IOSubMemoryDescriptor.h>
 #include <IOKit/storage/IOBlockStorageDriver.h>
-#include "IOEnhancedCommandPool.hpp"
+#include "IOCachedCommandPool.hpp"
 #include "IOSDHostDevice.hpp"
 #include "IOSDHostRequest.hpp"
 #include "IOSDBusConfig.hpp"
@@ -20,6 +20,8 @@
 #include "IOSDComplexBlockRequest.hpp"
 #include "IOSDBlockRequestQueue.hpp"
 #include "IOSDBlockRequestEventSource.hpp"
+#include "IOSDBlockRequestStatistics.hpp"
+#include "IOSDReadAheadCache.hpp"
 #include "IOSDCard.hpp"
 #include "IOSDCardEventSource.hpp"
 #include "Utilities.hpp"
@@ -43,10 +45,10 @@ class IOSDHostDriver: public IOService
     //
     
     /// Type of the pool of simple block requests
-    using IOSDSimpleBlockRequestPool = IOEnhancedCommandPool<IOSDSimpleBlockRequest>;
+    using IOSDSimpleBlockRequestPool = IOCachedCommandPool<IOSDSimpleBlockRequest>;
     
     /// Type of the pool of complex block requests
-    using IOSDComplexBlockRequestPool = IOEnhancedCommandPool<IOSDComplexBlockRequest>;
+    using IOSDComplexBlockRequestPool = IOCachedCommandPool<IOSDComplexBlockRequest, IOSDComplexBlockRequestCreator>;
     
     //
     // MARK: - Private Properties
@@ -55,22 +57,65 @@ class IOSDHostDriver: public IOService
     /// The default pool size
     static constexpr IOItemCount kDefaultPoolSize = 32;
     
+    /// The maximum pool size that a pool can grow to under load
+    static constexpr IOItemCount kMaxPoolSize = 256;
+    
+    /// The CMD38 argument that asks the card to erase blocks
+    static constexpr UInt32 kEraseArgumentErase = 0x00000000;
+    
+    /// The CMD38 argument that asks the card to discard blocks (SD 5.0 and later)
+    static constexpr UInt32 kEraseArgumentDiscard = 0x00000001;
+    
+    /// The maximum number of blocks erased by a single CMD38 if the card does not specify its allocation unit
+    static constexpr UInt64 kDefaultMaxNumEraseBlocks = 8192;
+    
+    /// The amount of time in milliseconds to wait for the card to finish writing an extension register
+    static constexpr UInt32 kWriteExtensionRegisterTimeout = 1000;
+    
+    /// The amount of time in milliseconds to wait for the card to flush its cache
+    static constexpr UInt32 kFlushCacheTimeout = 1000;
+    
+    /// The maximum number of blocks accessed by a read request that is queued as a separate task
+    static constexpr UInt64 kMaxNumQueuedReadBlocks = 8;
+    
+    /// The amount of time in milliseconds to wait for queued tasks to become ready for execution
+    static constexpr UInt32 kQueuedTaskTimeout = 1000;
+    
+    /// The CMD43 argument that asks the card to abort all queued tasks
+    static constexpr UInt32 kQueueManagementAbortAll = 0x00000001;
+    
+    /// The CMD44 argument bit that specifies a read task
+    static constexpr UInt32 kQueueTaskDirectionRead = 1 << 30;
+    
+    /// The amount of time in milliseconds added to each data timeout to cover the host-side overhead
+    static constexpr UInt32 kDataTimeoutSlack = 100;
+    
+    /// The minimum amount of time in milliseconds to wait for a write data transfer or for the card to finish a write
+    static constexpr UInt32 kMinDataTimeout = 3000;
+    
+    /// The maximum amount of time in milliseconds to wait for a data transfer
+    static constexpr UInt32 kMaxDataTimeout = 10000;
+    
+    /// The highest transfer rate in bytes per second assumed by the data timeout,
+    /// since the host interface (e.g. USB) may be slower than the bus clock and the bus width suggest
+    static constexpr UInt64 kMaxDataTimeoutTransferRate = 20 * 1024 * 1024;
+    
+    /// The number of blocks written between two stalls of the card assumed by the data timeout (1 MB)
+    static constexpr UInt64 kNumBlocksPerWriteStall = 2048;
+    
     /// The SD host device (provider)
     IOSDHostDevice* host;
     
     /// The SD block storage device (client)
     IOSDBlockStorageDevice* blockStorageDevice;
     
-    /// A shared workloop that serializes the access to the pools and the queues
-    IOWorkLoop* sharedWorkLoop;
-    
     /// A request pool that contains preallocated simple SD block requests
     IOSDSimpleBlockRequestPool* simpleBlockRequestPool;
     
     /// A request pool that contains preallocated complex SD block requests
     IOSDComplexBlockRequestPool* complexBlockRequestPool;
     
-    /// A list of pending requests (a subclass of `IOCommandPool` with convenient methods)
+    /// A list of pending requests (a lock-free queue for producers)
     IOSDBlockRequestQueue* pendingRequests;
     
     /// A dedicated workloop that initializes the card and processes the block request
@@ -113,6 +158,41 @@ class IOSDHostDriver: public IOService
     ///
     CID pcid;
     
+    ///
+    /// Statistics of block requests serviced since the card is attached
+    ///
+    /// @note Statistics are collected only if the user has specified the boot argument `-iosdbrs`.
+    ///
+    IOSDBlockRequestStatistics statistics;
+    
+    ///
+    /// Statistics of block requests serviced with open-ended multi-block transfers in the bench mode
+    ///
+    /// @note Statistics are collected only if the user has specified the boot argument `-iosdbpt`.
+    ///       In this mode, `statistics` only includes requests serviced with predefined multi-block transfers.
+    ///
+    IOSDBlockRequestStatistics openEndedStatistics;
+    
+    ///
+    /// `true` if the current block request should be serviced with open-ended multi-block transfers
+    ///
+    /// @note The host driver alternates between the two transfer modes for each block request in the bench mode.
+    ///
+    bool benchOpenEndedTransfers;
+    
+    /// The longest data timeout in milliseconds applied to a transaction of the current block request
+    UInt32 maxAppliedDataTimeout;
+    
+    /// The sum of data timeouts in milliseconds applied to the transactions of the current block request
+    UInt64 totalAppliedDataTimeout;
+    
+    ///
+    /// A cache of blocks prefetched for sequential reads
+    ///
+    /// @note The cache is enabled only if the user has specified a non-zero read-ahead size via the boot argument `iosdrab`.
+    ///
+    IOSDReadAheadCache readAheadCache;
+    
     //
     // MARK: - Pool Management
     //
@@ -251,6 +331,250 @@ public:
         return this->submitBlockRequest(processor, buffer, block, nblocks, attributes, completion);
     }
     
+    //
+    // MARK: - Discard Blocks
+    //
+    
+private:
+    ///
+    /// [Helper] Wait until the card finishes programming and returns to the transfer state
+    ///
+    /// @param timeout The amount of time in milliseconds to wait for the card
+    /// @param errors The card status bits that indicate the failure of the previous operation
+    /// @return `kIOReturnSuccess` on success, `kIOReturnIOError` if the card reports any of the given errors,
+    ///         `kIOReturnTimeout` if the card is still busy after the given amount of time, other values otherwise.
+    /// @note This function must be invoked on the processor workloop.
+    ///
+    IOReturn waitForCardReady(UInt32 timeout, UInt32 errors);
+    
+    ///
+    /// [Helper] Erase the given range of blocks with a single erase sequence
+    ///
+    /// @param block The starting block number
+    /// @param nblocks The number of blocks to erase
+    /// @param argument The CMD38 argument that specifies the erase function
+    /// @param timeout The amount of time in milliseconds to wait for the card to finish the operation
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces `mmc_do_erase()` defined in `core.c`.
+    /// @note This function must be invoked on the processor workloop.
+    ///
+    IOReturn eraseBlocksGated(UInt64 block, UInt64 nblocks, UInt32 argument, UInt32 timeout);
+    
+public:
+    ///
+    /// Discard the given range of blocks on the card
+    ///
+    /// @param block The starting block number
+    /// @param nblocks The number of blocks to discard
+    /// @return `kIOReturnSuccess` on success, `kIOReturnNoMedia` if the card is not present,
+    ///         `kIOReturnUnsupported` if the card does not support erase commands, other values otherwise.
+    /// @note This function runs synchronously on the processor workloop, so it is serialized with block requests.
+    /// @note The card discards the given blocks if it supports the discard function, otherwise it erases them.
+    ///       The range is split into multiple erase sequences so that each one is bounded by the erase timeout.
+    ///
+    IOReturn discardBlocks(UInt64 block, UInt64 nblocks);
+    
+    //
+    // MARK: - Card Cache
+    //
+    
+private:
+    ///
+    /// [Helper] Flush the cache of the card
+    ///
+    /// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if the card fails to flush its cache in time, other values otherwise.
+    /// @note Port: This function replaces `sd_flush_cache()` defined in `sd.c`.
+    /// @note This function must be invoked on the processor workloop.
+    ///
+    IOReturn flushCardCacheGated();
+    
+public:
+    ///
+    /// Write the given value to a register in the given extension register set
+    ///
+    /// @param address The address of the extension register set
+    /// @param position The offset of the register relative to the start of the register set
+    /// @param value The value to be written
+    /// @param timeout The amount of time in milliseconds to wait for the card to finish the operation, by default `kWriteExtensionRegisterTimeout`
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces `sd_write_ext_reg()` defined in `sd.c`.
+    /// @note This function must be invoked on the processor workloop or while the card is being initialized.
+    ///
+    IOReturn writeExtensionRegister(const ExtensionRegister& address, UInt32 position, UInt8 value, UInt32 timeout = kWriteExtensionRegisterTimeout);
+    
+    ///
+    /// Flush the cache of the card
+    ///
+    /// @return `kIOReturnSuccess` on success or if the cache is not enabled, `kIOReturnNoMedia` if the card is not present,
+    ///         other values otherwise.
+    /// @note This function runs synchronously on the processor workloop, so it is serialized with block requests.
+    ///
+    IOReturn flushCardCache();
+    
+    //
+    // MARK: - Block Request Statistics
+    //
+    
+private:
+    ///
+    /// [Helper] Publish the given statistics of block requests in the I/O Registry
+    ///
+    /// @param key The name of the property
+    /// @param statistics The statistics of block requests serviced so far
+    /// @note The property reflects the statistics collected while the last card was present.
+    ///       It is updated when the card is removed, so that the registry is not touched on the I/O path.
+    ///
+    void publishBlockRequestStatistics(const char* key, const IOSDBlockRequestStatistics& statistics);
+    
+public:
+    ///
+    /// Notify the host driver that a block request is about to be serviced
+    ///
+    /// @param snapshot The state captured before the request is serviced on return
+    /// @note This function is invoked on the processor workloop by the block request itself.
+    ///
+    void willServiceBlockRequest(IOSDBlockRequestStatistics::Snapshot& snapshot);
+    
+    ///
+    /// Notify the host driver that a block request has been serviced
+    ///
+    /// @param snapshot The state captured before the request is serviced
+    /// @param direction The transfer direction of the request
+    /// @param nblocks The number of blocks to transfer
+    /// @param status The service status of the request
+    /// @note This function is invoked on the processor workloop by the block request itself.
+    ///
+    void didServiceBlockRequest(const IOSDBlockRequestStatistics::Snapshot& snapshot, IODirection direction, UInt64 nblocks, IOReturn status);
+    
+    //
+    // MARK: - Request Pipelining
+    //
+    
+public:
+    ///
+    /// [UPCALL] Notify the host driver that a DMA transfer has started and is now in flight
+    ///
+    /// @note This callback function is invoked on the processor workloop while the current block request is being serviced.
+    ///       It runs outside the gate of the card reader controller, so the current transfer may complete in the meantime.
+    /// @note The host driver asks the host device to prepare the DMA transfer of the next pending request,
+    ///       hiding the setup latency of the next request behind the current transfer.
+    ///
+    void onDMATransferInFlight();
+    
+    ///
+    /// Release the DMA transfer prepared ahead of time for the given request if it has not been performed
+    ///
+    /// @param request A non-null block request that has just been serviced
+    /// @note This function is invoked on the processor workloop by the block request itself.
+    ///
+    void didServiceBlockRequestAhead(IOSDBlockRequest* request);
+    
+private:
+    ///
+    /// [Helper] Check whether the given pending request is likely to be serviced by a DMA transfer of its own buffer
+    ///
+    /// @param request A non-null simple block request at the head of the queue
+    /// @return `false` if the request will be serviced by the read-ahead cache, merged with another pending request,
+    ///         or queued along with other random reads, `true` otherwise.
+    /// @note This function shares its predicates with the routines that service the request.
+    ///
+    bool willTransferBlockRequestAsIs(IOSDSimpleBlockRequest* request);
+    
+    ///
+    /// [Helper] Check whether the given request will be serviced by the blocks stored in the read-ahead cache
+    ///
+    /// @param request A non-null block request
+    /// @return `true` if the request reads blocks that are all stored in the cache, `false` otherwise.
+    ///
+    bool isCachedReadRequest(IOSDBlockRequest* request);
+    
+    //
+    // MARK: - Request Merging
+    //
+    
+private:
+    ///
+    /// [Helper] Check whether pending requests that access adjacent blocks can be merged
+    ///
+    /// @return `true` if the user does not disable request merging, `false` otherwise.
+    ///
+    bool isRequestMergingEnabled();
+    
+    ///
+    /// [Helper] Check whether the given pending request can be merged into the given request
+    ///
+    /// @param request A non-null simple block request that is about to be serviced
+    /// @param other A non-null pending block request
+    /// @return `true` if the other request accesses blocks adjacent to the given request within the DMA limit, `false` otherwise.
+    ///
+    bool canMergeBlockRequests(IOSDSimpleBlockRequest* request, IOSDBlockRequest* other);
+    
+public:
+    ///
+    /// Merge pending requests that access blocks adjacent to the given request into it
+    ///
+    /// @param request A non-null simple block request that is about to be serviced
+    /// @note This function is invoked on the processor workloop by the block request itself.
+    /// @note Merged requests are removed from the queue and are serviced in one DMA transaction along with the given request.
+    ///       They are completed individually and are returned to the pool when the given request is finalized.
+    ///
+    void mergeAdjacentBlockRequests(IOSDSimpleBlockRequest* request);
+    
+    //
+    // MARK: - Command Queue
+    //
+    
+private:
+    ///
+    /// [Helper] Get the number of random reads that can be queued in the command queue of the card
+    ///
+    /// @return The queue depth of the card, 0 if the user does not enable the command queue or if queueing brings no benefit.
+    ///
+    IOItemCount getRandomReadQueueDepth();
+    
+    ///
+    /// [Helper] Check whether the given request is a small random read that can be queued in the command queue of the card
+    ///
+    /// @param request A non-null block request
+    /// @return `true` if the request is a small read that is not serviced by the read-ahead cache, `false` otherwise.
+    /// @note Sequential reads are better serviced by the read-ahead cache or by a single CMD18.
+    ///
+    bool isRandomReadRequest(IOSDBlockRequest* request);
+    
+    ///
+    /// [Helper] Check whether the given pending request can be queued along with the given request
+    ///
+    /// @param request A non-null simple block request that is a random read
+    /// @param other A non-null pending block request
+    /// @param depth The queue depth returned by `getRandomReadQueueDepth()`
+    /// @return `true` if the other request is a random read that fits in the command queue along with the given request, `false` otherwise.
+    ///
+    bool canQueueBlockRequests(IOSDSimpleBlockRequest* request, IOSDBlockRequest* other, IOItemCount depth);
+    
+public:
+    ///
+    /// Queue pending random reads along with the given request as separate tasks in the command queue of the card
+    ///
+    /// @param request A non-null simple block request that is about to be serviced
+    /// @note This function is invoked on the processor workloop by the block request itself.
+    /// @note Only small reads that are not serviced by the read-ahead cache are queued,
+    ///       and nothing is queued unless the user enables the command queue and the card supports it.
+    ///
+    void queueRandomReadRequests(IOSDSimpleBlockRequest* request);
+    
+    ///
+    /// Process the given read requests as separate tasks in the command queue of the card
+    ///
+    /// @param requests A non-null array of simple block requests to read blocks
+    /// @param count The number of requests (must not exceed the queue depth of the card)
+    /// @param statuses A non-null array that stores the service status of each request on return
+    /// @return `kIOReturnSuccess` if all requests complete without errors, other values otherwise.
+    /// @note This function is invoked on the processor workloop by the block request itself.
+    /// @note The index of each request in the given array is used as its task ID.
+    ///       Requests that are not serviced due to an earlier error are aborted.
+    ///
+    IOReturn processQueuedReadRequests(IOSDSimpleBlockRequest** requests, IOItemCount count, IOReturn* statuses);
+    
     //
     // MARK: - Process Block I/O Requests
     //
@@ -352,6 +676,19 @@ private:
         return retVal;
     }
     
+    ///
+    /// Process the given request to read blocks with the read-ahead cache
+    ///
+    /// @param request A non-null block request
+    /// @return `kIOReturnSuccess` if the request is serviced by the cache,
+    ///         `kIOReturnUnsupported` if the request should be serviced by the card,
+    ///         other values if the driver fails to service the request.
+    /// @note When this function is invoked, the memory descriptor is guaranteed to be non-null and prepared.
+    /// @note If the request is part of a sequential stream but the requested blocks are not cached,
+    ///       this function prefetches the requested blocks along with the following ones with a single CMD18.
+    ///
+    IOReturn processReadRequestWithReadAhead(IOSDBlockRequest* request);
+    
     ///
     /// Process the given request to read a single block
     ///
@@ -393,6 +730,69 @@ private:
     ///
     IOReturn processWriteBlockRequest(IOSDBlockRequest* request);
     
+    ///
+    /// [Helper] Check whether the driver should set the number of blocks to be transferred via a CMD23
+    ///
+    /// @return `true` if the card supports the CMD23 and the current block request should use a predefined multi-block transfer, `false` otherwise.
+    /// @note The card stops a predefined transfer by itself, so the driver no longer needs to send the CMD12 after the data transfer.
+    ///
+    bool shouldUsePredefinedTransfer();
+    
+    ///
+    /// [Helper] Get the amount of time to wait for a data transfer
+    ///
+    /// @param direction The transfer direction
+    /// @param nblocks The number of blocks to transfer
+    /// @return The data timeout in milliseconds.
+    /// @note The timeout consists of the data access timeout specified by the card,
+    ///       twice the amount of time to transfer the data at the current bus clock and bus width,
+    ///       and a constant slack that covers the host-side overhead.
+    ///       Writes allow the card to stall once more per megabyte (e.g. when it crosses an erase block).
+    ///       The timeout is no longer than `kMaxDataTimeout`, and write timeouts are no shorter than `kMinDataTimeout`.
+    ///
+    UInt32 getDataTimeout(IODirection direction, UInt64 nblocks);
+    
+    ///
+    /// [Helper] Set the data timeout of the given request that accesses a single block
+    ///
+    /// @param request A request that reads or writes a single block
+    /// @param direction The transfer direction
+    /// @note The timeout is recorded in the statistics of the block request being serviced.
+    ///
+    void setDataTimeout(IOSDSingleBlockRequest& request, IODirection direction);
+    
+    ///
+    /// [Helper] Set the data timeout and the busy timeout of the given request that accesses multiple blocks
+    ///
+    /// @param request A request that reads or writes multiple blocks
+    /// @param direction The transfer direction
+    /// @note The card may program the last blocks after a write is stopped,
+    ///       so the busy timeout of the STOP command is the write access timeout but no less than `kMinDataTimeout`.
+    ///
+    void setDataTimeout(IOSDMultiBlocksRequest& request, IODirection direction);
+    
+    ///
+    /// [Helper] Read multiple blocks to the given buffer with a single CMD18
+    ///
+    /// @param block The starting block number
+    /// @param data A non-null, prepared memory descriptor that stores the data read from the card
+    /// @param nblocks The number of blocks to read
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note The host device sends the CMD23 along with the CMD18 in the same session if the card supports it.
+    ///
+    IOReturn readBlocks(UInt64 block, IOMemoryDescriptor* data, UInt64 nblocks);
+    
+    ///
+    /// [Helper] Write the given data to multiple blocks with a single CMD25
+    ///
+    /// @param block The starting block number
+    /// @param data A non-null, prepared memory descriptor that contains the data to be written
+    /// @param nblocks The number of blocks to write
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note The host device sends the CMD23 or the CMD55 + ACMD23 along with the CMD25 in the same session unless the user disables it.
+    ///
+    IOReturn writeBlocks(UInt64 block, IOMemoryDescriptor* data, UInt64 nblocks);
+    
     ///
     /// Process the given request to write multiple blocks
     ///
@@ -476,6 +876,14 @@ public:
         return this->host;
     }
     
+    ///
+    /// Get the number of blocks that the transactions of a large write should be aligned to
+    ///
+    /// @return The number of 512-byte blocks in an allocation unit of the card, 0 if writes should not be aligned.
+    /// @note This function is invoked on the processor workloop by the block request itself.
+    ///
+    UInt64 getWriteAlignment();
+    
     //
     // MARK: - Adjust Host Bus Settings
     //
@@ -838,6 +1246,107 @@ public:
     ///
     IOReturn CMD13(UInt32 rca, UInt32& status);
     
+    ///
+    /// CMD13: Send the queue status
+    ///
+    /// @param rca The card relative address
+    /// @param qsr The queue status on return (i.e. one bit per task that is ready for execution)
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    ///
+    IOReturn CMD13q(UInt32 rca, UInt32& qsr);
+    
+    ///
+    /// CMD32: Set the address of the first block to be erased
+    ///
+    /// @param offset The starting block number (SDHC/XC) or byte offset (SDSC)
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces a portion of `mmc_do_erase()` defined in `core.c`.
+    ///
+    IOReturn CMD32(UInt32 offset);
+    
+    ///
+    /// CMD33: Set the address of the last block to be erased
+    ///
+    /// @param offset The last block number (SDHC/XC) or byte offset (SDSC)
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces a portion of `mmc_do_erase()` defined in `core.c`.
+    ///
+    IOReturn CMD33(UInt32 offset);
+    
+    ///
+    /// CMD38: Erase the blocks selected by the CMD32 and the CMD33
+    ///
+    /// @param argument The erase function (i.e. `kEraseArgumentErase` or `kEraseArgumentDiscard`)
+    /// @param timeout The amount of time in milliseconds to wait for the card to release the busy signal
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces a portion of `mmc_do_erase()` defined in `core.c`.
+    ///
+    IOReturn CMD38(UInt32 argument, UInt32 timeout);
+    
+    ///
+    /// CMD43: Manage the command queue
+    ///
+    /// @param argument The queue management operation (e.g. `kQueueManagementAbortAll`)
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    ///
+    IOReturn CMD43(UInt32 argument);
+    
+    ///
+    /// CMD44: Queue a task and specify its parameters
+    ///
+    /// @param argument The transfer direction, the task ID and the number of blocks
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    ///
+    IOReturn CMD44(UInt32 argument);
+    
+    ///
+    /// CMD45: Specify the start address of the task queued by the preceding CMD44
+    ///
+    /// @param offset The starting block number (SDHC/XC) or byte offset (SDSC)
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    ///
+    IOReturn CMD45(UInt32 offset);
+    
+    ///
+    /// CMD48: Read an extension register
+    ///
+    /// @param argument The function number, the address and the length of the register
+    /// @param buffer A non-null buffer that stores the register value on return
+    /// @param length Specify the number of bytes read from the register (must not exceed 512 bytes)
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces `sd_read_ext_reg()` defined in `sd.c`.
+    /// @note This function allocates an internal 512-byte DMA capable buffer to store the data block from the card.
+    ///       The register value is then copied to the given `buffer`.
+    ///
+    IOReturn CMD48(UInt32 argument, UInt8* buffer, IOByteCount length);
+    
+    ///
+    /// CMD48: Read an extension register
+    ///
+    /// @param argument The function number, the address and the length of the register
+    /// @param buffer A non-null buffer that stores the register value on return
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces `sd_read_ext_reg()` defined in `sd.c`.
+    /// @note This function allocates an internal 512-byte DMA capable buffer to store the data block from the card.
+    ///       The register value is then copied to the given `buffer`.
+    ///
+    template <size_t N>
+    IOReturn CMD48(UInt32 argument, UInt8 (&buffer)[N])
+    {
+        return this->CMD48(argument, buffer, N);
+    }
+    
+    ///
+    /// CMD49: Write a single byte to an extension register
+    ///
+    /// @param argument The function number, the address and the length of the register
+    /// @param value The value to be written
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces a portion of `sd_write_ext_reg()` defined in `sd.c`.
+    /// @note This function allocates an internal 512-byte DMA capable buffer to send the data block to the card.
+    ///
+    IOReturn CMD49(UInt32 argument, UInt8 value);
+    
     ///
     /// CMD55: Tell the card that the next command is an application command
     ///
@@ -1136,19 +1645,19 @@ public:
     ///
     IOReturn getCardSerialNumber(UInt32& serial);
     
+    ///
+    /// Check whether the card supports erase commands
+    ///
+    /// @param result Set `true` if the card supports the erase command class, `false` otherwise.
+    /// @return `kIOReturnSuccess` on success, `kIOReturnNoMedia` if the card is not present.
+    ///
+    IOReturn isCardEraseSupported(bool& result);
+    
     //
     // MARK: - Startup Routines
     //
     
 private:
-    ///
-    /// Setup the shared work loop to protect the pool and the queue
-    ///
-    /// @return `true` on success, `false` otherwise.
-    /// @note Upon an unsuccessful return, all resources allocated by this function are released.
-    ///
-    bool setupSharedWorkLoop();
-    
     ///
     /// Setup the SD block request pool
     ///
@@ -1211,11 +1720,6 @@ private:
     //
     
 private:    
-    ///
-    /// Tear down the shared workloop
-    ///
-    void tearDownSharedWorkLoop();
-    
     ///
     /// Tear down the SD block request pool
     ///
@@ -23,9 +23,36 @@ namespace UserConfigs::Card
     /// `True` if the driver should separate each CMD18/25 request into multiple CMD17/24 ones
     bool SeparateAccessBlocksRequest = BootArgs::contains("-iosdsabr");
     
-    /// `True` if the driver should not issue the ACMD23 command when processing CMD25 requests
+    /// `True` if the driver should not issue the ACMD23 (or the CMD23 if supported) command when processing CMD25 requests
     bool NoACMD23 = BootArgs::contains("-iosdnoacmd23");
     
     /// Specify the maximum number of attempts to retry an application command
     UInt32 ACMDMaxNumAttempts = max(BootArgs::get("iosdamna", 2), 1);
+    
+    /// `True` if the driver should collect statistics of block requests and print them when the card is removed
+    bool CollectBlockRequestStatistics = BootArgs::contains("-iosdbrs") || BootArgs::contains("-iosdbpt");
+    
+    /// `True` if the driver should not prepare the next block request while the current DMA transfer is in flight
+    bool NoRequestPipelining = BootArgs::contains("-iosdnorp");
+    
+    /// `True` if the driver should not merge adjacent pending block requests
+    bool NoRequestMerging = BootArgs::contains("-iosdnorm");
+    
+    /// Specify the number of blocks to prefetch when the driver detects sequential reads (0 to disable the read-ahead cache)
+    UInt32 ReadAheadNumBlocks = BootArgs::get("iosdrab", 0);
+    
+    /// `True` if the driver should not align the transactions of large writes to allocation unit boundaries
+    bool NoAUAlignedWrites = BootArgs::contains("-iosdnoauw");
+    
+    /// `True` if the driver should not issue the CMD23 to set the number of blocks to be transferred by CMD18/25 requests
+    bool NoCMD23 = BootArgs::contains("-iosdnocmd23");
+    
+    /// `True` if the driver should alternate between predefined and open-ended multi-block transfers and collect statistics of each mode separately
+    bool BenchPredefinedTransfers = BootArgs::contains("-iosdbpt");
+    
+    /// `True` if the driver should not enable the cache of cards that support the performance enhancement function
+    bool NoCardCache = BootArgs::contains("-iosdnocache");
+    
+    /// `True` if the driver should queue random reads as separate tasks on cards that support the command queue (experimental)
+    bool EnableCommandQueue = BootArgs::contains("-iosdcq");
 }
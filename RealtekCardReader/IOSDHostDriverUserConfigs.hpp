@@ -25,11 +25,38 @@ namespace UserConfigs::Card
     /// `True` if the driver should separate each CMD18/25 request into multiple CMD17/24 ones
     extern bool SeparateAccessBlocksRequest;
     
-    /// `True` if the driver should not issue the ACMD23 command when processing CMD25 requests
+    /// `True` if the driver should not issue the ACMD23 (or the CMD23 if supported) command when processing CMD25 requests
     extern bool NoACMD23;
     
     /// Specify the maximum number of attempts to retry an application command
     extern UInt32 ACMDMaxNumAttempts;
+    
+    /// `True` if the driver should collect statistics of block requests and print them when the card is removed
+    extern bool CollectBlockRequestStatistics;
+    
+    /// `True` if the driver should not prepare the next block request while the current DMA transfer is in flight
+    extern bool NoRequestPipelining;
+    
+    /// `True` if the driver should not merge adjacent pending block requests
+    extern bool NoRequestMerging;
+    
+    /// Specify the number of blocks to prefetch when the driver detects sequential reads (0 to disable the read-ahead cache)
+    extern UInt32 ReadAheadNumBlocks;
+    
+    /// `True` if the driver should not align the transactions of large writes to allocation unit boundaries
+    extern bool NoAUAlignedWrites;
+    
+    /// `True` if the driver should not issue the CMD23 to set the number of blocks to be transferred by CMD18/25 requests
+    extern bool NoCMD23;
+    
+    /// `True` if the driver should alternate between predefined and open-ended multi-block transfers and collect statistics of each mode separately
+    extern bool BenchPredefinedTransfers;
+    
+    /// `True` if the driver should not enable the cache of cards that support the performance enhancement function
+    extern bool NoCardCache;
+    
+    /// `True` if the driver should queue random reads as separate tasks on cards that support the command queue (experimental)
+    extern bool EnableCommandQueue;
 }
 
 #endif /* IOSDHostDriverUserConfigs_hpp */
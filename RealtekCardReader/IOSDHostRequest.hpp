@@ -34,8 +34,19 @@ public:
         kReadSingleBlock = 17,
         kReadMultipleBlocks = 18,
         kSendTuningBlock = 19,
+        kSetBlockCount = 23,
         kWriteSingleBlock = 24,
         kWriteMultipleBlocks = 25,
+        kEraseWriteBlockStart = 32,
+        kEraseWriteBlockEnd = 33,
+        kErase = 38,
+        kQueueManagement = 43,
+        kQueueTaskInfoA = 44,
+        kQueueTaskInfoB = 45,
+        kQueueReadTask = 46,
+        kQueueWriteTask = 47,
+        kReadExtraSingle = 48,
+        kWriteExtraSingle = 49,
         kAppCommand = 55,
         
         // Application Commands
@@ -76,6 +87,14 @@ public:
     // MARK: - Constructors
     //
     
+    ///
+    /// Create an empty host command
+    ///
+    /// @note The command is a CMD0 and serves as a placeholder until the caller assigns a meaningful one.
+    ///
+    IOSDHostCommand()
+        : IOSDHostCommand(Opcode::kGoIdleState, 0, ResponseType::kR0) {}
+    
     ///
     /// Create a host command
     ///
@@ -127,6 +146,16 @@ public:
         return this->busyTimeout != 0 ? this->busyTimeout : defaultTimeout;
     }
     
+    ///
+    /// Set the amount of time in ms to detect the busy bit until timed out
+    ///
+    /// @param timeout The busy timeout derived from the card parameters
+    ///
+    inline void setBusyTimeout(UInt32 timeout)
+    {
+        this->busyTimeout = timeout;
+    }
+    
     ///
     /// Get the storage for the command response
     ///
@@ -268,6 +297,11 @@ public:
         return IOSDHostCommand(Opcode::kSendStatus, rca << 16, ResponseType::kR1);
     }
 
+    static inline IOSDHostCommand CMD13q(UInt32 rca)
+    {
+        return IOSDHostCommand(Opcode::kSendStatus, rca << 16 | 1 << 15, ResponseType::kR1);
+    }
+
     static inline IOSDHostCommand CMD17(UInt32 offset)
     {
         return IOSDHostCommand(Opcode::kReadSingleBlock, offset, ResponseType::kR1);
@@ -283,6 +317,11 @@ public:
         return IOSDHostCommand(Opcode::kSendTuningBlock, 0, ResponseType::kR1);
     }
 
+    static inline IOSDHostCommand CMD23(UInt32 nblocks)
+    {
+        return IOSDHostCommand(Opcode::kSetBlockCount, nblocks, ResponseType::kR1);
+    }
+
     static inline IOSDHostCommand CMD24(UInt32 offset)
     {
         return IOSDHostCommand(Opcode::kWriteSingleBlock, offset, ResponseType::kR1);
@@ -293,6 +332,51 @@ public:
         return IOSDHostCommand(Opcode::kWriteMultipleBlocks, offset, ResponseType::kR1);
     }
 
+    static inline IOSDHostCommand CMD32(UInt32 offset)
+    {
+        return IOSDHostCommand(Opcode::kEraseWriteBlockStart, offset, ResponseType::kR1);
+    }
+
+    static inline IOSDHostCommand CMD33(UInt32 offset)
+    {
+        return IOSDHostCommand(Opcode::kEraseWriteBlockEnd, offset, ResponseType::kR1);
+    }
+
+    static inline IOSDHostCommand CMD38(UInt32 argument, UInt32 busyTimeout)
+    {
+        return IOSDHostCommand(Opcode::kErase, argument, ResponseType::kR1b, busyTimeout);
+    }
+
+    static inline IOSDHostCommand CMD43(UInt32 argument)
+    {
+        return IOSDHostCommand(Opcode::kQueueManagement, argument, ResponseType::kR1b);
+    }
+
+    static inline IOSDHostCommand CMD44(UInt32 argument)
+    {
+        return IOSDHostCommand(Opcode::kQueueTaskInfoA, argument, ResponseType::kR1);
+    }
+
+    static inline IOSDHostCommand CMD45(UInt32 offset)
+    {
+        return IOSDHostCommand(Opcode::kQueueTaskInfoB, offset, ResponseType::kR1);
+    }
+
+    static inline IOSDHostCommand CMD46(UInt32 taskID)
+    {
+        return IOSDHostCommand(Opcode::kQueueReadTask, taskID << 16, ResponseType::kR1);
+    }
+
+    static inline IOSDHostCommand CMD48(UInt32 argument)
+    {
+        return IOSDHostCommand(Opcode::kReadExtraSingle, argument, ResponseType::kR1);
+    }
+
+    static inline IOSDHostCommand CMD49(UInt32 argument)
+    {
+        return IOSDHostCommand(Opcode::kWriteExtraSingle, argument, ResponseType::kR1);
+    }
+
     static inline IOSDHostCommand CMD55(UInt32 rca)
     {
         return IOSDHostCommand(Opcode::kAppCommand, rca << 16, ResponseType::kR1);
@@ -337,10 +421,13 @@ private:
     /// The size of each block in bytes
     UInt64 blockSize;
     
+    /// The amount of time in ms to wait for the data transfer until timed out (0 if not defined)
+    UInt32 timeout;
+    
 public:
     /// Create with the given memory descriptor and data properties
     IOSDHostData(IOMemoryDescriptor* data, UInt64 nblocks, UInt64 blockSize)
-        : data(data), nblocks(nblocks), blockSize(blockSize) {}
+        : data(data), nblocks(nblocks), blockSize(blockSize), timeout(0) {}
     
     /// Get the memory descriptor that describes the data to be transferred
     inline IOMemoryDescriptor* getMemoryDescriptor() const
@@ -365,6 +452,23 @@ public:
     {
         return this->nblocks * this->blockSize;
     }
+    
+    ///
+    /// Get the amount of time in ms to wait for the data transfer until timed out
+    ///
+    /// @param defaultTimeout If the amount of time is not defined (i.e. 0),
+    ///                       use the value specified by this parameter instead.
+    ///
+    inline UInt32 getTimeout(UInt32 defaultTimeout) const
+    {
+        return this->timeout != 0 ? this->timeout : defaultTimeout;
+    }
+    
+    /// Set the amount of time in ms to wait for the data transfer until timed out
+    inline void setTimeout(UInt32 timeout)
+    {
+        this->timeout = timeout;
+    }
 };
 
 /// Represents a host request to be processed by the SD card
@@ -438,9 +542,57 @@ struct IOSDMultiBlocksRequest: IOSDSingleBlockRequest
     ///
     IOSDHostCommand stopCommand;
     
+    /// The maximum number of commands to be sent before the data transfer command
+    static constexpr IOItemCount kMaxNumPreCommands = 2;
+    
+    ///
+    /// Commands to be sent right before the data transfer command (e.g., CMD23 or CMD55 + ACMD23)
+    ///
+    /// @note The host device should send these commands along with the data transfer command in the same session,
+    ///       so that setting the number of blocks does not cost extra round trips.
+    ///
+    IOSDHostCommand preCommands[kMaxNumPreCommands];
+    
+    /// The number of valid commands in `preCommands`
+    IOItemCount numPreCommands;
+    
+    /// `true` if the card stops the transmission automatically after the predefined number of blocks, i.e. a CMD23 is sent
+    bool predefined;
+    
     /// Create a request that accesses multiple blocks on the card
     IOSDMultiBlocksRequest(void* target, Processor processor, const IOSDHostCommand& command, const IOSDHostData& data, const IOSDHostCommand& stopCommand)
-        : IOSDSingleBlockRequest(target, processor, command, data), stopCommand(stopCommand) {}
+        : IOSDSingleBlockRequest(target, processor, command, data), stopCommand(stopCommand), preCommands(), numPreCommands(0), predefined(false) {}
+    
+    ///
+    /// Send a CMD23 before the data transfer command to set the number of blocks to be transferred
+    ///
+    /// @note The card stops the transmission automatically, so the stop command is needed only if an error occurs.
+    ///
+    inline void setBlockCount()
+    {
+        this->preCommands[0] = IOSDHostCommand::CMD23(static_cast<UInt32>(this->data.getNumBlocks()));
+        
+        this->numPreCommands = 1;
+        
+        this->predefined = true;
+    }
+    
+    ///
+    /// Send a CMD55 + ACMD23 before the data transfer command to set the number of blocks to be pre-erased
+    ///
+    /// @param rca The card relative address
+    /// @note The transmission remains open ended, so the stop command is always needed.
+    ///
+    inline void setPreEraseBlockCount(UInt32 rca)
+    {
+        this->preCommands[0] = IOSDHostCommand::CMD55(rca);
+        
+        this->preCommands[1] = IOSDHostCommand::ACMD23(static_cast<UInt32>(this->data.getNumBlocks()));
+        
+        this->numPreCommands = 2;
+        
+        this->predefined = false;
+    }
 };
 
 ///
@@ -627,6 +779,11 @@ public:
         return this->makeCommandRequest(IOSDHostCommand::CMD13(rca));
     }
 
+    inline IOSDCommandRequest CMD13q(UInt32 rca) const
+    {
+        return this->makeCommandRequest(IOSDHostCommand::CMD13q(rca));
+    }
+
     inline IOSDSingleBlockRequest CMD17(UInt32 offset, IOMemoryDescriptor* data) const
     {
         return this->makeReadSingleBlockRequest(IOSDHostCommand::CMD17(offset), IOSDHostData(data, 1, 512));
@@ -647,6 +804,56 @@ public:
         return this->makeWriteMultiBlocksRequest(IOSDHostCommand::CMD25(offset), IOSDHostData(data, nblocks, 512), IOSDHostCommand::CMD12b());
     }
 
+    inline IOSDCommandRequest CMD32(UInt32 offset) const
+    {
+        return this->makeCommandRequest(IOSDHostCommand::CMD32(offset));
+    }
+
+    inline IOSDCommandRequest CMD33(UInt32 offset) const
+    {
+        return this->makeCommandRequest(IOSDHostCommand::CMD33(offset));
+    }
+
+    inline IOSDCommandRequest CMD38(UInt32 argument, UInt32 busyTimeout) const
+    {
+        return this->makeCommandRequest(IOSDHostCommand::CMD38(argument, busyTimeout));
+    }
+
+    inline IOSDCommandRequest CMD43(UInt32 argument) const
+    {
+        return this->makeCommandRequest(IOSDHostCommand::CMD43(argument));
+    }
+
+    inline IOSDCommandRequest CMD44(UInt32 argument) const
+    {
+        return this->makeCommandRequest(IOSDHostCommand::CMD44(argument));
+    }
+
+    inline IOSDCommandRequest CMD45(UInt32 offset) const
+    {
+        return this->makeCommandRequest(IOSDHostCommand::CMD45(offset));
+    }
+
+    inline IOSDMultiBlocksRequest CMD46(UInt32 taskID, IOMemoryDescriptor* data, UInt64 nblocks) const
+    {
+        // The number of blocks has been set by the CMD44, so the card stops the transmission automatically
+        auto request = this->makeReadMultiBlocksRequest(IOSDHostCommand::CMD46(taskID), IOSDHostData(data, nblocks, 512), IOSDHostCommand::CMD12());
+        
+        request.predefined = true;
+        
+        return request;
+    }
+
+    inline IOSDDataTransferRequest CMD48(UInt32 argument, IOMemoryDescriptor* data) const
+    {
+        return this->makeInboundDataTransferRequest(IOSDHostCommand::CMD48(argument), IOSDHostData(data, 1, 512));
+    }
+
+    inline IOSDDataTransferRequest CMD49(UInt32 argument, IOMemoryDescriptor* data) const
+    {
+        return this->makeOutboundDataTransferRequest(IOSDHostCommand::CMD49(argument), IOSDHostData(data, 1, 512));
+    }
+
     inline IOSDCommandRequest CMD55(UInt32 rca) const
     {
         return this->makeCommandRequest(IOSDHostCommand::CMD55(rca));
@@ -721,6 +928,16 @@ public:
 #define R1_EXCEPTION_EVENT    (1 << 6)    /* sr, a */
 #define R1_APP_CMD        (1 << 5)    /* sr, c */
 
+#define R1_STATE_IDLE    0
+#define R1_STATE_READY    1
+#define R1_STATE_IDENT    2
+#define R1_STATE_STBY    3
+#define R1_STATE_TRAN    4
+#define R1_STATE_DATA    5
+#define R1_STATE_RCV    6
+#define R1_STATE_PRG    7
+#define R1_STATE_DIS    8
+
 /// Represents the 48-bit R1 response
 struct PACKED IOSDHostResponse1
 {
@@ -0,0 +1,181 @@
+//
+//  IOSDReadAheadCache.cpp
+//  RealtekCardReader
+//
+//  Created by FireWolf on 10/16/26.
+//
+
+#include "IOSDReadAheadCache.hpp"
+#include "Debug.hpp"
+
+//
+// MARK: - Setup & Teardown
+//
+
+///
+/// Allocate the buffer of the cache
+///
+/// @param nblocks The maximum number of blocks that can be prefetched at once
+/// @return `true` on success, `false` otherwise.
+/// @note The cache remains disabled if this function fails or if the given number of blocks is 0.
+///
+bool IOSDReadAheadCache::setUp(UInt64 nblocks)
+{
+    this->buffer = nullptr;
+    
+    this->capacity = 0;
+    
+    this->invalidate();
+    
+    if (nblocks == 0)
+    {
+        pinfo("The read-ahead cache is disabled.");
+        
+        return true;
+    }
+    
+    this->buffer = IOBufferMemoryDescriptor::withCapacity(nblocks * 512, kIODirectionIn);
+    
+    if (this->buffer == nullptr)
+    {
+        perr("Failed to allocate the buffer to prefetch %llu blocks.", nblocks);
+        
+        return false;
+    }
+    
+    this->capacity = nblocks;
+    
+    pinfo("The read-ahead cache has been enabled. Capacity = %llu blocks.", nblocks);
+    
+    return true;
+}
+
+///
+/// Release the buffer of the cache
+///
+void IOSDReadAheadCache::tearDown()
+{
+    OSSafeReleaseNULL(this->buffer);
+    
+    this->capacity = 0;
+    
+    this->invalidate();
+}
+
+//
+// MARK: - Sequential Detector
+//
+
+///
+/// Feed the sequential detector with a read request
+///
+/// @param block The starting block number
+/// @param nblocks The number of blocks to read
+/// @return `true` if the given read request is part of a sequential stream, `false` otherwise.
+///
+bool IOSDReadAheadCache::recordRead(UInt64 block, UInt64 nblocks)
+{
+    if (block == this->nextBlock)
+    {
+        this->numSequentialReads += 1;
+    }
+    else
+    {
+        this->numSequentialReads = 0;
+    }
+    
+    this->nextBlock = block + nblocks;
+    
+    return this->numSequentialReads >= kSequentialThreshold;
+}
+
+//
+// MARK: - Cached Blocks
+//
+
+///
+/// Check whether the given blocks are stored in the cache
+///
+/// @param block The starting block number
+/// @param nblocks The number of blocks
+/// @return `true` if all given blocks are stored in the cache, `false` otherwise.
+///
+bool IOSDReadAheadCache::contains(UInt64 block, UInt64 nblocks) const
+{
+    return this->count != 0 && block >= this->start && block + nblocks <= this->start + this->count;
+}
+
+///
+/// Copy the given blocks stored in the cache to the given buffer
+///
+/// @param destination A non-null, prepared buffer
+/// @param block The starting block number
+/// @param nblocks The number of blocks
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note The caller must ensure that all given blocks are stored in the cache.
+///
+IOReturn IOSDReadAheadCache::copyBlocks(IOMemoryDescriptor* destination, UInt64 block, UInt64 nblocks) const
+{
+    passert(this->contains(block, nblocks), "The given blocks should be stored in the cache.");
+    
+    const UInt8* source = reinterpret_cast<const UInt8*>(this->buffer->getBytesNoCopy()) + (block - this->start) * 512;
+    
+    IOByteCount length = nblocks * 512;
+    
+    if (destination->writeBytes(0, source, length) != length)
+    {
+        perr("Failed to copy %llu blocks from the read-ahead cache.", nblocks);
+        
+        return kIOReturnDMAError;
+    }
+    
+    return kIOReturnSuccess;
+}
+
+///
+/// Mark that the cache buffer now stores the given blocks
+///
+/// @param block The starting block number
+/// @param nblocks The number of blocks that have been read into the cache buffer
+///
+void IOSDReadAheadCache::fill(UInt64 block, UInt64 nblocks)
+{
+    passert(nblocks <= this->capacity, "The number of blocks should not exceed the capacity.");
+    
+    this->start = block;
+    
+    this->count = nblocks;
+}
+
+///
+/// Invalidate all blocks stored in the cache
+///
+void IOSDReadAheadCache::invalidate()
+{
+    this->start = 0;
+    
+    this->count = 0;
+    
+    this->nextBlock = 0;
+    
+    this->numSequentialReads = 0;
+}
+
+///
+/// Invalidate the cache if it stores any of the given blocks
+///
+/// @param block The starting block number
+/// @param nblocks The number of blocks
+/// @note This function is invoked before the host driver writes the given blocks to the card.
+///
+void IOSDReadAheadCache::invalidate(UInt64 block, UInt64 nblocks)
+{
+    if (this->count != 0 && block < this->start + this->count && this->start < block + nblocks)
+    {
+        pinfo("The write request [%llu, %llu) overlaps the cached blocks [%llu, %llu).", block, block + nblocks, this->start, this->start + this->count);
+        
+        this->start = 0;
+        
+        this->count = 0;
+    }
+}
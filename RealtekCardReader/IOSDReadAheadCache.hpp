@@ -0,0 +1,140 @@
+//
+//  IOSDReadAheadCache.hpp
+//  RealtekCardReader
+//
+//  Created by FireWolf on 10/16/26.
+//
+
+#ifndef IOSDReadAheadCache_hpp
+#define IOSDReadAheadCache_hpp
+
+#include <IOKit/IOBufferMemoryDescriptor.h>
+
+///
+/// A read-ahead cache that detects sequential reads and keeps the blocks prefetched from the card
+///
+/// @note The host driver issues a single large CMD18 to fill the cache once a sequential stream is detected,
+///       so that subsequent small reads of the stream are serviced from memory without accessing the card.
+/// @note The cache is accessed on the processor workloop only, so no extra synchronization is needed.
+///
+class IOSDReadAheadCache
+{
+    /// The number of consecutive sequential reads required to start prefetching blocks
+    static constexpr UInt32 kSequentialThreshold = 2;
+    
+    /// The buffer that stores prefetched blocks, `nullptr` if the cache is disabled
+    IOBufferMemoryDescriptor* buffer;
+    
+    /// The maximum number of blocks that can be prefetched at once
+    UInt64 capacity;
+    
+    /// The index of the first block stored in the cache
+    UInt64 start;
+    
+    /// The number of valid blocks stored in the cache
+    UInt64 count;
+    
+    /// The index of the block that a sequential read is expected to start with
+    UInt64 nextBlock;
+    
+    /// The number of consecutive sequential reads detected so far
+    UInt32 numSequentialReads;
+    
+public:
+    ///
+    /// Allocate the buffer of the cache
+    ///
+    /// @param nblocks The maximum number of blocks that can be prefetched at once
+    /// @return `true` on success, `false` otherwise.
+    /// @note The cache remains disabled if this function fails or if the given number of blocks is 0.
+    ///
+    bool setUp(UInt64 nblocks);
+    
+    ///
+    /// Release the buffer of the cache
+    ///
+    void tearDown();
+    
+    ///
+    /// Check whether the cache is enabled
+    ///
+    /// @return `true` if the cache is enabled, `false` otherwise.
+    ///
+    inline bool isEnabled() const
+    {
+        return this->buffer != nullptr;
+    }
+    
+    ///
+    /// Get the buffer where prefetched blocks are stored
+    ///
+    /// @return The non-null buffer if the cache is enabled.
+    ///
+    inline IOMemoryDescriptor* getBuffer() const
+    {
+        return this->buffer;
+    }
+    
+    ///
+    /// Get the maximum number of blocks that can be prefetched at once
+    ///
+    /// @return The number of blocks.
+    ///
+    inline UInt64 getCapacity() const
+    {
+        return this->capacity;
+    }
+    
+    ///
+    /// Feed the sequential detector with a read request
+    ///
+    /// @param block The starting block number
+    /// @param nblocks The number of blocks to read
+    /// @return `true` if the given read request is part of a sequential stream, `false` otherwise.
+    ///
+    bool recordRead(UInt64 block, UInt64 nblocks);
+    
+    ///
+    /// Check whether the given blocks are stored in the cache
+    ///
+    /// @param block The starting block number
+    /// @param nblocks The number of blocks
+    /// @return `true` if all given blocks are stored in the cache, `false` otherwise.
+    ///
+    bool contains(UInt64 block, UInt64 nblocks) const;
+    
+    ///
+    /// Copy the given blocks stored in the cache to the given buffer
+    ///
+    /// @param destination A non-null, prepared buffer
+    /// @param block The starting block number
+    /// @param nblocks The number of blocks
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note The caller must ensure that all given blocks are stored in the cache.
+    ///
+    IOReturn copyBlocks(IOMemoryDescriptor* destination, UInt64 block, UInt64 nblocks) const;
+    
+    ///
+    /// Mark that the cache buffer now stores the given blocks
+    ///
+    /// @param block The starting block number
+    /// @param nblocks The number of blocks that have been read into the cache buffer
+    ///
+    void fill(UInt64 block, UInt64 nblocks);
+    
+    ///
+    /// Invalidate all blocks stored in the cache
+    ///
+    void invalidate();
+    
+    ///
+    /// Invalidate the cache if it stores any of the given blocks
+    ///
+    /// @param block The starting block number
+    /// @param nblocks The number of blocks
+    /// @note This function is invoked before the host driver writes the given blocks to the card.
+    ///
+    void invalidate(UInt64 block, UInt64 nblocks);
+};
+
+#endif /* IOSDReadAheadCache_hpp */
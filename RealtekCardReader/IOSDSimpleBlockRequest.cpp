@@ -8,6 +8,7 @@
 #include "IOSDSimpleBlockRequest.hpp"
 #include "IOSDHostDriver.hpp"
 #include "IOMemoryDescriptor.hpp"
+#include <IOKit/IOMultiMemoryDescriptor.h>
 #include "Debug.hpp"
 
 //
@@ -51,6 +52,12 @@ void IOSDSimpleBlockRequest::init(IOSDHostDriver* driver,
     this->attributes = attributes;
     
     this->completion = *completion;
+    
+    this->numMergedRequests = 0;
+    
+    this->queued = false;
+    
+    this->mergedProcessor = nullptr;
 }
 
 ///
@@ -79,6 +86,12 @@ void IOSDSimpleBlockRequest::deinit()
     this->completion.parameter = nullptr;
     
     this->completion.action = nullptr;
+    
+    this->numMergedRequests = 0;
+    
+    this->queued = false;
+    
+    this->mergedProcessor = nullptr;
 }
 
 ///
@@ -111,20 +124,283 @@ UInt64 IOSDSimpleBlockRequest::getNumBlocks()
     return this->nblocks;
 }
 
+//
+// MARK: - Request Merging
+//
+
+///
+/// Check whether the given request can be merged into this one
+///
+/// @param request A non-null pending block request
+/// @param maxNumBlocks The maximum number of blocks in one DMA transaction
+/// @return `true` if the given request is a simple request that accesses blocks right before or after the ones accessed by this request
+///         in the same direction with the same attributes, and the total number of blocks does not exceed the given limit.
+///
+bool IOSDSimpleBlockRequest::canMergeRequest(IOSDBlockRequest* request, UInt64 maxNumBlocks)
+{
+    // Guard: Only simple requests can be merged
+    //        A complex request is serviced in multiple transactions by itself
+    if (OSTypeIDInst(request) != OSTypeID(IOSDSimpleBlockRequest))
+    {
+        return false;
+    }
+    
+    auto other = static_cast<IOSDSimpleBlockRequest*>(request);
+    
+    // Guard: Check the number of merged requests
+    if (this->numMergedRequests >= kMaxNumMergedRequests)
+    {
+        return false;
+    }
+    
+    // Guard: Check the transfer direction
+    if (other->buffer->getDirection() != this->buffer->getDirection())
+    {
+        return false;
+    }
+    
+    // Guard: Check the data transfer attributes
+    // e.g. A request that must bypass the cache on the card cannot be merged with a regular one
+    IOStorageOptions options = this->attributes != nullptr ? this->attributes->options : 0;
+    
+    IOStorageOptions otherOptions = other->attributes != nullptr ? other->attributes->options : 0;
+    
+    if (options != otherOptions)
+    {
+        return false;
+    }
+    
+    // Guard: Check the total number of blocks
+    UInt64 nblocks = this->getMergedNumBlocks();
+    
+    if (nblocks + other->nblocks > maxNumBlocks)
+    {
+        return false;
+    }
+    
+    // Guard: Check whether the given request is adjacent to the merged one
+    UInt64 start = this->numMergedRequests == 0 ? this->block : this->mergedRequests[0]->block;
+    
+    return other->block + other->nblocks == start || start + nblocks == other->block;
+}
+
+///
+/// Merge the given request into this one
+///
+/// @param request A non-null simple block request that passes the check of `canMergeRequest()`
+/// @param processor The routine to process the merged request that accesses multiple blocks
+/// @note The merged request is serviced by this request and is completed along with this request.
+///       The caller must invoke `detachMergedRequest()` to finalize merged requests once this request has been serviced.
+///
+void IOSDSimpleBlockRequest::mergeRequest(IOSDSimpleBlockRequest* request, Processor processor)
+{
+    passert(this->numMergedRequests < kMaxNumMergedRequests, "The number of merged requests should not exceed the limit.");
+    
+    if (this->numMergedRequests == 0)
+    {
+        this->mergedRequests[0] = this;
+        
+        this->numMergedRequests = 1;
+    }
+    
+    // Keep requests sorted by their starting block number
+    if (request->block < this->mergedRequests[0]->block)
+    {
+        memmove(&this->mergedRequests[1], &this->mergedRequests[0], this->numMergedRequests * sizeof(IOSDSimpleBlockRequest*));
+        
+        this->mergedRequests[0] = request;
+    }
+    else
+    {
+        this->mergedRequests[this->numMergedRequests] = request;
+    }
+    
+    this->numMergedRequests += 1;
+    
+    this->mergedProcessor = processor;
+    
+    pinfo("Merged the request [%llu, %llu). %u requests will be serviced together.", request->block, request->block + request->nblocks, this->numMergedRequests);
+}
+
+///
+/// Detach a request that has been merged into this one
+///
+/// @return A request merged into this one, `nullptr` if no more merged requests.
+///
+IOSDSimpleBlockRequest* IOSDSimpleBlockRequest::detachMergedRequest()
+{
+    while (this->numMergedRequests > 0)
+    {
+        this->numMergedRequests -= 1;
+        
+        IOSDSimpleBlockRequest* request = this->mergedRequests[this->numMergedRequests];
+        
+        if (request != this)
+        {
+            return request;
+        }
+    }
+    
+    return nullptr;
+}
+
+///
+/// Check whether the given request can be queued as a separate task along with this one
+///
+/// @param request A non-null pending block request
+/// @param maxNumRequests The maximum number of tasks in the command queue
+/// @return `true` if the given request is a simple request that transfers data in the same direction as this one,
+///         and the total number of requests does not exceed the given limit.
+///
+bool IOSDSimpleBlockRequest::canQueueRequest(IOSDBlockRequest* request, IOItemCount maxNumRequests)
+{
+    // Guard: Only simple requests can be queued
+    if (OSTypeIDInst(request) != OSTypeID(IOSDSimpleBlockRequest))
+    {
+        return false;
+    }
+    
+    auto other = static_cast<IOSDSimpleBlockRequest*>(request);
+    
+    // Guard: Check the number of queued requests (including this one)
+    IOItemCount count = this->numMergedRequests == 0 ? 1 : this->numMergedRequests;
+    
+    if (count >= maxNumRequests || count >= kMaxNumMergedRequests)
+    {
+        return false;
+    }
+    
+    // Guard: Check the transfer direction
+    return other->buffer->getDirection() == this->buffer->getDirection();
+}
+
+///
+/// Queue the given request as a separate task along with this one
+///
+/// @param request A non-null simple block request that passes the check of `canQueueRequest()`
+/// @note The queued request is serviced by this request and is completed along with this request.
+///       The caller must invoke `detachMergedRequest()` to finalize queued requests once this request has been serviced.
+///
+void IOSDSimpleBlockRequest::queueRequest(IOSDSimpleBlockRequest* request)
+{
+    passert(this->numMergedRequests < kMaxNumMergedRequests, "The number of queued requests should not exceed the limit.");
+    
+    passert(this->numMergedRequests == 0 || this->queued, "Requests that have been merged cannot be queued.");
+    
+    if (this->numMergedRequests == 0)
+    {
+        this->mergedRequests[0] = this;
+        
+        this->numMergedRequests = 1;
+        
+        this->queued = true;
+    }
+    
+    this->mergedRequests[this->numMergedRequests] = request;
+    
+    this->numMergedRequests += 1;
+    
+    pinfo("Queued the request [%llu, %llu). %u requests will be serviced together.", request->block, request->block + request->nblocks, this->numMergedRequests);
+}
+
+///
+/// Get the number of blocks accessed by all merged requests
+///
+/// @return The total number of blocks.
+///
+UInt64 IOSDSimpleBlockRequest::getMergedNumBlocks()
+{
+    if (this->numMergedRequests == 0)
+    {
+        return this->nblocks;
+    }
+    
+    UInt64 nblocks = 0;
+    
+    for (IOItemCount index = 0; index < this->numMergedRequests; index += 1)
+    {
+        nblocks += this->mergedRequests[index]->nblocks;
+    }
+    
+    return nblocks;
+}
+
+//
+// MARK: - Service Requests
+//
+
 ///
 /// Service the block request
 ///
 void IOSDSimpleBlockRequest::service()
 {
+    // Merge adjacent pending requests into this one if possible
+    this->driver->mergeAdjacentBlockRequests(this);
+    
+    // Otherwise, queue random pending reads along with this one if the card supports the command queue
+    if (this->numMergedRequests == 0)
+    {
+        this->driver->queueRandomReadRequests(this);
+    }
+    
     // Service the request
     pinfo("Processing the request...");
     
-    IOReturn status = this->serviceOnce();
+    IOSDBlockRequestStatistics::Snapshot snapshot;
+    
+    this->driver->willServiceBlockRequest(snapshot);
+    
+    IOReturn statuses[kMaxNumMergedRequests];
+    
+    IOReturn status;
+    
+    if (this->numMergedRequests == 0)
+    {
+        status = this->serviceOnce();
+    }
+    else if (this->queued)
+    {
+        status = this->serviceQueuedRequests(statuses);
+    }
+    else
+    {
+        status = this->serviceMergedRequests(statuses);
+    }
+    
+    this->driver->didServiceBlockRequest(snapshot, this->buffer->getDirection(), this->getMergedNumBlocks(), status);
+    
+    // Release the transfer prepared ahead of time if the request has been serviced without it
+    if (this->numMergedRequests == 0)
+    {
+        this->driver->didServiceBlockRequestAhead(this);
+    }
+    else
+    {
+        for (IOItemCount index = 0; index < this->numMergedRequests; index += 1)
+        {
+            this->driver->didServiceBlockRequestAhead(this->mergedRequests[index]);
+        }
+    }
     
     // Complete the request
-    UInt64 actualByteCount = status == kIOReturnSuccess ? this->nblocks * 512 : 0;
-
-    IOStorage::complete(&this->completion, status, actualByteCount);
+    if (this->numMergedRequests == 0)
+    {
+        UInt64 actualByteCount = status == kIOReturnSuccess ? this->nblocks * 512 : 0;
+        
+        IOStorage::complete(&this->completion, status, actualByteCount);
+    }
+    else
+    {
+        // Complete each merged or queued request with its own status and byte count
+        for (IOItemCount index = 0; index < this->numMergedRequests; index += 1)
+        {
+            IOSDSimpleBlockRequest* request = this->mergedRequests[index];
+            
+            UInt64 actualByteCount = statuses[index] == kIOReturnSuccess ? request->nblocks * 512 : 0;
+            
+            IOStorage::complete(&request->completion, statuses[index], actualByteCount);
+        }
+    }
     
     pinfo("The request is completed. Return value = 0x%08x.", status);
 }
@@ -146,3 +422,115 @@ IOReturn IOSDSimpleBlockRequest::serviceOnce()
     
     return IOMemoryDescriptorRunActionWhilePrepared(this->buffer, action);
 }
+
+///
+/// Service all merged requests in one DMA transaction
+///
+/// @param statuses An array that stores the service status of each merged request on return
+/// @return `kIOReturnSuccess` if all merged requests complete without errors, other values otherwise.
+/// @note This function temporarily replaces the data transfer buffer with a chained memory descriptor,
+///       so that the processor routine can service the merged request as if it were a single one.
+/// @note If the merged request fails, this function services each request separately,
+///       so that one bad block does not fail requests that do not access it.
+///
+IOReturn IOSDSimpleBlockRequest::serviceMergedRequests(IOReturn* statuses)
+{
+    IOReturn retVal = this->serviceMergedRequestsOnce();
+    
+    if (retVal == kIOReturnSuccess)
+    {
+        for (IOItemCount index = 0; index < this->numMergedRequests; index += 1)
+        {
+            statuses[index] = kIOReturnSuccess;
+        }
+        
+        return kIOReturnSuccess;
+    }
+    
+    perr("Failed to service %u merged requests. Will service them separately. Error = 0x%x.", this->numMergedRequests, retVal);
+    
+    retVal = kIOReturnSuccess;
+    
+    for (IOItemCount index = 0; index < this->numMergedRequests; index += 1)
+    {
+        statuses[index] = this->mergedRequests[index]->serviceOnce();
+        
+        if (statuses[index] != kIOReturnSuccess)
+        {
+            retVal = statuses[index];
+        }
+    }
+    
+    return retVal;
+}
+
+///
+/// [Helper] Service all merged requests in one DMA transaction
+///
+/// @return `kIOReturnSuccess` if the merged request completes without errors, other values otherwise.
+///
+IOReturn IOSDSimpleBlockRequest::serviceMergedRequestsOnce()
+{
+    // Chain the data transfer buffers in the order of their starting block numbers
+    IOMemoryDescriptor* buffers[kMaxNumMergedRequests];
+    
+    for (IOItemCount index = 0; index < this->numMergedRequests; index += 1)
+    {
+        buffers[index] = this->mergedRequests[index]->buffer;
+    }
+    
+    IOMultiMemoryDescriptor* mbuffer = IOMultiMemoryDescriptor::withDescriptors(buffers, this->numMergedRequests, this->buffer->getDirection(), false);
+    
+    if (mbuffer == nullptr)
+    {
+        perr("Failed to create the memory descriptor to service %u merged requests.", this->numMergedRequests);
+        
+        return kIOReturnNoMemory;
+    }
+    
+    // Service the merged request as if it were a single one
+    Processor processor = this->processor;
+    
+    IOMemoryDescriptor* buffer = this->buffer;
+    
+    UInt64 block = this->block;
+    
+    UInt64 nblocks = this->nblocks;
+    
+    this->processor = this->mergedProcessor;
+    
+    this->buffer = mbuffer;
+    
+    this->block = this->mergedRequests[0]->block;
+    
+    this->nblocks = this->getMergedNumBlocks();
+    
+    pinfo("Servicing %u merged requests: Start Block Index = %llu; Number of Blocks = %llu.", this->numMergedRequests, this->block, this->nblocks);
+    
+    IOReturn retVal = this->serviceOnce();
+    
+    this->processor = processor;
+    
+    this->buffer = buffer;
+    
+    this->block = block;
+    
+    this->nblocks = nblocks;
+    
+    mbuffer->release();
+    
+    return retVal;
+}
+
+///
+/// Service all queued requests as separate tasks in the command queue of the card
+///
+/// @param statuses An array that stores the service status of each queued request on return
+/// @return `kIOReturnSuccess` if all queued requests complete without errors, other values otherwise.
+///
+IOReturn IOSDSimpleBlockRequest::serviceQueuedRequests(IOReturn* statuses)
+{
+    pinfo("Servicing %u queued requests.", this->numMergedRequests);
+    
+    return this->driver->processQueuedReadRequests(this->mergedRequests, this->numMergedRequests, statuses);
+}
@@ -51,6 +51,28 @@ class IOSDSimpleBlockRequest: public IOSDBlockRequest
     /// The completion routine to call once the data transfer completes
     IOStorageCompletion completion;
     
+    /// The maximum number of requests that can be serviced together in one DMA transaction or as separate tasks
+    static constexpr IOItemCount kMaxNumMergedRequests = 16;
+    
+    ///
+    /// Requests (including this one) that are merged and serviced together sorted by their starting block number
+    ///
+    /// @note The host driver merges adjacent pending requests into this one right before it is serviced.
+    ///       Only the first `numMergedRequests` elements are valid, and `numMergedRequests` is 0 if no request has been merged.
+    /// @note If `queued` is `true`, these requests are not adjacent and are serviced as separate tasks in the command queue of the card.
+    ///       In this case, requests are kept in the order in which they are queued, and the index of each request is its task ID.
+    ///
+    IOSDSimpleBlockRequest* mergedRequests[kMaxNumMergedRequests];
+    
+    /// The number of requests that are merged and serviced together
+    IOItemCount numMergedRequests;
+    
+    /// `true` if the requests in `mergedRequests` are queued as separate tasks instead of being merged into one DMA transaction
+    bool queued;
+    
+    /// The routine to process the merged request that accesses multiple blocks, `nullptr` if no request has been merged
+    Processor mergedProcessor;
+    
 public:
     ///
     /// Initialize a block request
@@ -107,6 +129,52 @@ public:
     ///
     UInt64 getNumBlocks() override;
     
+    ///
+    /// Check whether the given request can be merged into this one
+    ///
+    /// @param request A non-null pending block request
+    /// @param maxNumBlocks The maximum number of blocks in one DMA transaction
+    /// @return `true` if the given request is a simple request that accesses blocks right before or after the ones accessed by this request
+    ///         in the same direction with the same attributes, and the total number of blocks does not exceed the given limit.
+    ///
+    bool canMergeRequest(IOSDBlockRequest* request, UInt64 maxNumBlocks);
+    
+    ///
+    /// Merge the given request into this one
+    ///
+    /// @param request A non-null simple block request that passes the check of `canMergeRequest()`
+    /// @param processor The routine to process the merged request that accesses multiple blocks
+    /// @note The merged request is serviced by this request and is completed along with this request.
+    ///       The caller must invoke `detachMergedRequest()` to finalize merged requests once this request has been serviced.
+    ///
+    void mergeRequest(IOSDSimpleBlockRequest* request, Processor processor);
+    
+    ///
+    /// Detach a request that has been merged into this one
+    ///
+    /// @return A request merged into this one, `nullptr` if no more merged requests.
+    ///
+    IOSDSimpleBlockRequest* detachMergedRequest();
+    
+    ///
+    /// Check whether the given request can be queued as a separate task along with this one
+    ///
+    /// @param request A non-null pending block request
+    /// @param maxNumRequests The maximum number of tasks in the command queue
+    /// @return `true` if the given request is a simple request that transfers data in the same direction as this one,
+    ///         and the total number of requests does not exceed the given limit.
+    ///
+    bool canQueueRequest(IOSDBlockRequest* request, IOItemCount maxNumRequests);
+    
+    ///
+    /// Queue the given request as a separate task along with this one
+    ///
+    /// @param request A non-null simple block request that passes the check of `canQueueRequest()`
+    /// @note The queued request is serviced by this request and is completed along with this request.
+    ///       The caller must invoke `detachMergedRequest()` to finalize queued requests once this request has been serviced.
+    ///
+    void queueRequest(IOSDSimpleBlockRequest* request);
+    
 protected:
     ///
     /// Service the block request once
@@ -114,6 +182,40 @@ protected:
     /// @return `kIOReturnSuccess` if the block request completes without errors, other values otherwise.
     ///
     IOReturn serviceOnce();
+    
+    ///
+    /// Service all merged requests in one DMA transaction
+    ///
+    /// @param statuses An array that stores the service status of each merged request on return
+    /// @return `kIOReturnSuccess` if all merged requests complete without errors, other values otherwise.
+    /// @note This function temporarily replaces the data transfer buffer with a chained memory descriptor,
+    ///       so that the processor routine can service the merged request as if it were a single one.
+    /// @note If the merged request fails, this function services each request separately,
+    ///       so that one bad block does not fail requests that do not access it.
+    ///
+    IOReturn serviceMergedRequests(IOReturn* statuses);
+    
+    ///
+    /// [Helper] Service all merged requests in one DMA transaction
+    ///
+    /// @return `kIOReturnSuccess` if the merged request completes without errors, other values otherwise.
+    ///
+    IOReturn serviceMergedRequestsOnce();
+    
+    ///
+    /// Service all queued requests as separate tasks in the command queue of the card
+    ///
+    /// @param statuses An array that stores the service status of each queued request on return
+    /// @return `kIOReturnSuccess` if all queued requests complete without errors, other values otherwise.
+    ///
+    IOReturn serviceQueuedRequests(IOReturn* statuses);
+    
+    ///
+    /// Get the number of blocks accessed by all merged requests
+    ///
+    /// @return The total number of blocks.
+    ///
+    UInt64 getMergedNumBlocks();
 };
 
 #endif /* IOSDSimpleBlockRequest_hpp */
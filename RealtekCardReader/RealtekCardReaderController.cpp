@@ -180,7 +180,14 @@ IOReturn RealtekCardReaderController::enqueueCommand(const Command& command)
     // The enqueue routine will run in a gated context
     auto action = [&]() -> IOReturn
     {
-        return this->enqueueCommandGated(command);
+        IOReturn retVal = this->enqueueCommandGated(command);
+        
+        if (retVal == kIOReturnSuccess)
+        {
+            this->transferCounters.numHostCommands += 1;
+        }
+        
+        return retVal;
     };
     
     return IOCommandGateRunAction(this->commandGate, action);
@@ -200,6 +207,8 @@ IOReturn RealtekCardReaderController::endCommandTransfer(UInt32 timeout, UInt32
     // The transfer routine will run in a gated context
     auto action = [&]() -> IOReturn
     {
+        this->transferCounters.numCommandTransfers += 1;
+        
         return this->endCommandTransferGated(timeout, flags);
     };
     
@@ -233,6 +242,8 @@ IOReturn RealtekCardReaderController::endCommandTransferNoWait(UInt32 flags)
     // The transfer routine will run in a gated context
     auto action = [&]() -> IOReturn
     {
+        this->transferCounters.numCommandTransfers += 1;
+        
         return this->endCommandTransferNoWaitGated(flags);
     };
     
@@ -271,6 +282,123 @@ IOReturn RealtekCardReaderController::loadCommandTransferResponse(UInt32 timeout
     return IOCommandGateRunAction(this->commandGate, action);
 }
 
+//
+// MARK: - Host Data Management
+//
+
+///
+/// Prepare the DMA transfer of the given memory descriptor ahead of time
+///
+/// @param descriptor A non-null memory descriptor that will be passed to `performDMARead/Write()` later
+/// @return `kIOReturnSuccess` on success, `kIOReturnUnsupported` if the controller cannot prepare a DMA transfer ahead of time.
+/// @note This function is invoked by the host device while the current DMA transfer is in flight.
+///       The default implementation does nothing and returns `kIOReturnUnsupported`.
+///
+IOReturn RealtekCardReaderController::prepareDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    return kIOReturnUnsupported;
+}
+
+///
+/// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+///
+/// @param descriptor A non-null memory descriptor that has been passed to `prepareDMATransferAhead()`
+/// @note The default implementation does nothing.
+///
+void RealtekCardReaderController::discardDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    // Nothing has been prepared ahead of time by default
+}
+
+///
+/// Start a DMA read operation without waiting for its completion
+///
+/// @param descriptor A non-null, perpared memory descriptor
+/// @param timeout Specify the amount of time in milliseconds
+/// @param completion The completion routine to call once the transfer completes
+/// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+/// @note The completion routine is invoked in a gated context if and only if this function returns `kIOReturnSuccess`.
+///       The caller is responsible for clearing the host error if the transfer fails.
+/// @note The default implementation performs the transfer synchronously and then invokes the completion routine.
+///       The concrete controller should override this function if it can deliver the completion from its interrupt path.
+///
+IOReturn RealtekCardReaderController::startDMARead(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion)
+{
+    IOReturn status = this->performDMARead(descriptor, timeout);
+    
+    auto action = [&]() -> IOReturn
+    {
+        completion.invoke(status);
+        
+        return kIOReturnSuccess;
+    };
+    
+    return IOCommandGateRunAction(this->commandGate, action);
+}
+
+///
+/// Start a DMA write operation without waiting for its completion
+///
+/// @param descriptor A non-null, perpared memory descriptor
+/// @param timeout Specify the amount of time in milliseconds
+/// @param completion The completion routine to call once the transfer completes
+/// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+/// @note The completion routine is invoked in a gated context if and only if this function returns `kIOReturnSuccess`.
+///       The caller is responsible for clearing the host error if the transfer fails.
+/// @note The default implementation performs the transfer synchronously and then invokes the completion routine.
+///       The concrete controller should override this function if it can deliver the completion from its interrupt path.
+///
+IOReturn RealtekCardReaderController::startDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion)
+{
+    IOReturn status = this->performDMAWrite(descriptor, timeout);
+    
+    auto action = [&]() -> IOReturn
+    {
+        completion.invoke(status);
+        
+        return kIOReturnSuccess;
+    };
+    
+    return IOCommandGateRunAction(this->commandGate, action);
+}
+
+///
+/// Wait until the asynchronous DMA transfer associated with the given status completes
+///
+/// @param status A non-null status that is `kIOReturnNotReady` until the transfer completes
+/// @return The final status of the transfer.
+/// @note The completion routine of the transfer must store the status and then invoke `onDMATransferDoneGated()`.
+///
+IOReturn RealtekCardReaderController::waitForDMATransfer(IOReturn* status)
+{
+    auto action = [&]() -> IOReturn
+    {
+        // The transfer may have completed before the gate is acquired
+        while (*status == kIOReturnNotReady)
+        {
+            this->commandGate->commandSleep(status);
+        }
+        
+        return *status;
+    };
+    
+    return IOCommandGateRunAction(this->commandGate, action);
+}
+
+///
+/// Store the status of an asynchronous DMA transfer and wake up the thread waiting for it
+///
+/// @param status A non-null status passed to `waitForDMATransfer()`
+/// @param result The final status of the transfer
+/// @note This function must be invoked in a gated context (e.g. by the completion routine of the transfer).
+///
+void RealtekCardReaderController::onDMATransferDoneGated(IOReturn* status, IOReturn result)
+{
+    *status = result;
+    
+    this->commandGate->commandWakeup(status);
+}
+
 //
 // MARK: - Clear Error
 //
@@ -888,6 +1016,8 @@ bool RealtekCardReaderController::init(OSDictionary* dictionary)
     
     this->dataTransferFlags.reset();
     
+    this->transferCounters.reset();
+    
     this->currentCardStatus = 0;
     
     return true;
@@ -342,6 +342,130 @@ public:
         }
     };
     
+    ///
+    /// Counters of the work performed by the controller on behalf of the host device
+    ///
+    /// @note Counters increase monotonically while the controller is running.
+    ///       The caller should take a snapshot before and after an operation to measure its overhead.
+    ///
+    struct TransferCounters
+    {
+        /// The number of chip registers accessed individually (i.e. outside of a host command transfer session)
+        UInt64 numRegisterAccesses;
+        
+        /// The number of commands enqueued to the host command buffer
+        UInt64 numHostCommands;
+        
+        /// The number of host command transfer sessions sent to the device
+        UInt64 numCommandTransfers;
+        
+        /// The number of DMA transfers initiated by the host
+        UInt64 numDMATransfers;
+        
+        /// The number of hardware interrupts serviced by the host
+        UInt64 numInterrupts;
+        
+        /// The number of transfers whose completion was detected by polling instead of an interrupt
+        UInt64 numPolledCompletions;
+        
+        /// Reset all counters to zero
+        inline void reset()
+        {
+            this->numRegisterAccesses = 0;
+            
+            this->numHostCommands = 0;
+            
+            this->numCommandTransfers = 0;
+            
+            this->numDMATransfers = 0;
+            
+            this->numInterrupts = 0;
+            
+            this->numPolledCompletions = 0;
+        }
+    };
+    
+    ///
+    /// Type of a completion routine that is called once an asynchronous DMA transfer completes
+    ///
+    /// @param target An opaque client-supplied pointer (or the instance pointer for a C++ callback)
+    /// @param parameter An opaque client-supplied parameter pointer
+    /// @param status `kIOReturnSuccess` if the transfer has succeeded, `kIOReturnTimeout` if timed out, other values otherwise.
+    ///
+    using DMACompletionAction = void (*)(void* target, void* parameter, IOReturn status);
+    
+    ///
+    /// Describe the completion routine to be called when an asynchronous DMA transfer completes
+    ///
+    struct DMACompletion
+    {
+    private:
+        /// An opaque client-supplied pointer (or the instance pointer for a C++ callback)
+        void* target;
+        
+        /// A non-null completion routine
+        DMACompletionAction action;
+        
+        /// An opaque client-supplied parameter pointer
+        void* parameter;
+        
+    public:
+        ///
+        /// Default constructor
+        ///
+        DMACompletion() = default;
+        
+        ///
+        /// Create a completion routine
+        ///
+        DMACompletion(void* target, DMACompletionAction action, void* parameter = nullptr) :
+            target(target), action(action), parameter(parameter) {}
+        
+        ///
+        /// Invoke the completion routine
+        ///
+        /// @param status `kIOReturnSuccess` if the transfer has succeeded, `kIOReturnTimeout` if timed out, other values otherwise.
+        /// @warning This function prints a warning message if the action routine is null.
+        ///
+        inline void invoke(IOReturn status)
+        {
+            if (this->action != nullptr)
+            {
+                (*this->action)(this->target, this->parameter, status);
+            }
+            else
+            {
+                pwarning("The action routine is null.");
+            }
+        }
+        
+        ///
+        /// Reset the completion routine
+        ///
+        inline void reset()
+        {
+            this->target = nullptr;
+            
+            this->action = nullptr;
+            
+            this->parameter = nullptr;
+        }
+        
+        ///
+        /// Create a completion descriptor with the given member function
+        ///
+        /// @param self The instance pointer for the given C++ callback function
+        /// @param function A C++ callback function
+        /// @param parameter An optional opaque parameter pointer
+        /// @return The completion routine.
+        ///
+        template <typename Function>
+        static DMACompletion withMemberFunction(OSObject* self, Function function, void* parameter = nullptr)
+        {
+            return { self, OSMemberFunctionCast(DMACompletionAction, self, function), parameter };
+        }
+    };
+    
     //
     // MARK: - Controller-Independent Data Structures (Private)
     //
@@ -640,6 +764,9 @@ protected:
     /// Flags passed to each data transfer operation
     DataTransferFlags dataTransferFlags;
     
+    /// Counters of the work performed by the controller
+    TransferCounters transferCounters;
+    
     ///
     /// The current card status
     ///
@@ -694,6 +821,38 @@ public:
         return this->dataTransferFlags;
     }
     
+    /// Get the counters of the work performed by the controller
+    inline const TransferCounters& getTransferCounters()
+    {
+        return this->transferCounters;
+    }
+    
+    ///
+    /// Check whether the controller can execute host commands queued after a DMA transfer in the same session
+    ///
+    /// @return `true` if the response to those commands can be loaded once the DMA transfer completes, `false` otherwise.
+    /// @note The host device waits for the commands queued after the DMA transfer via `loadCommandTransferResponse()`.
+    ///       PCIe-based controllers report the completion of the host command list with a separate interrupt bit,
+    ///       and USB-based controllers return the response to the host command list in a separate bulk transfer.
+    ///
+    virtual bool canQueueCommandsAfterDMATransfer()
+    {
+        return false;
+    }
+    
+    ///
+    /// Get the number of bytes in the ping pong buffer that can be read in the current host command transfer session
+    ///
+    /// @return The number of read register commands that can still be enqueued in the current session,
+    ///         `0` if the controller must read the ping pong buffer in a separate session.
+    /// @note The host device may read the ping pong buffer in the same session as the data transfer that fills it,
+    ///       so that the transfer status and the data are returned by a single round trip.
+    ///
+    virtual IOItemCount getPingPongBufferReadCapacityInSession()
+    {
+        return 0;
+    }
+    
     //
     // MARK: - Access Chip Registers
     //
@@ -1149,6 +1308,70 @@ public:
     ///
     virtual IOReturn performDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout) = 0;
     
+    ///
+    /// Start a DMA read operation without waiting for its completion
+    ///
+    /// @param descriptor A non-null, perpared memory descriptor
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @param completion The completion routine to call once the transfer completes
+    /// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+    /// @note The completion routine is invoked in a gated context if and only if this function returns `kIOReturnSuccess`.
+    ///       The caller is responsible for clearing the host error if the transfer fails.
+    /// @note The default implementation performs the transfer synchronously and then invokes the completion routine.
+    ///       The concrete controller should override this function if it can deliver the completion from its interrupt path.
+    ///
+    virtual IOReturn startDMARead(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion);
+    
+    ///
+    /// Start a DMA write operation without waiting for its completion
+    ///
+    /// @param descriptor A non-null, perpared memory descriptor
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @param completion The completion routine to call once the transfer completes
+    /// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+    /// @note The completion routine is invoked in a gated context if and only if this function returns `kIOReturnSuccess`.
+    ///       The caller is responsible for clearing the host error if the transfer fails.
+    /// @note The default implementation performs the transfer synchronously and then invokes the completion routine.
+    ///       The concrete controller should override this function if it can deliver the completion from its interrupt path.
+    ///
+    virtual IOReturn startDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion);
+    
+    ///
+    /// Wait until the asynchronous DMA transfer associated with the given status completes
+    ///
+    /// @param status A non-null status that is `kIOReturnNotReady` until the transfer completes
+    /// @return The final status of the transfer.
+    /// @note The completion routine of the transfer must store the status and then invoke `onDMATransferDoneGated()`.
+    ///
+    IOReturn waitForDMATransfer(IOReturn* status);
+    
+    ///
+    /// Store the status of an asynchronous DMA transfer and wake up the thread waiting for it
+    ///
+    /// @param status A non-null status passed to `waitForDMATransfer()`
+    /// @param result The final status of the transfer
+    /// @note This function must be invoked in a gated context (e.g. by the completion routine of the transfer).
+    ///
+    void onDMATransferDoneGated(IOReturn* status, IOReturn result);
+    
+    ///
+    /// Prepare the DMA transfer of the given memory descriptor ahead of time
+    ///
+    /// @param descriptor A non-null memory descriptor that will be passed to `performDMARead/Write()` later
+    /// @return `kIOReturnSuccess` on success, `kIOReturnUnsupported` if the controller cannot prepare a DMA transfer ahead of time.
+    /// @note This function is invoked by the host device while the current DMA transfer is in flight.
+    ///       The default implementation does nothing and returns `kIOReturnUnsupported`.
+    ///
+    virtual IOReturn prepareDMATransferAhead(IOMemoryDescriptor* descriptor);
+    
+    ///
+    /// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+    ///
+    /// @param descriptor A non-null memory descriptor that has been passed to `prepareDMATransferAhead()`
+    /// @note The default implementation does nothing.
+    ///
+    virtual void discardDMATransferAhead(IOMemoryDescriptor* descriptor);
+    
     //
     // MARK: - Clear Error
     //
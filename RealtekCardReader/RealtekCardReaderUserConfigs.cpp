@@ -14,6 +14,12 @@ namespace UserConfigs::COM
     /// The amount of time in milliseconds to wait until the SSC clock becomes stable
     /// If the value is too small, ACMD6 may timeout after the driver switches the clock
     UInt32 DelayStableSSCClock = max(BootArgs::get("rtsxdssc", 10), 1);
+    
+    /// `True` if the card reader should send the data transfer command in a separate session before the DMA transfer
+    bool SeparateCommandAndDataTransfer = BootArgs::contains("-rtsxscdt");
+    
+    /// `True` if the card reader should also send the block write command as part of the DMA transfer
+    bool FuseWriteCommandAndDataTransfer = BootArgs::contains("-rtsxfwdt");
 }
 
 /// Boot arguments that customize the PCIe-based card reader controller
@@ -22,6 +28,13 @@ namespace UserConfigs::PCR
     /// The amount of time in milliseconds to delay the card initialization
     /// if the card is present when the driver starts
     UInt32 DelayCardInitAtBoot = BootArgs::get("rtsxdcib", 100);
+    
+    /// The amount of time in microseconds to poll for the completion of a short transfer before sleeping
+    /// A value of 0 disables polling, so the driver always waits for the interrupt
+    UInt32 CompletionPollingWindow = min(BootArgs::get("rtsxcpw", 0), 1000);
+    
+    /// The maximum number of bytes in a DMA transfer that is considered short enough to poll for its completion
+    UInt32 CompletionPollingMaxLength = BootArgs::get("rtsxcpml", 4096);
 }
 
 /// Boot arguments that customize the USB-based card reader controller
@@ -29,4 +42,25 @@ namespace UserConfigs::UCR
 {
     /// The amount of time in milliseconds to poll for the device status
     UInt32 DeviceStatusPollingInterval = max(BootArgs::get("rtsxdspi", 500), 100);
+    
+    /// `True` if the polling interval adapts to the data transfer activity
+    bool AdaptiveDeviceStatusPolling = !BootArgs::contains("-rtsxfdsp");
+    
+    /// The amount of time in milliseconds to poll for the device status while the host is idle (adaptive polling)
+    UInt32 DeviceStatusPollingIntervalIdle = max(BootArgs::get("rtsxdspii", 200), 50);
+    
+    /// The maximum amount of time in milliseconds to poll for the device status while the host is busy (adaptive polling)
+    UInt32 DeviceStatusPollingIntervalBusy = max(BootArgs::get("rtsxdspib", 2000), DeviceStatusPollingIntervalIdle);
+    
+    /// The number of bytes transferred by each bulk transfer that belongs to a DMA transfer
+    /// The chunk size is a multiple of 4 KB, so intermediate bulk transfers always end with a full packet
+    UInt32 BulkTransferChunkSize = align(max(BootArgs::get("rtsxbtcs", 65536), 4096), 4096);
+    
+    /// The maximum number of bulk transfers in flight that belong to a single DMA transfer
+    /// A value of 1 disables splitting DMA transfers into multiple bulk transfers
+    UInt32 MaxNumOutstandingBulkTransfers = min(max(BootArgs::get("rtsxmobt", 4), 1), 8);
+    
+    /// `True` if the controller should initiate the inbound bulk transfer that loads the response
+    /// after the outbound bulk transfer that sends the host commands completes
+    bool SerializeCommandAndResponseTransfers = BootArgs::contains("-rtsxscrt");
 }
@@ -16,6 +16,12 @@ namespace UserConfigs::COM
     /// The amount of time in milliseconds to wait until the SSC clock becomes stable
     /// If the value is too small, ACMD6 may timeout after the driver switches the clock
     extern UInt32 DelayStableSSCClock;
+    
+    /// `True` if the card reader should send the data transfer command in a separate session before the DMA transfer
+    extern bool SeparateCommandAndDataTransfer;
+    
+    /// `True` if the card reader should also send the block write command as part of the DMA transfer
+    extern bool FuseWriteCommandAndDataTransfer;
 }
 
 /// Boot arguments that customize the PCIe-based card reader controller
@@ -24,6 +30,13 @@ namespace UserConfigs::PCR
     /// The amount of time in milliseconds to delay the card initialization
     /// if the card is present when the driver starts
     extern UInt32 DelayCardInitAtBoot;
+    
+    /// The amount of time in microseconds to poll for the completion of a short transfer before sleeping
+    /// A value of 0 disables polling, so the driver always waits for the interrupt
+    extern UInt32 CompletionPollingWindow;
+    
+    /// The maximum number of bytes in a DMA transfer that is considered short enough to poll for its completion
+    extern UInt32 CompletionPollingMaxLength;
 }
 
 /// Boot arguments that customize the USB-based card reader controller
@@ -31,6 +44,26 @@ namespace UserConfigs::UCR
 {
     /// The amount of time in milliseconds to poll for the device status
     extern UInt32 DeviceStatusPollingInterval;
+    
+    /// `True` if the polling interval adapts to the data transfer activity
+    extern bool AdaptiveDeviceStatusPolling;
+    
+    /// The amount of time in milliseconds to poll for the device status while the host is idle (adaptive polling)
+    extern UInt32 DeviceStatusPollingIntervalIdle;
+    
+    /// The maximum amount of time in milliseconds to poll for the device status while the host is busy (adaptive polling)
+    extern UInt32 DeviceStatusPollingIntervalBusy;
+    
+    /// The number of bytes transferred by each bulk transfer that belongs to a DMA transfer
+    extern UInt32 BulkTransferChunkSize;
+    
+    /// The maximum number of bulk transfers in flight that belong to a single DMA transfer
+    /// A value of 1 disables splitting DMA transfers into multiple bulk transfers
+    extern UInt32 MaxNumOutstandingBulkTransfers;
+    
+    /// `True` if the controller should initiate the inbound bulk transfer that loads the response
+    /// after the outbound bulk transfer that sends the host commands completes
+    extern bool SerializeCommandAndResponseTransfers;
 }
 
 #endif /* RealtekCardReaderUserConfigs_hpp */
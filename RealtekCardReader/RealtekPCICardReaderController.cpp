@@ -269,6 +269,8 @@ IOReturn RealtekPCICardReaderController::readChipRegister(UInt16 address, UInt8&
     // Start the operation by writing the address with busy bit set to the chip
     this->writeRegister32(rHAIMR, HAIMR::RegValueForReadOperation(address));
     
+    this->transferCounters.numRegisterAccesses += 1;
+    
     // Wait until the device is free to finish the operation
     for (auto attempt = 0; attempt < HAIMR::kMaxAttempts; attempt += 1)
     {
@@ -310,6 +312,8 @@ IOReturn RealtekPCICardReaderController::writeChipRegister(UInt16 address, UInt8
     // Start the operation by writing the address, mask and value with busy and write bits set to the chip
     this->writeRegister32(rHAIMR, HAIMR::RegValueForWriteOperation(address, mask, value));
     
+    this->transferCounters.numRegisterAccesses += 1;
+    
     // Wait until the device is free to finish the operation
     for (auto attempt = 0; attempt < HAIMR::kMaxAttempts; attempt += 1)
     {
@@ -614,18 +618,9 @@ IOReturn RealtekPCICardReaderController::endCommandTransferGated(UInt32 timeout,
     
     this->writeRegister32(rHCBCTLR, HCBCTLR::RegValueForStartCommand(this->hostCommandCounter.total));
     
-    // Set up the timer
-    passert(this->hostBufferTimer != nullptr, "The host buffer timer should not be NULL.");
-    
-    passert(this->hostBufferTimer->setTimeoutMS(timeout) == kIOReturnSuccess, "Should be able to set the timeout.");
-    
     // Wait for the transfer result
-    // Block the current thread and release the gate
-    // Either the timeout handler or the interrupt handler will modify the status and wakeup the current thread
-    this->commandGate->commandSleep(&this->hostBufferTransferStatus);
-    
-    // When the sleep function returns, the transfer is done
-    return this->hostBufferTransferStatus;
+    // Host command transfers are short, so it is worth polling for their completion
+    return this->waitForTransferDoneGated(timeout, true);
 }
 
 ///
@@ -645,6 +640,8 @@ IOReturn RealtekPCICardReaderController::endCommandTransferNoWaitGated(UInt32 fl
     
     this->hostBufferTransferStatus = kIOReturnNotReady;
     
+    this->pendingCommandTransferStatus = kIOReturnNotReady;
+    
     this->writeRegister32(rHCBAR, this->hostBufferAddress);
     
     this->writeRegister32(rHCBCTLR, HCBCTLR::RegValueForStartCommand(this->hostCommandCounter.total));
@@ -657,14 +654,41 @@ IOReturn RealtekPCICardReaderController::endCommandTransferNoWaitGated(UInt32 fl
 ///
 /// @param timeout Specify the amount of time in milliseconds
 /// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if timed out, other values otherwise.
-/// @note Port: This function is a noop and returns `kIOReturnSuccess` for PCIe-based card reader controllers.
 /// @note Port: This function replaces `rtsx_usb_get_rsp()` (the original version) defined in `rtsx_usb.c`.
+/// @note PCIe-based card reader controllers write the response to the host command buffer by themselves,
+///       so this function only waits until the card reader has executed all host commands in the session
+///       started by `endCommandTransferNoWait()`, including those queued after the DMA transfer.
 /// @note This function runs in a gated context.
 ///
 IOReturn RealtekPCICardReaderController::loadCommandTransferResponseGated(UInt32 timeout)
 {
-    // PCIe-based card reader controllers do not need to explicitly load the response.
-    return kIOReturnSuccess;
+    // Guard: Check whether the card reader has executed all host commands
+    //        The DMA transfer completes before the host commands queued after it (e.g. the STOP command) are executed
+    if (this->pendingCommandTransferStatus != kIOReturnNotReady)
+    {
+        return this->pendingCommandTransferStatus;
+    }
+    
+    pinfo("Waiting for the card reader to execute the remaining host commands...");
+    
+    UInt64 deadline;
+    
+    clock_interval_to_deadline(timeout, kMillisecondScale, &deadline);
+    
+    while (this->pendingCommandTransferStatus == kIOReturnNotReady)
+    {
+        // Block the current thread and release the gate
+        // The interrupt handler will modify the status and wakeup the current thread
+        if (this->commandGate->commandSleep(&this->pendingCommandTransferStatus, deadline, THREAD_UNINT) == THREAD_TIMED_OUT &&
+            this->pendingCommandTransferStatus == kIOReturnNotReady)
+        {
+            perr("Timed out while waiting for the card reader to execute the remaining host commands.");
+            
+            this->pendingCommandTransferStatus = kIOReturnTimeout;
+        }
+    }
+    
+    return this->pendingCommandTransferStatus;
 }
 
 //
@@ -688,22 +712,32 @@ UInt64 RealtekPCICardReaderController::transformIOVMSegment(IODMACommand::Segmen
 /// [Helper] Generate a physical scatter/gather list from the given DMA command and enqueue all entries into the host data buffer
 ///
 /// @param command A non-null, perpared DMA command
+/// @param index The index of the host data buffer
 /// @return `kIOReturnSuccess` on success, other values otherwise.
 /// @note Port: This helper function replaces `rtsx_pci_add_sg_tbl()` defined in `rtsx_psr.c`.
 /// @warning The caller must ensure that the given instance of `IODMACommand` is prepared.
 ///
-IOReturn RealtekPCICardReaderController::enqueueDMACommand(IODMACommand* command)
+IOReturn RealtekPCICardReaderController::enqueueDMACommand(IODMACommand* command, UInt32 index)
 {
     using namespace RTSX::MMIO;
     
+    // Ensure that we can do a trick here to generate the list in place
+    static_assert(sizeof(IODMACommand::Segment32) == sizeof(UInt64),
+                  "ABI Error: IODMACommand::Segment32 is no longer 64 bytes long.");
+    
+    static_assert(kMaxNumSegments <= HDBAR::kMaxNumElements,
+                  "The host data buffer cannot hold the maximum number of segments.");
+    
     //
-    // Step 1: Generate a physical scatter/gather list
+    // Step 1: Generate a physical scatter/gather list directly in the host data buffer
     //
     pinfo("Generating a scatter/gather list from the given DMA command...");
     
     UInt64 offset = 0;
     
-    IODMACommand::Segment32 segments[kMaxNumSegments] = {};
+    UInt64* entries = this->getHostDataBuffer(index);
+    
+    IODMACommand::Segment32* segments = reinterpret_cast<IODMACommand::Segment32*>(entries);
     
     UInt32 numSegments = kMaxNumSegments;
     
@@ -723,29 +757,58 @@ IOReturn RealtekPCICardReaderController::enqueueDMACommand(IODMACommand* command
     // and the returned offset should be identical to the length of the memory descriptor.
     psoftassert(command->getMemoryDescriptor()->getLength() == offset, "Detected Inconsistency: Offset != DMA Buffer Length.");
     
-    pinfo("Generated a scatter/gather list from the given DMA command. Offset = %llu; Number of entries = %d.", offset, numSegments);
+    pinfo("Generated a scatter/gather list from the given DMA command. Offset = %llu; Number of segments = %d.", offset, numSegments);
+    
+    // Guard: The list must contain at least one segment
+    if (numSegments == 0)
+    {
+        perr("The scatter/gather list generated from the given DMA command is empty.");
+        
+        return kIOReturnBadArgument;
+    }
     
     //
-    // Step 2: Enqueue each scatter/gather list entry
+    // Step 2: Coalesce physically contiguous segments and convert each of them to an entry in place
     //
-    // Ensure that we can do a trick here to reuse the buffer
-    static_assert(sizeof(IODMACommand::Segment32) == sizeof(UInt64),
-                  "ABI Error: IODMACommand::Segment32 is no longer 64 bytes long.");
+    // Each entry is written at an index no greater than the one of the segment being read,
+    // so a segment is always consumed before its slot is overwritten.
+    IODMACommand::Segment32 current = segments[0];
+    
+    UInt32 numEntries = 0;
     
-    for (auto index = 0; index < numSegments; index += 1)
+    for (UInt32 segmentIndex = 1; segmentIndex < numSegments; segmentIndex += 1)
     {
-        UInt64 entry = this->transformIOVMSegment(segments[index]) | HDBAR::kSGOptionValid | HDBAR::kSGOptionTransferData;
+        IODMACommand::Segment32 next = segments[segmentIndex];
+        
+        if (current.fIOVMAddr + current.fLength == next.fIOVMAddr &&
+            current.fLength + next.fLength <= kMaxSegmentSize)
+        {
+            current.fLength += next.fLength;
+            
+            continue;
+        }
+        
+        entries[numEntries] = this->transformIOVMSegment(current) | HDBAR::kSGOptionValid | HDBAR::kSGOptionTransferData;
         
         pinfo("[%03d] DMA Bus Address = 0x%08x; Length = %d; Entry = 0x%016llx.",
-              index, segments[index].fIOVMAddr, segments[index].fLength, entry);
+              numEntries, current.fIOVMAddr, current.fLength, entries[numEntries]);
         
-        reinterpret_cast<UInt64*>(segments)[index] = entry;
+        numEntries += 1;
+        
+        current = next;
     }
     
     // The last entry must have the end bit set
-    reinterpret_cast<UInt64*>(segments)[numSegments - 1] |= static_cast<UInt64>(HDBAR::kSGOptionEnd);
+    entries[numEntries] = this->transformIOVMSegment(current) | HDBAR::kSGOptionValid | HDBAR::kSGOptionTransferData | HDBAR::kSGOptionEnd;
+    
+    pinfo("[%03d] DMA Bus Address = 0x%08x; Length = %d; Entry = 0x%016llx.",
+          numEntries, current.fIOVMAddr, current.fLength, entries[numEntries]);
+    
+    numEntries += 1;
     
-    return this->writeHostDataBuffer(0, segments, numSegments * sizeof(UInt64));
+    pinfo("Enqueued %u scatter/gather list entries coalesced from %u segments.", numEntries, numSegments);
+    
+    return kIOReturnSuccess;
 }
 
 ///
@@ -763,10 +826,10 @@ IOReturn RealtekPCICardReaderController::enqueueDMACommand(IODMACommand* command
 IOReturn RealtekPCICardReaderController::performDMATransfer(IODMACommand* command, UInt32 timeout, UInt32 control)
 {
     // Generate the scatter/gather list from the given command
-    // Write all entries in the list to the host data buffer
+    // Write all entries in the list to the current host data buffer
     pinfo("Processing the DMA command...");
     
-    IOReturn retVal = this->enqueueDMACommand(command);
+    IOReturn retVal = this->enqueueDMACommand(command, this->hostDataBufferIndex);
     
     if (retVal != kIOReturnSuccess)
     {
@@ -775,6 +838,20 @@ IOReturn RealtekPCICardReaderController::performDMATransfer(IODMACommand* comman
         return retVal;
     }
     
+    return this->executeDMATransfer(timeout, control, command->getMemoryDescriptor()->getLength());
+}
+
+///
+/// [Helper] Start the DMA transfer described by the current host data buffer and wait for its completion
+///
+/// @param timeout Specify the amount of time in milliseconds
+/// @param control Specify the value that will be written to the register `HDBCTLR` to customize the DMA transfer
+/// @param length The number of bytes to transfer
+/// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if timed out, `kIOReturnError` otherwise.
+/// @note Port: This function replaces `rtsx_pci_dma_transfer()` defined in `rtsx_psr.c`.
+///
+IOReturn RealtekPCICardReaderController::executeDMATransfer(UInt32 timeout, UInt32 control, IOByteCount length)
+{
     // Tell the card reader where to find the data and start the DMA transfer
     // The transfer routine will run in a gated context
     // Returns `kIOReturnTimeout` if the transfer has timed out;
@@ -782,32 +859,36 @@ IOReturn RealtekPCICardReaderController::performDMATransfer(IODMACommand* comman
     //         `kIOReturnError` otherwise.
     auto action = [&]() -> IOReturn
     {
+        // Guard: Check whether the host commands that precede the data transfer have failed
+        //        The card reader stops executing host commands once an operation fails (e.g. the command sent as part of
+        //        the data transfer receives no response), so it will never transfer the data and the transfer would time out.
+        //        Note that the failure interrupt may arrive before this point, so the status of the transfer below cannot tell.
+        if (this->pendingCommandTransferStatus != kIOReturnNotReady && this->pendingCommandTransferStatus != kIOReturnSuccess)
+        {
+            perr("The host commands that precede the data transfer have failed. Will abort the DMA transfer.");
+            
+            return this->pendingCommandTransferStatus;
+        }
+        
         // Tell the device the location of the data buffer and to start the DMA transfer
         using namespace RTSX::MMIO;
         
         this->hostBufferTransferStatus = kIOReturnNotReady;
         
-        this->writeRegister32(rHDBAR, this->hostBufferAddress + RealtekPCICardReaderController::kHostDataBufferOffset);
+        this->writeRegister32(rHDBAR, this->hostBufferAddress + RealtekPCICardReaderController::kHostDataBufferOffset + this->hostDataBufferIndex * kHostDataBufferSize);
         
         this->writeRegister32(rHDBCTLR, control);
         
-        // Set up the timer
-        passert(this->hostBufferTimer != nullptr, "The host buffer timer should not be NULL.");
-        
-        passert(this->hostBufferTimer->setTimeoutMS(timeout) == kIOReturnSuccess, "Should be able to set the timeout.");
+        this->transferCounters.numDMATransfers += 1;
         
         // Wait for the transfer result
-        // Block the current thread and release the gate
-        // Either the timeout handler or the interrupt handler will modify the status and wakeup the current thread
-        this->commandGate->commandSleep(&this->hostBufferTransferStatus);
-        
-        // When the sleep function returns, the transfer is done
-        return this->hostBufferTransferStatus;
+        // Poll for the completion of short transfers only, since long ones would waste CPU cycles
+        return this->waitForTransferDoneGated(timeout, length <= UserConfigs::PCR::CompletionPollingMaxLength);
     };
     
     pinfo("Initiating the DMA transfer with timeout = %d ms and control = 0x%08x...", timeout, control);
     
-    retVal = IOCommandGateRunAction(this->commandGate, action);
+    IOReturn retVal = IOCommandGateRunAction(this->commandGate, action);
     
     if (retVal != kIOReturnSuccess)
     {
@@ -844,6 +925,31 @@ IOReturn RealtekPCICardReaderController::performDMATransfer(IODMACommand* comman
 ///
 IOReturn RealtekPCICardReaderController::performDMATransfer(IOMemoryDescriptor* descriptor, UInt32 timeout, UInt32 control)
 {
+    // Check whether the scatter/gather list has been prepared ahead of time
+    if (this->preparedDMADescriptor == descriptor)
+    {
+        pinfo("The DMA transfer has been prepared ahead of time.");
+        
+        // Take the ownership of the prepared transfer,
+        // so that the next pending request can be prepared while this one is in flight
+        IODMACommand* command = this->preparedDMACommand;
+        
+        this->preparedDMADescriptor = nullptr;
+        
+        this->preparedDMACommand = nullptr;
+        
+        this->hostDataBufferIndex ^= 1;
+        
+        IOReturn retVal = this->executeDMATransfer(timeout, control, descriptor->getLength());
+        
+        this->releasePreparedDMATransfer(descriptor, command);
+        
+        return retVal;
+    }
+    
+    // The transfer prepared ahead of time (if any) is no longer useful
+    this->discardPreparedDMATransfer();
+    
     // The action that manipulates a prepared DMA command
     auto commandAction = [&](IODMACommand* command) -> IOReturn
     {
@@ -865,6 +971,316 @@ IOReturn RealtekPCICardReaderController::performDMATransfer(IOMemoryDescriptor*
     return this->dmaCommandPool->withCommand(poolAction);
 }
 
+///
+/// [Helper] Release the given DMA transfer that has been prepared ahead of time
+///
+/// @param descriptor A non-null memory descriptor retained and prepared by `prepareDMATransferAhead()`
+/// @param command A non-null DMA command associated with the given descriptor
+///
+void RealtekPCICardReaderController::releasePreparedDMATransfer(IOMemoryDescriptor* descriptor, IODMACommand* command)
+{
+    psoftassert(command->clearMemoryDescriptor() == kIOReturnSuccess,
+                "Failed to dissociate the memory descriptor from the DMA command.");
+    
+    this->dmaCommandPool->returnCommand(command);
+    
+    psoftassert(descriptor->complete() == kIOReturnSuccess,
+                "Failed to complete the memory descriptor.");
+    
+    descriptor->release();
+}
+
+///
+/// [Helper] Discard the DMA transfer that has been prepared ahead of time if any
+///
+/// @note This function is invoked when the next DMA transfer does not match the one prepared ahead of time,
+///       or when the host must not keep any memory descriptor prepared (e.g. the host error is cleared or the computer sleeps).
+///
+void RealtekPCICardReaderController::discardPreparedDMATransfer()
+{
+    if (this->preparedDMADescriptor == nullptr)
+    {
+        return;
+    }
+    
+    pinfo("Discarding the DMA transfer prepared ahead of time.");
+    
+    this->releasePreparedDMATransfer(this->preparedDMADescriptor, this->preparedDMACommand);
+    
+    this->preparedDMADescriptor = nullptr;
+    
+    this->preparedDMACommand = nullptr;
+}
+
+///
+/// [Helper] Prepare the given memory descriptor and write its scatter/gather list to the host data buffer at the given index
+///
+/// @param descriptor A non-null memory descriptor
+/// @param index The index of the host data buffer
+/// @param command A non-null DMA command associated with the given descriptor on return
+/// @return `kIOReturnSuccess` on success, `kIOReturnNoResources` if no DMA command is available at this moment, other values otherwise.
+/// @note On success, the descriptor is retained and prepared, and the caller must invoke `releasePreparedDMATransfer()` to release it.
+///
+IOReturn RealtekPCICardReaderController::setupDMATransfer(IOMemoryDescriptor* descriptor, UInt32 index, IODMACommand*& command)
+{
+    // Guard: Allocate a DMA command without blocking the current transfer
+    command = this->dmaCommandPool->getCommand(false);
+    
+    if (command == nullptr)
+    {
+        pinfo("No DMA command is available at this moment.");
+        
+        return kIOReturnNoResources;
+    }
+    
+    // Guard: Page in and wire down the buffer
+    IOReturn retVal = descriptor->prepare();
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to prepare the memory descriptor. Error = 0x%x.", retVal);
+        
+        this->dmaCommandPool->returnCommand(command);
+        
+        return retVal;
+    }
+    
+    // Guard: Associate the memory descriptor with the DMA command
+    retVal = command->setMemoryDescriptor(descriptor);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to associate the memory descriptor with the DMA command. Error = 0x%x.", retVal);
+        
+        psoftassert(descriptor->complete() == kIOReturnSuccess, "Failed to complete the memory descriptor.");
+        
+        this->dmaCommandPool->returnCommand(command);
+        
+        return retVal;
+    }
+    
+    // Guard: Write the scatter/gather list to the host data buffer at the given index
+    descriptor->retain();
+    
+    retVal = this->enqueueDMACommand(command, index);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to write the scatter/gather list to the host data buffer. Error = 0x%x.", retVal);
+        
+        this->releasePreparedDMATransfer(descriptor, command);
+        
+        return retVal;
+    }
+    
+    return kIOReturnSuccess;
+}
+
+///
+/// [Helper] Start a DMA transfer without waiting for its completion
+///
+/// @param descriptor A non-null, perpared memory descriptor
+/// @param timeout Specify the amount of time in milliseconds
+/// @param control Specify the value that will be written to the register `HDBCTLR` to customize the DMA transfer
+/// @param completion The completion routine to call once the transfer completes
+/// @return `kIOReturnSuccess` if the transfer has started, `kIOReturnNoResources` if no DMA command is available at this moment,
+///         other values otherwise.
+/// @note This helper function is invoked by both `startDMARead()` and `startDMAWrite()`.
+/// @note The completion routine is invoked by the interrupt handler or the timeout handler via `finishDMATransferGated()`.
+///
+IOReturn RealtekPCICardReaderController::startDMATransfer(IOMemoryDescriptor* descriptor, UInt32 timeout, UInt32 control, DMACompletion completion)
+{
+    auto action = [&]() -> IOReturn
+    {
+        using namespace RTSX::MMIO;
+        
+        // Guard: Only one DMA transfer can be in flight
+        if (this->activeDMADescriptor != nullptr)
+        {
+            perr("Another asynchronous DMA transfer is still in flight.");
+            
+            return kIOReturnBusy;
+        }
+        
+        // Guard: Check whether the host commands that precede the data transfer have failed
+        //        See `executeDMATransfer()` for details.
+        if (this->pendingCommandTransferStatus != kIOReturnNotReady && this->pendingCommandTransferStatus != kIOReturnSuccess)
+        {
+            perr("The host commands that precede the data transfer have failed. Will not start the DMA transfer.");
+            
+            return this->pendingCommandTransferStatus;
+        }
+        
+        // Find the scatter/gather list of the given descriptor
+        IODMACommand* command = nullptr;
+        
+        if (this->preparedDMADescriptor == descriptor)
+        {
+            pinfo("The DMA transfer has been prepared ahead of time.");
+            
+            command = this->preparedDMACommand;
+            
+            this->preparedDMADescriptor = nullptr;
+            
+            this->preparedDMACommand = nullptr;
+            
+            this->hostDataBufferIndex ^= 1;
+        }
+        else
+        {
+            this->discardPreparedDMATransfer();
+            
+            IOReturn retVal = this->setupDMATransfer(descriptor, this->hostDataBufferIndex, command);
+            
+            if (retVal != kIOReturnSuccess)
+            {
+                return retVal;
+            }
+        }
+        
+        // The transfer is released and completed by the interrupt path
+        this->activeDMADescriptor = descriptor;
+        
+        this->activeDMACommand = command;
+        
+        this->activeDMACompletion = completion;
+        
+        // Tell the device the location of the data buffer and to start the DMA transfer
+        this->hostBufferTransferStatus = kIOReturnNotReady;
+        
+        this->writeRegister32(rHDBAR, this->hostBufferAddress + RealtekPCICardReaderController::kHostDataBufferOffset + this->hostDataBufferIndex * kHostDataBufferSize);
+        
+        this->writeRegister32(rHDBCTLR, control);
+        
+        this->transferCounters.numDMATransfers += 1;
+        
+        // Set up the timer
+        passert(this->hostBufferTimer != nullptr, "The host buffer timer should not be NULL.");
+        
+        passert(this->hostBufferTimer->setTimeoutMS(timeout) == kIOReturnSuccess, "Should be able to set the timeout.");
+        
+        return kIOReturnSuccess;
+    };
+    
+    pinfo("Starting the asynchronous DMA transfer with timeout = %d ms and control = 0x%08x...", timeout, control);
+    
+    return IOCommandGateRunAction(this->commandGate, action);
+}
+
+///
+/// [Helper] Release the asynchronous DMA transfer in flight and invoke its completion routine
+///
+/// @note This function runs in a gated context and is a noop if no asynchronous DMA transfer is in flight.
+/// @note This function is invoked once the transfer status is final, so it must not wait for the card reader.
+///       In particular, it does not clear the host error, which is left to the caller that started the transfer.
+///
+void RealtekPCICardReaderController::finishDMATransferGated()
+{
+    // Guard: Check whether an asynchronous DMA transfer is in flight
+    if (this->activeDMADescriptor == nullptr)
+    {
+        return;
+    }
+    
+    IOReturn status = this->hostBufferTransferStatus;
+    
+    DMACompletion completion = this->activeDMACompletion;
+    
+    this->releasePreparedDMATransfer(this->activeDMADescriptor, this->activeDMACommand);
+    
+    this->activeDMADescriptor = nullptr;
+    
+    this->activeDMACommand = nullptr;
+    
+    this->activeDMACompletion.reset();
+    
+    if (status != kIOReturnSuccess)
+    {
+        perr("The asynchronous DMA transfer has failed. Error = 0x%x.", status);
+        
+        if (this->dmaErrorCounter < kMaxDMATransferFailures)
+        {
+            this->dmaErrorCounter += 1;
+        }
+        
+        pinfo("DMA Error Counter = %u.", this->dmaErrorCounter);
+    }
+    else
+    {
+        pinfo("The asynchronous DMA transfer has completed.");
+    }
+    
+    completion.invoke(status);
+}
+
+///
+/// Prepare the DMA transfer of the given memory descriptor ahead of time
+///
+/// @param descriptor A non-null memory descriptor that will be passed to `performDMARead/Write()` later
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note This function prepares the descriptor and writes its scatter/gather list to the host data buffer not in use,
+///       so the subsequent DMA transfer of the same descriptor can be started immediately.
+/// @note This function is invoked by the host device while the current DMA transfer is in flight,
+///       so it must be invoked on the thread that performs DMA transfers.
+///
+IOReturn RealtekPCICardReaderController::prepareDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    auto action = [&]() -> IOReturn
+    {
+        // Guard: Check whether the given transfer has already been prepared
+        if (this->preparedDMADescriptor == descriptor)
+        {
+            return kIOReturnSuccess;
+        }
+        
+        this->discardPreparedDMATransfer();
+        
+        // Guard: Prepare the descriptor and write its scatter/gather list to the host data buffer not in use
+        IODMACommand* command = nullptr;
+        
+        IOReturn retVal = this->setupDMATransfer(descriptor, this->hostDataBufferIndex ^ 1, command);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to prepare the DMA transfer ahead of time. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        this->preparedDMADescriptor = descriptor;
+        
+        this->preparedDMACommand = command;
+        
+        pinfo("The DMA transfer has been prepared ahead of time.");
+        
+        return kIOReturnSuccess;
+    };
+    
+    return IOCommandGateRunAction(this->commandGate, action);
+}
+
+///
+/// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+///
+/// @param descriptor A non-null memory descriptor that has been passed to `prepareDMATransferAhead()`
+/// @note This function is invoked by the host device once the block request that owns the descriptor has been serviced,
+///       so that the descriptor does not remain prepared after the request is completed.
+///
+void RealtekPCICardReaderController::discardDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    auto action = [&]() -> IOReturn
+    {
+        if (this->preparedDMADescriptor == descriptor)
+        {
+            this->discardPreparedDMATransfer();
+        }
+        
+        return kIOReturnSuccess;
+    };
+    
+    IOCommandGateRunAction(this->commandGate, action);
+}
+
 ///
 /// Perform a DMA read operation
 ///
@@ -897,6 +1313,72 @@ IOReturn RealtekPCICardReaderController::performDMAWrite(IOMemoryDescriptor* des
     return this->performDMATransfer(descriptor, timeout, HDBCTLR::kStartDMA | HDBCTLR::kUseADMA);
 }
 
+///
+/// Start a DMA read operation without waiting for its completion
+///
+/// @param descriptor A non-null, perpared memory descriptor
+/// @param timeout Specify the amount of time in milliseconds
+/// @param completion The completion routine to call once the transfer completes
+/// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+/// @note The completion routine is invoked by the interrupt path in a gated context.
+/// @note Short transfers are performed synchronously if completion polling is enabled.
+///
+IOReturn RealtekPCICardReaderController::startDMARead(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion)
+{
+    using namespace RTSX::MMIO;
+    
+    pinfo("The host device requests to start a DMA read operation.");
+    
+    // Guard: Short transfers are performed synchronously, so that their completion can be polled
+    if (UserConfigs::PCR::CompletionPollingWindow != 0 && descriptor->getLength() <= UserConfigs::PCR::CompletionPollingMaxLength)
+    {
+        return super::startDMARead(descriptor, timeout, completion);
+    }
+    
+    IOReturn retVal = this->startDMATransfer(descriptor, timeout, HDBCTLR::kDMARead | HDBCTLR::kStartDMA | HDBCTLR::kUseADMA, completion);
+    
+    // Guard: Fall back to the synchronous transfer if no DMA command is available at this moment
+    if (retVal == kIOReturnNoResources)
+    {
+        return super::startDMARead(descriptor, timeout, completion);
+    }
+    
+    return retVal;
+}
+
+///
+/// Start a DMA write operation without waiting for its completion
+///
+/// @param descriptor A non-null, perpared memory descriptor
+/// @param timeout Specify the amount of time in milliseconds
+/// @param completion The completion routine to call once the transfer completes
+/// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+/// @note The completion routine is invoked by the interrupt path in a gated context.
+/// @note Short transfers are performed synchronously if completion polling is enabled.
+///
+IOReturn RealtekPCICardReaderController::startDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion)
+{
+    using namespace RTSX::MMIO;
+    
+    pinfo("The host device requests to start a DMA write operation.");
+    
+    // Guard: Short transfers are performed synchronously, so that their completion can be polled
+    if (UserConfigs::PCR::CompletionPollingWindow != 0 && descriptor->getLength() <= UserConfigs::PCR::CompletionPollingMaxLength)
+    {
+        return super::startDMAWrite(descriptor, timeout, completion);
+    }
+    
+    IOReturn retVal = this->startDMATransfer(descriptor, timeout, HDBCTLR::kStartDMA | HDBCTLR::kUseADMA, completion);
+    
+    // Guard: Fall back to the synchronous transfer if no DMA command is available at this moment
+    if (retVal == kIOReturnNoResources)
+    {
+        return super::startDMAWrite(descriptor, timeout, completion);
+    }
+    
+    return retVal;
+}
+
 //
 // MARK: - Clear Error
 //
@@ -929,6 +1411,8 @@ void RealtekPCICardReaderController::clearHostError()
     
     this->writeRegister32(rHDBCTLR, HDBCTLR::kStopDMA);
     
+    this->discardPreparedDMATransfer();
+    
     using namespace RTSX::PCR::Chip;
     
     const ChipRegValuePair pairs[] =
@@ -2134,10 +2618,15 @@ void RealtekPCICardReaderController::prepareToSleep()
     // Detach the card if present
     super::prepareToSleep();
     
+    // Release the DMA transfer prepared ahead of time
+    this->discardPreparedDMATransfer();
+    
     // Turn off the LED
     psoftassert(this->turnOffLED() == kIOReturnSuccess, "Failed to turn off the LED.");
     
     // Disable all interrupts
+    this->enabledInterrupts = 0;
+    
     this->writeRegister32(RTSX::MMIO::rBIER, 0);
     
     // Set the host sleep state
@@ -2203,11 +2692,10 @@ bool RealtekPCICardReaderController::interruptEventSourceFilter(IOFilterInterrup
     // Retrieve and examine pending interrupts
     using namespace RTSX::MMIO;
     
+    // The host is the only one that modifies the enabled interrupts, so use the cached value instead of reading `BIER`
     UInt32 pendingInterrupts = this->readRegister32(rBIPR);
     
-    UInt32 enabledInterrupts = this->readRegister32(rBIER);
-    
-    return (pendingInterrupts & enabledInterrupts) != 0;
+    return (pendingInterrupts & this->enabledInterrupts) != 0;
 }
 
 ///
@@ -2226,6 +2714,8 @@ void RealtekPCICardReaderController::interruptHandlerGated(IOInterruptEventSourc
     
     pinfo("Interrupt handler started.");
     
+    this->transferCounters.numInterrupts += 1;
+    
     BitOptions pendingInterrupts = this->readRegister32(rBIPR);
     
     // Acknowledge the interrupt
@@ -2244,7 +2734,7 @@ void RealtekPCICardReaderController::interruptHandlerGated(IOInterruptEventSourc
     }
     
     // Filter out disabled interrupts but keep the low 23 bits
-    pendingInterrupts.mutativeBitwiseAnd(this->readRegister32(rBIER) | 0x7FFFFF);
+    pendingInterrupts.mutativeBitwiseAnd(this->enabledInterrupts | 0x7FFFFF);
     
     pinfo("Filtered pending interrupts = 0x%x.", pendingInterrupts.flatten());
     
@@ -2266,6 +2756,12 @@ void RealtekPCICardReaderController::interruptHandlerGated(IOInterruptEventSourc
         this->onTransferDoneGated(false);
     }
     
+    // The card reader stops executing the remaining host commands once an operation fails
+    if (pendingInterrupts.containsOneOf(BIPR::kCommandTransferDone, BIPR::kTransferFailed))
+    {
+        this->onCommandTransferDoneGated(!pendingInterrupts.contains(BIPR::kTransferFailed));
+    }
+    
     // Case 3: Card Insertion/Removal Interrupts
     if (pendingInterrupts.contains(BIPR::kSD))
     {
@@ -2302,6 +2798,9 @@ void RealtekPCICardReaderController::bufferTransferTimeoutHandlerGated(IOTimerEv
     
     // Wakeup the client thread
     this->commandGate->commandWakeup(&this->hostBufferTransferStatus);
+    
+    // Complete the asynchronous DMA transfer if any
+    this->finishDMATransferGated();
 }
 
 ///
@@ -2333,6 +2832,121 @@ void RealtekPCICardReaderController::onTransferDoneGated(bool succeeded)
     
     // Wakeup the client thread
     this->commandGate->commandWakeup(&this->hostBufferTransferStatus);
+    
+    // Complete the asynchronous DMA transfer if any
+    this->finishDMATransferGated();
+}
+
+///
+/// Helper interrupt service routine when the card reader has executed all host commands in the current session
+///
+/// @param succeeded `true` if all host commands have been executed successfully. `false` otherwise.
+/// @note This interrupt service routine runs in a gated context.
+/// @note This routine only completes the session started by `endCommandTransferNoWait()`,
+///       since the other sessions are completed by `onTransferDoneGated()`.
+///
+void RealtekPCICardReaderController::onCommandTransferDoneGated(bool succeeded)
+{
+    // Guard: Check whether the host is waiting for the remaining host commands
+    if (this->pendingCommandTransferStatus != kIOReturnNotReady)
+    {
+        return;
+    }
+    
+    pinfo("The card reader has executed all host commands. Succeeded = %s.", YESNO(succeeded));
+    
+    this->pendingCommandTransferStatus = succeeded ? kIOReturnSuccess : kIOReturnError;
+    
+    this->commandGate->commandWakeup(&this->pendingCommandTransferStatus);
+}
+
+///
+/// Spin on the pending interrupts until the current host command or data transfer is done
+///
+/// @param window Specify the amount of time in microseconds to spin
+/// @return `true` if the transfer is done within the given window, `false` otherwise.
+/// @note This function runs in a gated context.
+/// @note On return, the transfer status is updated and the transfer interrupts are acknowledged if the transfer is done.
+///       The interrupt handler may still be invoked but finds no pending transfer interrupts.
+///
+bool RealtekPCICardReaderController::pollTransferDoneGated(UInt32 window)
+{
+    using namespace RTSX::MMIO;
+    
+    UInt64 now = 0, deadline = 0;
+    
+    clock_get_uptime(&now);
+    
+    nanoseconds_to_absolutetime(static_cast<UInt64>(window) * 1000, &deadline);
+    
+    deadline += now;
+    
+    do
+    {
+        BitOptions pendingInterrupts = this->readRegister32(rBIPR);
+        
+        // Guard: The device may have been removed
+        if (pendingInterrupts.flatten() == 0xFFFFFFFF)
+        {
+            return false;
+        }
+        
+        if (pendingInterrupts.containsOneOf(BIPR::kTransferSucceeded, BIPR::kTransferFailed))
+        {
+            // Acknowledge the transfer interrupts only
+            // Other interrupts such as card insertion and removal are left to the interrupt handler
+            this->writeRegister32(rBIPR, pendingInterrupts.flatten() & (BIPR::kCommandTransferDone | BIPR::kTransferSucceeded | BIPR::kTransferFailed));
+            
+            this->hostBufferTransferStatus = pendingInterrupts.contains(BIPR::kTransferFailed) ? kIOReturnError : kIOReturnSuccess;
+            
+            if (pendingInterrupts.containsOneOf(BIPR::kCommandTransferDone, BIPR::kTransferFailed))
+            {
+                this->onCommandTransferDoneGated(!pendingInterrupts.contains(BIPR::kTransferFailed));
+            }
+            
+            this->transferCounters.numPolledCompletions += 1;
+            
+            pinfo("The current transfer session has completed while polling. Status = 0x%x.", this->hostBufferTransferStatus);
+            
+            return true;
+        }
+        
+        clock_get_uptime(&now);
+    }
+    while (now < deadline);
+    
+    return false;
+}
+
+///
+/// Wait for the completion of the current host command or data transfer
+///
+/// @param timeout Specify the amount of time in milliseconds
+/// @param polls `true` if the transfer is short enough to poll for its completion before sleeping, `false` otherwise.
+/// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if timed out, `kIOReturnError` otherwise.
+/// @note This function runs in a gated context.
+/// @note If polling is enabled by the user, this function spins on the pending interrupts for a short while,
+///       so that the thread does not have to sleep and be woken up by the interrupt handler for short transfers.
+///
+IOReturn RealtekPCICardReaderController::waitForTransferDoneGated(UInt32 timeout, bool polls)
+{
+    // Guard: Spin for a short while if the transfer is expected to complete soon
+    if (polls && UserConfigs::PCR::CompletionPollingWindow != 0 && this->pollTransferDoneGated(UserConfigs::PCR::CompletionPollingWindow))
+    {
+        return this->hostBufferTransferStatus;
+    }
+    
+    // Set up the timer
+    passert(this->hostBufferTimer != nullptr, "The host buffer timer should not be NULL.");
+    
+    passert(this->hostBufferTimer->setTimeoutMS(timeout) == kIOReturnSuccess, "Should be able to set the timeout.");
+    
+    // Block the current thread and release the gate
+    // Either the timeout handler or the interrupt handler will modify the status and wakeup the current thread
+    this->commandGate->commandSleep(&this->hostBufferTransferStatus);
+    
+    // When the sleep function returns, the transfer is done
+    return this->hostBufferTransferStatus;
 }
 
 ///
@@ -2427,7 +3041,9 @@ IOReturn RealtekPCICardReaderController::initHardwareCommon()
     
     pinfo("Enabling the bus interrupt...");
     
-    UInt32 bier = BIER::kEnableTransferSuccess |
+    // The command transfer done interrupt tells the host when the host commands queued after a DMA transfer have been executed
+    UInt32 bier = BIER::kEnableCommandTransferDone |
+                  BIER::kEnableTransferSuccess |
                   BIER::kEnableTransferFailure |
                   BIER::kEnableSD;
     
@@ -2436,6 +3052,8 @@ IOReturn RealtekPCICardReaderController::initHardwareCommon()
         bier |= BIER::kEnableSDOvercurrent;
     }
     
+    this->enabledInterrupts = bier;
+    
     this->writeRegister32(rBIER, bier);
     
     pinfo("Bus interrupt has been enabled. MMIO::BIER = 0x%08x.", bier);
@@ -2726,7 +3344,9 @@ bool RealtekPCICardReaderController::setupHostBuffer()
     }
     
     // Guard: 1. Allocate memory for the host command and data buffer
-    this->hostBufferDescriptor = IOBufferMemoryDescriptor::withCapacity(kHostBufferSize, kIODirectionInOut, true);
+    // The buffer must be physically contiguous and addressable by the card reader,
+    // so that the scatter/gather list can be written to the buffer directly.
+    this->hostBufferDescriptor = IOBufferMemoryDescriptor::inTaskWithPhysicalMask(kernel_task, kIODirectionInOut | kIOMemoryPhysicallyContiguous, kHostBufferSize, 0x00000000FFFFFFFFULL);
     
     if (this->hostBufferDescriptor == nullptr)
     {
@@ -2787,6 +3407,8 @@ bool RealtekPCICardReaderController::setupHostBuffer()
     // All done: Save the address
     this->hostBufferAddress = segment.fIOVMAddr;
     
+    this->hostBufferVirtualAddress = reinterpret_cast<UInt8*>(this->hostBufferDescriptor->getBytesNoCopy());
+    
     this->hostBufferTransferStatus = kIOReturnSuccess;
     
     pinfo("The host command and data buffer has been created. Bus address = 0x%08x.", segment.fIOVMAddr);
@@ -2964,6 +3586,12 @@ void RealtekPCICardReaderController::tearDownHostBuffer()
         this->hostBufferTimer = nullptr;
     }
     
+    // Release the DMA transfer prepared ahead of time
+    if (this->dmaCommandPool != nullptr)
+    {
+        this->discardPreparedDMATransfer();
+    }
+    
     // R5: Complete the DMA transaction (auto complete is set to true)
     // R4: Dissociate the buffer descriptor from the DMA command
     // R2: Release the DMA command
@@ -2986,6 +3614,8 @@ void RealtekPCICardReaderController::tearDownHostBuffer()
         this->hostBufferDescriptor->release();
         
         this->hostBufferDescriptor = nullptr;
+        
+        this->hostBufferVirtualAddress = nullptr;
     }
     
     // R0: Destroy the DMA command pool
@@ -3054,10 +3684,28 @@ bool RealtekPCICardReaderController::init(OSDictionary* dictionary)
     
     this->hostBufferTimer = nullptr;
     
+    this->enabledInterrupts = 0;
+    
     this->hostBufferAddress = 0;
     
+    this->hostBufferVirtualAddress = nullptr;
+    
     this->hostBufferTransferStatus = kIOReturnSuccess;
     
+    this->pendingCommandTransferStatus = kIOReturnSuccess;
+    
+    this->hostDataBufferIndex = 0;
+    
+    this->preparedDMADescriptor = nullptr;
+    
+    this->preparedDMACommand = nullptr;
+    
+    this->activeDMADescriptor = nullptr;
+    
+    this->activeDMACommand = nullptr;
+    
+    this->activeDMACompletion.reset();
+    
     bzero(&this->parameters, sizeof(Parameters));
     
     this->dmaErrorCounter = 0;
@@ -391,6 +391,14 @@ class RealtekPCICardReaderController: public RealtekCardReaderController
     /// An event source that delivers the hardware interrupt
     IOFilterInterruptEventSource* interruptEventSource;
     
+    ///
+    /// The bus interrupts enabled by the host
+    ///
+    /// @note This is a copy of the value written to the register `BIER`,
+    ///       so that the interrupt filter does not have to read the register on every interrupt.
+    ///
+    UInt32 enabledInterrupts;
+    
     /// A timer that delays the initialization of the card
     IOTimerEventSource* cardSetupTimer;
     
@@ -398,18 +406,22 @@ class RealtekPCICardReaderController: public RealtekCardReaderController
     // MARK: - Host Command & Data Buffer
     //
     
+    /// The size of a host data buffer (by default 3072 bytes, allowing 384 scatter/gather list items to be queued)
+    static constexpr IOByteCount kHostDataBufferSize = RTSX::MMIO::HDBAR::kMaxNumElements * 8;
+    
     ///
-    /// The host buffer size (by default 4096 bytes)
+    /// The host buffer size (by default 7168 bytes)
     ///
     /// @note 1 KB is reserved for the host command buffer, allowing 256 commands to be queued;
-    ///       3 KB is reserved for the host data buffer, allowing 384 scatter/gather list items to be queued.
+    ///       6 KB is reserved for two host data buffers, so that the host can prepare the scatter/gather list of the next DMA transfer
+    ///       while the card reader is executing the current one.
     ///
-    static constexpr IOByteCount kHostBufferSize = RTSX::MMIO::HCBAR::kMaxNumCmds * 4 + RTSX::MMIO::HDBAR::kMaxNumElements * 8;
+    static constexpr IOByteCount kHostBufferSize = RTSX::MMIO::HCBAR::kMaxNumCmds * 4 + kHostDataBufferSize * 2;
     
     /// The host command buffer starts at the offset 0 in the host buffer
     static constexpr IOByteCount kHostCommandBufferOffset = 0;
     
-    /// The host data buffer starts at the offset 1024 in the host buffer
+    /// The host data buffers start at the offset 1024 in the host buffer
     static constexpr IOByteCount kHostDataBufferOffset = RTSX::MMIO::HCBAR::kMaxNumCmds * 4;
     
     /// The maximum number of DMA segments supported by the card reader
@@ -437,7 +449,8 @@ class RealtekPCICardReaderController: public RealtekCardReaderController
     ///       The lifecycle is managed by `setupHostBuffer()` and `tearDownHostBuffer()`.
     /// @note The command remains associated with the host buffer descriptor,
     ///       and data is always synchronized with that descriptor.
-    /// @note Accesses to the host buffer must be done via `IODMACommand::write/readBytes()`.
+    /// @note Accesses to the host buffer must be done via `IODMACommand::write/readBytes()`,
+    ///       except that `enqueueDMACommand()` generates the scatter/gather list in the host data buffer directly.
     ///
     IODMACommand* hostBufferDMACommand;
     
@@ -451,6 +464,16 @@ class RealtekPCICardReaderController: public RealtekCardReaderController
     ///
     IOPhysicalAddress32 hostBufferAddress;
     
+    ///
+    /// The kernel virtual address of the host buffer
+    ///
+    /// @note The host buffer is physically contiguous and resides below 4 GB,
+    ///       so the DMA command never bounces it and the card reader fetches exactly the bytes written at this address.
+    /// @note Only `enqueueDMACommand()` accesses the host data buffers via this address,
+    ///       so that the scatter/gather list is generated in place without an intermediate copy.
+    ///
+    UInt8* hostBufferVirtualAddress;
+    
     ///
     /// Status of the current buffer transfer session
     ///
@@ -462,6 +485,48 @@ class RealtekPCICardReaderController: public RealtekCardReaderController
     ///
     IOReturn hostBufferTransferStatus;
     
+    ///
+    /// Status of the host command transfer session started by `endCommandTransferNoWait()`
+    ///
+    /// @note The status is `kIOReturnNotReady` until the card reader has executed all host commands in the session,
+    ///       and is modified by the interrupt handler once the command transfer done interrupt is received.
+    ///       The session outlives the DMA transfer that follows it if host commands are queued after the DMA transfer.
+    ///
+    IOReturn pendingCommandTransferStatus;
+    
+    ///
+    /// The index of the host data buffer that contains the scatter/gather list of the current DMA transfer
+    ///
+    /// @note The other host data buffer is used to prepare the next DMA transfer ahead of time.
+    ///
+    UInt32 hostDataBufferIndex;
+    
+    ///
+    /// The memory descriptor of the DMA transfer prepared ahead of time
+    ///
+    /// @note The descriptor is retained and prepared by `prepareDMATransferAhead()`,
+    ///       and its scatter/gather list resides in the host data buffer at the index `hostDataBufferIndex ^ 1`.
+    ///       `nullptr` if no DMA transfer is prepared ahead of time.
+    ///
+    IOMemoryDescriptor* preparedDMADescriptor;
+    
+    /// The DMA command associated with the memory descriptor prepared ahead of time
+    IODMACommand* preparedDMACommand;
+    
+    ///
+    /// The memory descriptor of the asynchronous DMA transfer in flight
+    ///
+    /// @note The descriptor is retained and prepared by `startDMATransfer()` and is released by `finishDMATransferGated()`.
+    ///       `nullptr` if no asynchronous DMA transfer is in flight.
+    ///
+    IOMemoryDescriptor* activeDMADescriptor;
+    
+    /// The DMA command associated with the memory descriptor of the asynchronous DMA transfer in flight
+    IODMACommand* activeDMACommand;
+    
+    /// The completion routine of the asynchronous DMA transfer in flight
+    DMACompletion activeDMACompletion;
+    
     //
     // MARK: - Device Specific Properties
     //
@@ -828,19 +893,15 @@ protected:
     IOReturn writeHostBufferGated(IOByteCount offset, const void* buffer, IOByteCount length) override final;
     
     ///
-    /// Write to the host data buffer form the given buffer conveniently
+    /// Get the host data buffer at the given index conveniently
     ///
-    /// @param offset A byte offset into the host data buffer
-    /// @param buffer A non-null buffer
-    /// @param length The number of bytes to write
-    /// @return `kIOReturnSuccess` on success, other values otherwise.
-    /// @note This function coordinates all accesses to the host data buffer.
-    /// @warning The first argument `offset` is relative to the start address of the host data buffer.
-    ///          i.e. If `offset` is 5, this function will start to read from the offset `1024 + 5` in the host buffer.
+    /// @param index The index of the host data buffer
+    /// @return The kernel virtual address of the first scatter/gather list entry in the host data buffer.
+    /// @note The returned buffer can hold up to `RTSX::MMIO::HDBAR::kMaxNumElements` entries.
     ///
-    inline IOReturn writeHostDataBuffer(IOByteCount offset, const void* buffer, IOByteCount length)
+    inline UInt64* getHostDataBuffer(UInt32 index)
     {
-        return this->writeHostBuffer(RealtekPCICardReaderController::kHostDataBufferOffset + offset, buffer, length);
+        return reinterpret_cast<UInt64*>(this->hostBufferVirtualAddress + RealtekPCICardReaderController::kHostDataBufferOffset + index * kHostDataBufferSize);
     }
     
     //
@@ -887,8 +948,10 @@ protected:
     ///
     /// @param timeout Specify the amount of time in milliseconds
     /// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if timed out, other values otherwise.
-    /// @note Port: This function is a noop and returns `kIOReturnSuccess` for PCIe-based card reader controllers.
     /// @note Port: This function replaces `rtsx_usb_get_rsp()` (the original version) defined in `rtsx_usb.c`.
+    /// @note PCIe-based card reader controllers write the response to the host command buffer by themselves,
+    ///       so this function only waits until the card reader has executed all host commands in the session
+    ///       started by `endCommandTransferNoWait()`, including those queued after the DMA transfer.
     /// @note This function runs in a gated context.
     ///
     IOReturn loadCommandTransferResponseGated(UInt32 timeout) override final;
@@ -912,11 +975,26 @@ protected:
     /// [Helper] Generate a physical scatter/gather list from the given DMA command and enqueue all entries into the host data buffer
     ///
     /// @param command A non-null, perpared DMA command
+    /// @param index The index of the host data buffer
     /// @return `kIOReturnSuccess` on success, other values otherwise.
     /// @note Port: This helper function replaces `rtsx_pci_add_sg_tbl()` defined in `rtsx_psr.c`.
+    /// @note The list is generated directly in the host data buffer, and physically contiguous segments are coalesced.
     /// @warning The caller must ensure that the given instance of `IODMACommand` is prepared.
     ///
-    IOReturn enqueueDMACommand(IODMACommand* command);
+    IOReturn enqueueDMACommand(IODMACommand* command, UInt32 index);
+    
+    ///
+    /// [Helper] Start the DMA transfer described by the current host data buffer and wait for its completion
+    ///
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @param control Specify the value that will be written to the register `HDBCTLR` to customize the DMA transfer
+    /// @param length The number of bytes to transfer
+    /// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if timed out, `kIOReturnError` otherwise.
+    /// @note Port: This function replaces `rtsx_pci_dma_transfer()` defined in `rtsx_psr.c`.
+    /// @note Once the DMA transfer has started, this function notifies the host device,
+    ///       so that the host driver can prepare the next pending request while the current transfer is in flight.
+    ///
+    IOReturn executeDMATransfer(UInt32 timeout, UInt32 control, IOByteCount length);
     
     ///
     /// [Helper] Perform a DMA transfer
@@ -946,7 +1024,78 @@ protected:
     ///
     IOReturn performDMATransfer(IOMemoryDescriptor* descriptor, UInt32 timeout, UInt32 control);
     
+    ///
+    /// [Helper] Release the given DMA transfer that has been prepared ahead of time
+    ///
+    /// @param descriptor A non-null memory descriptor retained and prepared by `prepareDMATransferAhead()`
+    /// @param command A non-null DMA command associated with the given descriptor
+    ///
+    void releasePreparedDMATransfer(IOMemoryDescriptor* descriptor, IODMACommand* command);
+    
+    ///
+    /// [Helper] Discard the DMA transfer that has been prepared ahead of time if any
+    ///
+    /// @note This function is invoked when the next DMA transfer does not match the one prepared ahead of time,
+    ///       or when the host must not keep any memory descriptor prepared (e.g. the host error is cleared or the computer sleeps).
+    ///
+    void discardPreparedDMATransfer();
+    
+    ///
+    /// [Helper] Prepare the given memory descriptor and write its scatter/gather list to the host data buffer at the given index
+    ///
+    /// @param descriptor A non-null memory descriptor
+    /// @param index The index of the host data buffer
+    /// @param command A non-null DMA command associated with the given descriptor on return
+    /// @return `kIOReturnSuccess` on success, `kIOReturnNoResources` if no DMA command is available at this moment, other values otherwise.
+    /// @note On success, the descriptor is retained and prepared, and the caller must invoke `releasePreparedDMATransfer()` to release it.
+    ///
+    IOReturn setupDMATransfer(IOMemoryDescriptor* descriptor, UInt32 index, IODMACommand*& command);
+    
+    ///
+    /// [Helper] Start a DMA transfer without waiting for its completion
+    ///
+    /// @param descriptor A non-null, perpared memory descriptor
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @param control Specify the value that will be written to the register `HDBCTLR` to customize the DMA transfer
+    /// @param completion The completion routine to call once the transfer completes
+    /// @return `kIOReturnSuccess` if the transfer has started, `kIOReturnNoResources` if no DMA command is available at this moment,
+    ///         other values otherwise.
+    /// @note This helper function is invoked by both `startDMARead()` and `startDMAWrite()`.
+    /// @note The completion routine is invoked by the interrupt handler or the timeout handler via `finishDMATransferGated()`.
+    ///
+    IOReturn startDMATransfer(IOMemoryDescriptor* descriptor, UInt32 timeout, UInt32 control, DMACompletion completion);
+    
+    ///
+    /// [Helper] Release the asynchronous DMA transfer in flight and invoke its completion routine
+    ///
+    /// @note This function runs in a gated context and is a noop if no asynchronous DMA transfer is in flight.
+    /// @note This function is invoked once the transfer status is final, so it must not wait for the card reader.
+    ///       In particular, it does not clear the host error, which is left to the caller that started the transfer.
+    ///
+    void finishDMATransferGated();
+    
 public:    
+    ///
+    /// Prepare the DMA transfer of the given memory descriptor ahead of time
+    ///
+    /// @param descriptor A non-null memory descriptor that will be passed to `performDMARead/Write()` later
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note This function prepares the descriptor and writes its scatter/gather list to the host data buffer not in use,
+    ///       so the subsequent DMA transfer of the same descriptor can be started immediately.
+    /// @note This function is invoked by the host device while the current DMA transfer is in flight,
+    ///       so it must be invoked on the thread that performs DMA transfers.
+    ///
+    IOReturn prepareDMATransferAhead(IOMemoryDescriptor* descriptor) override final;
+    
+    ///
+    /// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+    ///
+    /// @param descriptor A non-null memory descriptor that has been passed to `prepareDMATransferAhead()`
+    /// @note This function is invoked by the host device once the block request that owns the descriptor has been serviced,
+    ///       so that the descriptor does not remain prepared after the request is completed.
+    ///
+    void discardDMATransferAhead(IOMemoryDescriptor* descriptor) override final;
+    
     ///
     /// Perform a DMA read operation
     ///
@@ -965,6 +1114,41 @@ public:
     ///
     IOReturn performDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout) override final;
     
+    ///
+    /// Check whether the controller can execute host commands queued after a DMA transfer in the same session
+    ///
+    /// @return `true` since the controller reports the completion of the host command list with a separate interrupt bit,
+    ///         so the host can wait for the commands queued after the DMA transfer via `loadCommandTransferResponse()`.
+    ///
+    inline bool canQueueCommandsAfterDMATransfer() override final
+    {
+        return true;
+    }
+    
+    ///
+    /// Start a DMA read operation without waiting for its completion
+    ///
+    /// @param descriptor A non-null, perpared memory descriptor
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @param completion The completion routine to call once the transfer completes
+    /// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+    /// @note The completion routine is invoked by the interrupt path in a gated context.
+    /// @note Short transfers are performed synchronously if completion polling is enabled.
+    ///
+    IOReturn startDMARead(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion) override final;
+    
+    ///
+    /// Start a DMA write operation without waiting for its completion
+    ///
+    /// @param descriptor A non-null, perpared memory descriptor
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @param completion The completion routine to call once the transfer completes
+    /// @return `kIOReturnSuccess` if the transfer has started, other values otherwise.
+    /// @note The completion routine is invoked by the interrupt path in a gated context.
+    /// @note Short transfers are performed synchronously if completion polling is enabled.
+    ///
+    IOReturn startDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout, DMACompletion completion) override final;
+    
     //
     // MARK: - Clear Error
     //
@@ -1436,6 +1620,18 @@ public:
     ///
     IOReturn readPingPongBuffer(IOMemoryDescriptor* destination, IOByteCount length) override final;
     
+    ///
+    /// Get the number of bytes in the ping pong buffer that can be read in the current host command transfer session
+    ///
+    /// @return The number of free entries in the host command buffer.
+    /// @note The card reader executes the commands queued after a data transfer to the ping pong buffer once the transfer completes,
+    ///       and returns the values of the registers read by those commands along with the transfer status.
+    ///
+    inline IOItemCount getPingPongBufferReadCapacityInSession() override final
+    {
+        return RTSX::MMIO::HCBAR::kMaxNumCmds - this->hostCommandCounter.total;
+    }
+    
     ///
     /// Write to the ping pong buffer
     ///
@@ -1637,6 +1833,39 @@ private:
     ///
     void onTransferDoneGated(bool succeeded);
     
+    ///
+    /// Helper interrupt service routine when the card reader has executed all host commands in the current session
+    ///
+    /// @param succeeded `true` if all host commands have been executed successfully. `false` otherwise.
+    /// @note This interrupt service routine runs in a gated context.
+    /// @note This routine only completes the session started by `endCommandTransferNoWait()`,
+    ///       since the other sessions are completed by `onTransferDoneGated()`.
+    ///
+    void onCommandTransferDoneGated(bool succeeded);
+    
+    ///
+    /// Spin on the pending interrupts until the current host command or data transfer is done
+    ///
+    /// @param window Specify the amount of time in microseconds to spin
+    /// @return `true` if the transfer is done within the given window, `false` otherwise.
+    /// @note This function runs in a gated context.
+    /// @note On return, the transfer status is updated and the transfer interrupts are acknowledged if the transfer is done.
+    ///       The interrupt handler may still be invoked but finds no pending transfer interrupts.
+    ///
+    bool pollTransferDoneGated(UInt32 window);
+    
+    ///
+    /// Wait for the completion of the current host command or data transfer
+    ///
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @param polls `true` if the transfer is short enough to poll for its completion before sleeping, `false` otherwise.
+    /// @return `kIOReturnSuccess` on success, `kIOReturnTimeout` if timed out, `kIOReturnError` otherwise.
+    /// @note This function runs in a gated context.
+    /// @note If polling is enabled by the user, this function spins on the pending interrupts for a short while,
+    ///       so that the thread does not have to sleep and be woken up by the interrupt handler for short transfers.
+    ///
+    IOReturn waitForTransferDoneGated(UInt32 timeout, bool polls);
+    
     ///
     /// Helper interrupt service routine when an overcurrent is detected
     ///
@@ -87,6 +87,8 @@ void RealtekRTS5260Controller::clearHostError()
     
     this->writeRegister32(rHDBCTLR, HDBCTLR::kStopDMA);
     
+    this->discardPreparedDMATransfer();
+    
     using namespace RTSX::PCR::Chip;
     
     const ChipRegValuePair pairs[] =
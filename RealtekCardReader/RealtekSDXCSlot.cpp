@@ -7,7 +7,9 @@
 
 #include "RealtekCommonRegisters.hpp"
 #include "RealtekSDXCSlot.hpp"
+#include "RealtekCardReaderUserConfigs.hpp"
 #include "IOSDHostDriver.hpp"
+#include "IOMemoryDescriptor.hpp"
 
 //
 // MARK: - Meta Class Definitions
@@ -215,50 +217,30 @@ IOReturn RealtekSDXCSlot::setSDCommandDataLength(UInt16 nblocks, UInt16 blockSiz
 }
 
 ///
-/// [Case 1] Send a SD command and wait for the response
+/// [Shared] [Helper] Enqueue a sequence of operations to send the given SD command and load its response
 ///
 /// @param command The SD command to be sent
-/// @param timeout The amount of time in milliseconds to wait for the response until timed out
 /// @return `kIOReturnSuccess` on success, other values otherwise.
-/// @note Port: This function replaces `sd_send_cmd_get_rsp()` defined in `rtsx_pci/usb_sdmmc.c`.
-/// @note This function checks whether the start and the transmission bits and the CRC7 checksum in the response are valid.
-///       Upon a successful return, the response is guaranteed to be valid, but the caller is responsible for verifying the content.
-/// @note This function is invoked by `IOSDHostDriver::CMD*()` and `IOSDHostDriver::ACMD*()` that do not involve a data transfer.
+/// @note Port: This function is refactored from `sd_send_cmd_get_rsp()` defined in `rtsx_pci/usb_sdmmc.c`.
+/// @note Once the session completes, the host buffer contains the value of `SD_TRANSFER`, the command response and the value of `SD_STAT1`
+///       starting at the offset where the response to the first operation enqueued by this function is stored.
+///       The caller should invoke `loadSDCommandResponse()` to verify the transfer status and fetch the response.
+/// @warning This function is valid only when there is an active transfer session.
+///          i.e. The caller should invoke this function in between `Controller::beginCommandTransfer()` and `Controller::endCommandTransfer()`.
 ///
-IOReturn RealtekSDXCSlot::runSDCommand(IOSDHostCommand& command, UInt32 timeout)
+IOReturn RealtekSDXCSlot::enqueueSDCommand(IOSDHostCommand& command)
 {
     using namespace RTSX::COM::Chip;
     
     // Wrap the given host command
     RealtekSDHostCommand wcmd = RealtekSDHostCommand::wraps(command);
     
-    // Fetch the response type and set up the timeout value
     IOSDHostCommand::ResponseType responseType = wcmd->getResponseType();
     
-    if (responseType == IOSDHostCommand::ResponseType::kR1b)
-    {
-        timeout = wcmd->getBusyTimeout(3000);
-    }
-    
-    IOByteCount responseLength = wcmd.getRealResponseLength();
-    
-    pinfo("SDCMD = %02d; Arg = 0x%08X; Response Length = %llu bytes; Timeout = %d ms.",
-          wcmd->getOpcode(), wcmd->getArgument(), responseLength, timeout);
-    
-    // Start a command transfer session
-    IOReturn retVal = this->controller->beginCommandTransfer();
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to initiate a new command transfer session. Error = 0x%x.", retVal);
-        
-        return retVal;
-    }
-    
     // Set the command opcode and its argument
     pinfo("Setting the command opcode and the argument...");
     
-    retVal = this->setSDCommandOpcodeAndArgument(*wcmd);
+    IOReturn retVal = this->setSDCommandOpcodeAndArgument(*wcmd);
     
     if (retVal != kIOReturnSuccess)
     {
@@ -360,22 +342,29 @@ IOReturn RealtekSDXCSlot::runSDCommand(IOSDHostCommand& command, UInt32 timeout)
         return retVal;
     }
     
-    // Finish the command transfer session and wait for the response
-    retVal = this->controller->endCommandTransfer(timeout, this->controller->getDataTransferFlags().command);
+    return kIOReturnSuccess;
+}
+
+///
+/// [Shared] [Helper] Verify the transfer status and load the response of the given SD command from the host buffer
+///
+/// @param command The SD command that has been sent via `enqueueSDCommand()`
+/// @param offset The offset in the host buffer where the value of `SD_TRANSFER` enqueued by `enqueueSDCommand()` is stored
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function is refactored from `sd_send_cmd_get_rsp()` defined in `rtsx_pci/usb_sdmmc.c`.
+/// @note This function checks whether the start and the transmission bits and the CRC7 checksum in the response are valid.
+///
+IOReturn RealtekSDXCSlot::loadSDCommandResponse(IOSDHostCommand& command, IOByteCount offset)
+{
+    using namespace RTSX::COM::Chip;
     
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to terminate the command transfer session. Error = 0x%x.", retVal);
-        
-        this->controller->clearError();
-        
-        return retVal;
-    }
+    // Wrap the given host command
+    RealtekSDHostCommand wcmd = RealtekSDHostCommand::wraps(command);
     
     pinfo("Verifying the transfer result...");
     
     //
-    // Layout of the host command buffer at this moment:
+    // Layout of the host command buffer starting at the given offset:
     //
     // Offset 00: Value of `SD_TRANSFER`
     // Offset 01: The command response
@@ -385,7 +374,7 @@ IOReturn RealtekSDXCSlot::runSDCommand(IOSDHostCommand& command, UInt32 timeout)
     // Offset LB: Value of `SD_STAT1`
     //
     // Guard: Verify the transfer status
-    BitOptions transferStatus = this->controller->readHostBufferValue<UInt8>(0);
+    BitOptions transferStatus = this->controller->readHostBufferValue<UInt8>(offset);
     
     if (!transferStatus.contains(SD::TRANSFER::kTransferEnd | SD::TRANSFER::kTransferIdle))
     {
@@ -397,7 +386,7 @@ IOReturn RealtekSDXCSlot::runSDCommand(IOSDHostCommand& command, UInt32 timeout)
     pinfo("The transfer status has been verified.");
     
     // Load the response
-    retVal = this->controller->readHostBuffer(1, wcmd->getResponseBuffer(), responseLength);
+    IOReturn retVal = this->controller->readHostBuffer(offset + 1, wcmd->getResponseBuffer(), wcmd.getRealResponseLength());
     
     if (retVal != kIOReturnSuccess)
     {
@@ -427,6 +416,149 @@ IOReturn RealtekSDXCSlot::runSDCommand(IOSDHostCommand& command, UInt32 timeout)
     return kIOReturnSuccess;
 }
 
+///
+/// [Case 1] Send a SD command and wait for the response
+///
+/// @param command The SD command to be sent
+/// @param timeout The amount of time in milliseconds to wait for the response until timed out
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces `sd_send_cmd_get_rsp()` defined in `rtsx_pci/usb_sdmmc.c`.
+/// @note This function checks whether the start and the transmission bits and the CRC7 checksum in the response are valid.
+///       Upon a successful return, the response is guaranteed to be valid, but the caller is responsible for verifying the content.
+/// @note This function is invoked by `IOSDHostDriver::CMD*()` and `IOSDHostDriver::ACMD*()` that do not involve a data transfer.
+///
+IOReturn RealtekSDXCSlot::runSDCommand(IOSDHostCommand& command, UInt32 timeout)
+{
+    // Fetch the response type and set up the timeout value
+    if (command.getResponseType() == IOSDHostCommand::ResponseType::kR1b)
+    {
+        timeout = command.getBusyTimeout(3000);
+    }
+    
+    pinfo("SDCMD = %02d; Arg = 0x%08X; Response Length = %llu bytes; Timeout = %d ms.",
+          command.getOpcode(), command.getArgument(), RealtekSDHostCommand::wraps(command).getRealResponseLength(), timeout);
+    
+    // Start a command transfer session
+    IOReturn retVal = this->controller->beginCommandTransfer();
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to initiate a new command transfer session. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    // Enqueue the command along with operations to load the response
+    retVal = this->enqueueSDCommand(command);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to enqueue the SD command. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    // Finish the command transfer session and wait for the response
+    retVal = this->controller->endCommandTransfer(timeout, this->controller->getDataTransferFlags().command);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to terminate the command transfer session. Error = 0x%x.", retVal);
+        
+        this->controller->clearError();
+        
+        return retVal;
+    }
+    
+    // Verify the transfer status and load the response
+    return this->loadSDCommandResponse(command, 0);
+}
+
+///
+/// [Case 1] Send a sequence of SD commands in a single session and wait for their responses
+///
+/// @param preCommands An array of SD commands to be sent before the given command
+/// @param numPreCommands The number of commands in the given array
+/// @param command The last SD command to be sent
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note This function checks whether the start and the transmission bits and the CRC7 checksum in each response are valid.
+/// @note The card reader stops executing the remaining commands once it fails to send a command,
+///       so subsequent commands are never sent to the card if a previous one fails.
+///
+IOReturn RealtekSDXCSlot::runSDCommandSequence(IOSDHostCommand* preCommands, IOItemCount numPreCommands, IOSDHostCommand& command)
+{
+    // Guard: Check whether there are commands to be sent before the given one
+    if (numPreCommands == 0)
+    {
+        return this->runSDCommand(command);
+    }
+    
+    pinfo("Sending %u commands before the SDCMD %02d in the same session.", numPreCommands, command.getOpcode());
+    
+    // Start a command transfer session
+    IOReturn retVal = this->controller->beginCommandTransfer();
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to initiate a new command transfer session. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    // Enqueue all commands along with operations to load their responses
+    UInt32 timeout = 0;
+    
+    for (IOItemCount index = 0; index <= numPreCommands; index += 1)
+    {
+        IOSDHostCommand& current = index < numPreCommands ? preCommands[index] : command;
+        
+        retVal = this->enqueueSDCommand(current);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to enqueue the SDCMD %02d. Error = 0x%x.", current.getOpcode(), retVal);
+            
+            return retVal;
+        }
+        
+        timeout += current.getResponseType() == IOSDHostCommand::ResponseType::kR1b ? current.getBusyTimeout(3000) : 100;
+    }
+    
+    // Finish the command transfer session and wait for the responses
+    retVal = this->controller->endCommandTransfer(timeout, this->controller->getDataTransferFlags().command);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to terminate the command transfer session. Error = 0x%x.", retVal);
+        
+        this->controller->clearError();
+        
+        return retVal;
+    }
+    
+    // Verify the transfer status and load the response of each command
+    // Each command occupies the value of `SD_TRANSFER` followed by its actual response in the host buffer
+    IOByteCount offset = 0;
+    
+    for (IOItemCount index = 0; index <= numPreCommands; index += 1)
+    {
+        IOSDHostCommand& current = index < numPreCommands ? preCommands[index] : command;
+        
+        retVal = this->loadSDCommandResponse(current, offset);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to verify the response to the SDCMD %02d. Error = 0x%x.", current.getOpcode(), retVal);
+            
+            return retVal;
+        }
+        
+        offset += 1 + RealtekSDHostCommand::wraps(current).getRealResponseLength();
+    }
+    
+    return kIOReturnSuccess;
+}
+
 ///
 /// [Case 1] Send a SD command and wait for the response
 ///
@@ -579,6 +711,24 @@ IOReturn RealtekSDXCSlot::runSDCommandAndReadData(IOSDHostCommand& command, IOMe
         return retVal;
     }
     
+    // Read the data from the ping pong buffer in the same session if the host command buffer can hold all read commands
+    bool fused = command.getOpcode() != IOSDHostCommand::Opcode::kSendTuningBlock &&
+                 length <= this->controller->getPingPongBufferReadCapacityInSession();
+    
+    if (fused)
+    {
+        pinfo("Reading %llu bytes from the ping pong buffer in the same session.", length);
+        
+        retVal = this->controller->enqueueReadRegisterCommands(ContiguousRegValuePairsForReadAccess(PPBUF::rBASE2, static_cast<IOItemCount>(length)));
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to enqueue the operations to read the ping pong buffer. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+    }
+    
     // Finish the command transfer session and wait for the response
     retVal = this->controller->endCommandTransfer(timeout, this->controller->getDataTransferFlags().commandWithInboundDataTransfer);
     
@@ -611,6 +761,30 @@ IOReturn RealtekSDXCSlot::runSDCommandAndReadData(IOSDHostCommand& command, IOMe
         return kIOReturnSuccess;
     }
     
+    // The data follows the transfer status in the host buffer if it has been read in the same session
+    if (fused)
+    {
+        auto action = [&](UInt8* buffer) -> IOReturn
+        {
+            return this->controller->readHostBuffer(1, buffer, length);
+        };
+        
+        retVal = IOMemoryDescriptorWithIntermediateDestinationBuffer(descriptor, 0, length, action);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to copy the command response from the host buffer. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        pbuf(descriptor, length);
+        
+        pinfo("The command response has been loaded from the ping pong buffer.");
+        
+        return kIOReturnSuccess;
+    }
+    
     // Warning: The USB driver separates the loading process into two parts:
     //          the 2-byte aligned part and the unaligned part.
     //          We keep the implementation that is designed for the PCIe-based card reader driver,
@@ -860,198 +1034,85 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundDataTransferRequest(IOSDDa
 }
 
 ///
-/// [Case 3] Send a SD command along with an inbound DMA transfer
+/// [Case 3] [Shared] Invoked when the DMA transfer of a block request completes
+///
+/// @param parameter The status of the transfer passed to `RealtekCardReaderController::waitForDMATransfer()`
+/// @param status The final status of the transfer
+/// @note This function runs in a gated context.
+///
+void RealtekSDXCSlot::onDMATransferCompletion(void* parameter, IOReturn status)
+{
+    this->controller->onDMATransferDoneGated(reinterpret_cast<IOReturn*>(parameter), status);
+}
+
+///
+/// [Case 3] [Shared] Send a SD command along with a DMA transfer
 ///
 /// @param request A block-oriented data transfer request to service
+/// @param direction `kIODirectionIn` if the host reads blocks from the card, `kIODirectionOut` if the host writes blocks to the card
+/// @param preCommands An array of SD commands to be sent before the data transfer command (e.g., CMD23 or CMD55 + ACMD23)
+/// @param numPreCommands The number of commands in the given array
+/// @param stopCommand A nullable STOP command to be sent once the data transfer completes
 /// @return `kIOReturnSuccess` on success, other values otherwise.
-/// @note Port: This function replaces `sd_read_long_data()` defined in `rtsx_pci_sdmmc.c`.
-/// @note This function is invoked by `IOSDHostDriver::CMD*()` and `IOSDHostDriver::ACMD*()` that involve a DMA transfer.
-/// @note This function serves as the processor routine that handles command requests that read a single block from the card.
-/// @seealso `IOSDHostRequest::processor` and `IOSDHostRequestFactory::readSingleBlockProcessor`.
-///
-IOReturn RealtekSDXCSlot::processSDCommandWithInboundSingleBlockDMATransferRequest(IOSDSingleBlockRequest& request)
+/// @note Port: This function replaces `sd_read_long_data()` and `sd_write_long_data()` defined in `rtsx_pci_sdmmc.c`.
+/// @note Commands that precede the data transfer command are sent in the same session as the data transfer command.
+/// @note By default, the block read command is sent by the card reader as part of the data transfer (i.e. `kTMAutoRead2`),
+///       so that preceding commands, the data transfer command and the DMA transfer complete in a single host command transfer session.
+///       The block write command is sent in a separate session before the data transfer (i.e. `kTMAutoWrite3`) as the Linux driver does,
+///       unless the boot argument `-rtsxfwdt` is specified, in which case it is sent as part of the data transfer (i.e. `kTMAutoWrite2`).
+///       The boot argument `-rtsxscdt` restores the behavior of sending the data transfer command in a separate session for both directions.
+/// @note If the STOP command is given, it is queued in the same host command transfer session as the data transfer,
+///       so the card reader sends it right after the data transfer completes, saving a separate session.
+///       The caller must pass `nullptr` if the controller cannot queue commands after a DMA transfer.
+/// @seealso `RealtekCardReaderController::canQueueCommandsAfterDMATransfer()`.
+/// @note The DMA transfer times out after the amount of time derived from the card parameters by the host driver,
+///       or after 10 seconds if the request does not specify one.
+/// @note If a command sent in the same session fails before the data transfer (e.g. no response or a CRC error),
+///       the controller aborts the DMA transfer as soon as it learns the failure instead of waiting for the timeout.
+///       PCIe-based controllers learn it from the transfer failure interrupt, as `sd_read_long_data()` does,
+///       while USB-based controllers only learn it from the response loaded after the transfer.
+///
+IOReturn RealtekSDXCSlot::runSDCommandWithDMATransfer(IOSDSingleBlockRequest& request, IODirection direction, IOSDHostCommand* preCommands, IOItemCount numPreCommands, IOSDHostCommand* stopCommand)
 {
     using namespace RTSX::COM::Chip;
     
-    // Send the SD command
-    IOReturn retVal = this->runSDCommand(request.command);
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to send the SD command. Error = 0x%x.", retVal);
-        
-        return retVal;
-    }
-    
-    // Set up the SD_CFG2 register value
-    UInt8 cfg2 = SD::CFG2::kCalcCRC7 | SD::CFG2::kCheckCRC7 | SD::CFG2::kCheckCRC16 | SD::CFG2::kNoWaitBusyEnd | SD::CFG2::kResponseLength0;
-    
-    if (!this->isRunningInUltraHighSpeedMode())
-    {
-        // This branch seems to be PCIe-specific
-        // but has no side effect with USB card readers
-        cfg2 |= SD::CFG2::kNoCheckWaitCRCTo;
-    }
-    
-    // Fetch the data length
-    UInt64 dataLength = request.data.getDataLength();
-    
-    psoftassert(dataLength <= UINT32_MAX, "The data length should not exceed UINT32_MAX.");
-    
-    pinfo("SDCMD = %02d; Arg = 0x%08X; Data Length = %llu bytes.", request.command.getOpcode(), request.command.getArgument(), dataLength);
-    
-    // Start a command transfer session
-    retVal = this->controller->beginCommandTransfer();
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to initiate a new command transfer session. Error = 0x%x.", retVal);
-        
-        return retVal;
-    }
-    
-    // Set the number of data blocks and the size of each block
-    pinfo("Setting the length of the data blocks associated with the command...");
-    
-    retVal = this->setSDCommandDataLength(request.data.getNumBlocks(), request.data.getBlockSize());
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to set the command data blocks and length. Error = 0x%x.", retVal);
-        
-        return retVal;
-    }
-    
-    pinfo("The data length has been set.");
-    
-    // Set the transfer property
-    pinfo("Setting the transfer properties...");
-    
-    retVal = this->controller->setupCardDMATransferProperties(static_cast<UInt32>(dataLength), kIODirectionIn);
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to set the DMA transfer properties. Error = 0x%x.", retVal);
-        
-        return retVal;
-    }
-    
-    retVal = this->controller->selectCardDataSourceToRingBuffer();
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to select the card data source to be the ring buffer. Error = 0x%x.", retVal);
-        
-        return retVal;
-    }
-    
-    const ChipRegValuePair pairs[] =
-    {
-        { SD::rCFG2, 0xFF, cfg2 },
-        { SD::rTRANSFER, 0xFF, SD::TRANSFER::kTransferStart | SD::TRANSFER::kTMAutoRead3 },
-    };
-    
-    retVal = this->controller->enqueueWriteRegisterCommands(SimpleRegValuePairs(pairs));
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to set the transfer property. Error = 0x%x.", retVal);
-        
-        return retVal;
-    }
-    
-    pinfo("Transfer properties are set.");
-    
-    // Once the transfer finishes, we need to check the end bit in the `SD_TRANSFER` register.
-    // Note that the Linux driver issues a CHECK REGISTER operation but ignores its return value.
-    // We will check the register value manually.
-    retVal = this->controller->enqueueCheckRegisterCommand(SD::rTRANSFER, SD::TRANSFER::kTransferEnd, SD::TRANSFER::kTransferEnd);
-
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to enqueue a read operation to load the transfer status. Error = 0x%x.", retVal);
-
-        return retVal;
-    }
-    
-    // Send the command
-    retVal = this->controller->endCommandTransferNoWait(this->controller->getDataTransferFlags().commandWithInboundDMATransfer);
-
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to complete the command transfer session. Error = 0x%x.", retVal);
-
-        return retVal;
-    }
-    
-    // Initiate the DMA transfer
-    pinfo("Initiating the DMA transfer...");
+    // Check whether the SD command is sent by the card reader as part of the data transfer
+    // Writes are fused only if the user opts in, since the card reader does not wait for the card to accept the command before sending data
+    bool fused = !UserConfigs::COM::SeparateCommandAndDataTransfer &&
+                 (direction == kIODirectionIn || UserConfigs::COM::FuseWriteCommandAndDataTransfer);
     
-    retVal = this->controller->performDMARead(request.data.getMemoryDescriptor(), 10000);
+    IOReturn retVal = kIOReturnSuccess;
     
-    if (retVal != kIOReturnSuccess)
+    // Send the SD command along with commands that must precede it in a separate session
+    if (!fused)
     {
-        perr("Failed to perform the DMA transfer. Error = 0x%x.", retVal);
-        
-        this->controller->clearError();
+        retVal = this->runSDCommandSequence(preCommands, numPreCommands, request.command);
         
-        return retVal;
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to send the SD command. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
     }
     
-    pinfo("DMA transfer completed successfully.");
-    
-    // Load the response to the command transfer
-    retVal = this->controller->loadCommandTransferResponse(2000);
+    // Set up the SD_CFG2 register value
+    UInt8 cfg2 = SD::CFG2::kCheckCRC16 | SD::CFG2::kNoWaitBusyEnd;
     
-    if (retVal != kIOReturnSuccess)
+    if (fused)
     {
-        perr("Failed to load the response to the command transfer. Error = 0x%x.", retVal);
-        
-        return retVal;
+        // The card reader sends the command and verifies its R1 response before the data transfer
+        cfg2 |= SD::CFG2::kCalcCRC7 | SD::CFG2::kCheckCRC7 | SD::CFG2::kResponseLength6;
     }
-      
-    // Verify the transfer status
-    BitOptions<UInt8> transferStatus = this->controller->readHostBufferValue<UInt8>(0);
-    
-    pinfo("Transfer status = 0x%02x.", transferStatus.flatten());
-    
-    if (transferStatus.contains(SD::TRANSFER::kTransferError))
+    else if (direction == kIODirectionIn)
     {
-        perr("Found the error bit set in the transfer status.");
-        
-        return kIOReturnInvalid;
+        cfg2 |= SD::CFG2::kCalcCRC7 | SD::CFG2::kCheckCRC7 | SD::CFG2::kResponseLength0;
     }
-    
-    return kIOReturnSuccess;
-}
-
-///
-/// [Case 3] Send a SD command along with an outbound DMA transfer
-///
-/// @param request A block-oriented data transfer request to service
-/// @return `kIOReturnSuccess` on success, other values otherwise.
-/// @note Port: This function replaces `sd_write_long_data()` defined in `rtsx_pci_sdmmc.c`.
-/// @note This function is invoked by `IOSDHostDriver::CMD*()` and `IOSDHostDriver::ACMD*()` that involve a DMA transfer.
-/// @note This function serves as the processor routine that handles command requests that write a single block to the card.
-/// @seealso `IOSDHostRequest::processor` and `IOSDHostRequestFactory::writeSingleBlockProcessor`.
-///
-IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequest(IOSDSingleBlockRequest& request)
-{
-    using namespace RTSX::COM::Chip;
-    
-    // Send the SD command
-    IOReturn retVal = this->runSDCommand(request.command);
-    
-    if (retVal != kIOReturnSuccess)
+    else
     {
-        perr("Failed to send the SD command. Error = 0x%x.", retVal);
-        
-        return retVal;
+        cfg2 |= SD::CFG2::kNoCalcCRC7 | SD::CFG2::kNoCheckCRC7 | SD::CFG2::kResponseLength0;
     }
     
-    // Set up the SD_CFG2 register value
-    UInt8 cfg2 = SD::CFG2::kNoCalcCRC7 | SD::CFG2::kNoCheckCRC7 | SD::CFG2::kCheckCRC16 | SD::CFG2::kNoWaitBusyEnd | SD::CFG2::kResponseLength0;
-    
     if (!this->isRunningInUltraHighSpeedMode())
     {
         // This branch seems to be PCIe-specific
@@ -1064,7 +1125,8 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
     
     psoftassert(dataLength <= UINT32_MAX, "The data length should not exceed UINT32_MAX.");
     
-    pinfo("SDCMD = %02d; Arg = 0x%08X; Data Length = %llu bytes.", request.command.getOpcode(), request.command.getArgument(), dataLength);
+    pinfo("SDCMD = %02d; Arg = 0x%08X; Data Length = %llu bytes; Fused = %s.",
+          request.command.getOpcode(), request.command.getArgument(), dataLength, YESNO(fused));
     
     // Start a command transfer session
     retVal = this->controller->beginCommandTransfer();
@@ -1073,7 +1135,40 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
     {
         perr("Failed to initiate a new command transfer session. Error = 0x%x.", retVal);
         
-        return retVal;
+        return retVal;
+    }
+    
+    // The offset in the host buffer where the value of `SD_TRANSFER` after the data transfer is stored
+    IOByteCount offset = 0;
+    
+    if (fused)
+    {
+        // Enqueue commands that must precede the data transfer command
+        // The card reader stops executing the remaining operations once it fails to send a command
+        for (IOItemCount index = 0; index < numPreCommands; index += 1)
+        {
+            retVal = this->enqueueSDCommand(preCommands[index]);
+            
+            if (retVal != kIOReturnSuccess)
+            {
+                perr("Failed to enqueue the SDCMD %02d. Error = 0x%x.", preCommands[index].getOpcode(), retVal);
+                
+                return retVal;
+            }
+            
+            offset += 1 + RealtekSDHostCommand::wraps(preCommands[index]).getRealResponseLength();
+        }
+        
+        // Set the data transfer command opcode and its argument
+        // The command is sent by the card reader once the data transfer starts
+        retVal = this->setSDCommandOpcodeAndArgument(request.command);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to set the command index and argument. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
     }
     
     // Set the number of data blocks and the size of each block
@@ -1093,7 +1188,7 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
     // Set the transfer property
     pinfo("Setting the transfer properties...");
     
-    retVal = this->controller->setupCardDMATransferProperties(static_cast<UInt32>(dataLength), kIODirectionOut);
+    retVal = this->controller->setupCardDMATransferProperties(static_cast<UInt32>(dataLength), direction);
     
     if (retVal != kIOReturnSuccess)
     {
@@ -1111,10 +1206,23 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
         return retVal;
     }
     
+    // Ask the card reader to send the command before the data transfer if fused
+    // Note that the STOP command is never sent automatically by the card reader
+    UInt8 transferMode;
+    
+    if (direction == kIODirectionIn)
+    {
+        transferMode = fused ? SD::TRANSFER::kTMAutoRead2 : SD::TRANSFER::kTMAutoRead3;
+    }
+    else
+    {
+        transferMode = fused ? SD::TRANSFER::kTMAutoWrite2 : SD::TRANSFER::kTMAutoWrite3;
+    }
+    
     const ChipRegValuePair pairs[] =
     {
         { SD::rCFG2, 0xFF, cfg2 },
-        { SD::rTRANSFER, 0xFF, SD::TRANSFER::kTransferStart | SD::TRANSFER::kTMAutoWrite3 },
+        { SD::rTRANSFER, 0xFF, static_cast<UInt8>(SD::TRANSFER::kTransferStart | transferMode) },
     };
     
     retVal = this->controller->enqueueWriteRegisterCommands(SimpleRegValuePairs(pairs));
@@ -1140,8 +1248,64 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
         return retVal;
     }
     
+    // Load the response to the data transfer command if fused
+    // The card reader puts the 48-bit response in the `SD_CMD{0-4}` registers,
+    // but only controllers that can execute host commands queued after a DMA transfer can return them to the host.
+    // Otherwise, the error bit in `SD_TRANSFER` reports an invalid response.
+    bool loadsResponse = fused && this->controller->canQueueCommandsAfterDMATransfer();
+    
+    if (loadsResponse)
+    {
+        retVal = this->controller->enqueueReadRegisterCommands(ContiguousRegValuePairsForReadAccess(SD::rCMD0, 5));
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to enqueue a sequence of read operations to load the command response. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        retVal = this->controller->enqueueReadRegisterCommand(SD::rSTAT1);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to enqueue a read operation to load the command status. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+    }
+    
+    // Queue the STOP command right after the data transfer if requested
+    // The card reader executes host commands in order, so the STOP command is sent once the check operation above passes.
+    UInt32 responseTimeout = 2000;
+    
+    if (stopCommand != nullptr)
+    {
+        pinfo("Queuing the STOP command in the current session...");
+        
+        retVal = this->enqueueSDCommand(*stopCommand);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to enqueue the STOP command. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        UInt32 busyTimeout = stopCommand->getBusyTimeout(3000);
+        
+        if (busyTimeout > responseTimeout)
+        {
+            responseTimeout = busyTimeout;
+        }
+    }
+    
     // Send the command
-    retVal = this->controller->endCommandTransferNoWait(this->controller->getDataTransferFlags().commandWithOutboundDMATransfer);
+    UInt32 flags = direction == kIODirectionIn ?
+                   this->controller->getDataTransferFlags().commandWithInboundDMATransfer :
+                   this->controller->getDataTransferFlags().commandWithOutboundDMATransfer;
+    
+    retVal = this->controller->endCommandTransferNoWait(flags);
 
     if (retVal != kIOReturnSuccess)
     {
@@ -1151,9 +1315,30 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
     }
     
     // Initiate the DMA transfer
+    // The controller delivers the completion from its interrupt path
     pinfo("Initiating the DMA transfer...");
     
-    retVal = this->controller->performDMAWrite(request.data.getMemoryDescriptor(), 10000);
+    IOReturn dmaStatus = kIOReturnNotReady;
+    
+    auto completion = RealtekCardReaderController::DMACompletion::withMemberFunction(this, &RealtekSDXCSlot::onDMATransferCompletion, &dmaStatus);
+    
+    if (direction == kIODirectionIn)
+    {
+        retVal = this->controller->startDMARead(request.data.getMemoryDescriptor(), request.data.getTimeout(10000), completion);
+    }
+    else
+    {
+        retVal = this->controller->startDMAWrite(request.data.getMemoryDescriptor(), request.data.getTimeout(10000), completion);
+    }
+    
+    if (retVal == kIOReturnSuccess)
+    {
+        // The card reader is now busy with the transfer
+        // Give the host driver a chance to prepare the next pending request in the meantime
+        this->onDMATransferInFlight();
+        
+        retVal = this->controller->waitForDMATransfer(&dmaStatus);
+    }
     
     if (retVal != kIOReturnSuccess)
     {
@@ -1167,7 +1352,7 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
     pinfo("DMA transfer completed successfully.");
     
     // Load the response to the command transfer
-    retVal = this->controller->loadCommandTransferResponse(2000);
+    retVal = this->controller->loadCommandTransferResponse(responseTimeout);
     
     if (retVal != kIOReturnSuccess)
     {
@@ -1176,8 +1361,35 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
         return retVal;
     }
       
+    // Verify the responses to the commands that precede the data transfer command if fused
+    // Layout of the host command buffer at this moment:
+    //
+    // Offset 00: Value of `SD_TRANSFER`, the command response, and the value of `SD_STAT1` of each preceding command
+    // Offset PP: Value of `SD_TRANSFER` after the data transfer
+    // Offset +1: The response to the data transfer command and the value of `SD_STAT1` if loaded
+    // Offset SS: Value of `SD_TRANSFER` after the STOP command, the command response, and the value of `SD_STAT1`
+    //
+    if (fused)
+    {
+        IOByteCount preCommandOffset = 0;
+        
+        for (IOItemCount index = 0; index < numPreCommands; index += 1)
+        {
+            retVal = this->loadSDCommandResponse(preCommands[index], preCommandOffset);
+            
+            if (retVal != kIOReturnSuccess)
+            {
+                perr("Failed to verify the response to the SDCMD %02d. Error = 0x%x.", preCommands[index].getOpcode(), retVal);
+                
+                return retVal;
+            }
+            
+            preCommandOffset += 1 + RealtekSDHostCommand::wraps(preCommands[index]).getRealResponseLength();
+        }
+    }
+    
     // Verify the transfer status
-    BitOptions<UInt8> transferStatus = this->controller->readHostBufferValue<UInt8>(0);
+    BitOptions<UInt8> transferStatus = this->controller->readHostBufferValue<UInt8>(offset);
     
     pinfo("Transfer status = 0x%02x.", transferStatus.flatten());
     
@@ -1188,6 +1400,48 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
         return kIOReturnInvalid;
     }
     
+    // Verify the response to the data transfer command if loaded
+    // Note that the transfer status has been verified above, so `loadSDCommandResponse()` is not applicable here.
+    if (loadsResponse)
+    {
+        RealtekSDHostCommand wcmd = RealtekSDHostCommand::wraps(request.command);
+        
+        retVal = this->controller->readHostBuffer(offset + 1, wcmd->getResponseBuffer(), wcmd.getRealResponseLength());
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to read the response to the data transfer command from the host command buffer. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        wcmd->printResponse();
+        
+        if (!wcmd.verifyStartAndTransmissionBitsInResponse() || !wcmd.verifyCRC7InResponse())
+        {
+            perr("The response to the data transfer command is invalid.");
+            
+            return kIOReturnInvalid;
+        }
+        
+        offset += wcmd.getRealResponseLength();
+    }
+    
+    // Verify the response to the STOP command if any
+    if (stopCommand != nullptr)
+    {
+        retVal = this->loadSDCommandResponse(*stopCommand, offset + 1);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to verify the response to the STOP command. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        pinfo("The STOP command has been sent along with the data transfer.");
+    }
+    
     return kIOReturnSuccess;
 }
 
@@ -1198,23 +1452,95 @@ IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequ
 /// @return `kIOReturnSuccess` on success, other values otherwise.
 /// @note Port: This function replaces `sd_read_long_data()` defined in `rtsx_pci_sdmmc.c`.
 /// @note This function is invoked by `IOSDHostDriver::CMD*()` and `IOSDHostDriver::ACMD*()` that involve a DMA transfer.
-/// @note This function serves as the processor routine that handles command requests that read multiple blocks from the card.
-/// @seealso `IOSDHostRequest::processor` and `IOSDHostRequestFactory::readMultiBlocksProcessor`.
+/// @note This function serves as the processor routine that handles command requests that read a single block from the card.
+/// @seealso `IOSDHostRequest::processor` and `IOSDHostRequestFactory::readSingleBlockProcessor`.
 ///
-IOReturn RealtekSDXCSlot::processSDCommandWithInboundMultiBlocksDMATransferRequest(IOSDMultiBlocksRequest& request)
+IOReturn RealtekSDXCSlot::processSDCommandWithInboundSingleBlockDMATransferRequest(IOSDSingleBlockRequest& request)
+{
+    return this->runSDCommandWithDMATransfer(request, kIODirectionIn, nullptr, 0, nullptr);
+}
+
+///
+/// [Case 3] Send a SD command along with an outbound DMA transfer
+///
+/// @param request A block-oriented data transfer request to service
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces `sd_write_long_data()` defined in `rtsx_pci_sdmmc.c`.
+/// @note This function is invoked by `IOSDHostDriver::CMD*()` and `IOSDHostDriver::ACMD*()` that involve a DMA transfer.
+/// @note This function serves as the processor routine that handles command requests that write a single block to the card.
+/// @seealso `IOSDHostRequest::processor` and `IOSDHostRequestFactory::writeSingleBlockProcessor`.
+///
+IOReturn RealtekSDXCSlot::processSDCommandWithOutboundSingleBlockDMATransferRequest(IOSDSingleBlockRequest& request)
+{
+    return this->runSDCommandWithDMATransfer(request, kIODirectionOut, nullptr, 0, nullptr);
+}
+
+///
+/// [Case 3] [Shared] Send a SD command along with a DMA transfer that accesses multiple blocks and then stop the transmission
+///
+/// @param request A block-oriented data transfer request to service
+/// @param direction `kIODirectionIn` if the host reads blocks from the card, `kIODirectionOut` if the host writes blocks to the card
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note The STOP command is queued in the same host command transfer session as the data transfer if the controller supports it.
+///       Otherwise, or if the data transfer fails, the STOP command is sent in a separate session.
+/// @note The STOP command is not sent if the request uses a predefined transfer mode (i.e. CMD23) and the data transfer succeeds.
+///
+IOReturn RealtekSDXCSlot::runSDCommandWithMultiBlocksDMATransfer(IOSDMultiBlocksRequest& request, IODirection direction)
 {
-    IOReturn retVal = this->processSDCommandWithInboundSingleBlockDMATransferRequest(request);
+    // The card stops a predefined transmission by itself, so the STOP command is only needed if the transfer fails
+    bool needsStopCommand = !request.predefined;
+    
+    // Guard: Check whether the STOP command can be sent along with the data transfer
+    if (needsStopCommand && this->controller->canQueueCommandsAfterDMATransfer())
+    {
+        IOReturn retVal = this->runSDCommandWithDMATransfer(request, direction, request.preCommands, request.numPreCommands, &request.stopCommand);
+        
+        if (retVal == kIOReturnSuccess)
+        {
+            return kIOReturnSuccess;
+        }
+        
+        // The card reader stops executing host commands once a check operation fails,
+        // so the STOP command may not have been sent to the card.
+        perr("Failed to service the request that accesses multiple blocks. Error = 0x%x.", retVal);
+        
+        psoftassert(this->runSDCommand(request.stopCommand) == kIOReturnSuccess, "Failed to send the STOP command.");
+        
+        return retVal;
+    }
+    
+    IOReturn retVal = this->runSDCommandWithDMATransfer(request, direction, request.preCommands, request.numPreCommands, nullptr);
     
     if (retVal != kIOReturnSuccess)
     {
-        perr("Failed to service the request that reads multiple blocks. Error = 0x%x.", retVal);
+        perr("Failed to service the request that accesses multiple blocks. Error = 0x%x.", retVal);
+        
+        needsStopCommand = true;
     }
     
-    psoftassert(this->runSDCommand(request.stopCommand) == kIOReturnSuccess, "Failed to send the STOP command.");
+    if (needsStopCommand)
+    {
+        psoftassert(this->runSDCommand(request.stopCommand) == kIOReturnSuccess, "Failed to send the STOP command.");
+    }
     
     return retVal;
 }
 
+///
+/// [Case 3] Send a SD command along with an inbound DMA transfer
+///
+/// @param request A block-oriented data transfer request to service
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note Port: This function replaces `sd_read_long_data()` defined in `rtsx_pci_sdmmc.c`.
+/// @note This function is invoked by `IOSDHostDriver::CMD*()` and `IOSDHostDriver::ACMD*()` that involve a DMA transfer.
+/// @note This function serves as the processor routine that handles command requests that read multiple blocks from the card.
+/// @seealso `IOSDHostRequest::processor` and `IOSDHostRequestFactory::readMultiBlocksProcessor`.
+///
+IOReturn RealtekSDXCSlot::processSDCommandWithInboundMultiBlocksDMATransferRequest(IOSDMultiBlocksRequest& request)
+{
+    return this->runSDCommandWithMultiBlocksDMATransfer(request, kIODirectionIn);
+}
+
 ///
 /// [Case 3] Send a SD command along with an outbound DMA transfer
 ///
@@ -1227,16 +1553,7 @@ IOReturn RealtekSDXCSlot::processSDCommandWithInboundMultiBlocksDMATransferReque
 ///
 IOReturn RealtekSDXCSlot::processSDCommandWithOutboundMultiBlocksDMATransferRequest(IOSDMultiBlocksRequest& request)
 {
-    IOReturn retVal = this->processSDCommandWithOutboundSingleBlockDMATransferRequest(request);
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to service the request that writes multiple blocks. Error = 0x%x.", retVal);
-    }
-    
-    psoftassert(this->runSDCommand(request.stopCommand) == kIOReturnSuccess, "Failed to send the STOP command.");
-    
-    return retVal;
+    return this->runSDCommandWithMultiBlocksDMATransfer(request, kIODirectionOut);
 }
 
 ///
@@ -1261,42 +1578,54 @@ IOReturn RealtekSDXCSlot::processRequest(IOSDHostRequest& request)
     
     pinfo("The host driver has sent a SD command request.");
     
-    // Guard: Switch the clock
-    pinfo("Switching the clock...");
-    
-    IOReturn retVal = this->controller->switchCardClock(this->cardClock, this->sscDepth, this->initialMode, this->doubleClock, this->vpclock);
+    IOReturn retVal = kIOReturnSuccess;
     
-    if (retVal != kIOReturnSuccess)
+    // Guard: Check whether the clock and the card selection are still in effect
+    if (!this->isRequestContextApplied)
     {
-        perr("Failed to switch the clock for the incoming request. Error = 0x%x.", retVal);
+        // Guard: Switch the clock
+        pinfo("Switching the clock...");
         
-        return retVal;
-    }
-    
-    pinfo("The clock has been switched.");
-    
-    // Guard: Select the card
-    pinfo("Selecting the SD card...");
-    
-    auto action = [&]() -> IOReturn
-    {
-        passert(this->controller->selectCard() == kIOReturnSuccess, "Failed to select the card.");
+        retVal = this->controller->switchCardClock(this->cardClock, this->sscDepth, this->initialMode, this->doubleClock, this->vpclock);
         
-        passert(this->controller->configureCardShareMode() == kIOReturnSuccess, "Failed to configure the card share mode.");
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to switch the clock for the incoming request. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
         
-        return kIOReturnSuccess;
-    };
-    
-    retVal = this->controller->withCustomCommandTransfer(action);
-    
-    if (retVal != kIOReturnSuccess)
-    {
-        perr("Failed to select the SD card. Error = 0x%x.", retVal);
+        pinfo("The clock has been switched.");
         
-        return retVal;
+        // Guard: Select the card
+        pinfo("Selecting the SD card...");
+        
+        auto action = [&]() -> IOReturn
+        {
+            passert(this->controller->selectCard() == kIOReturnSuccess, "Failed to select the card.");
+            
+            passert(this->controller->configureCardShareMode() == kIOReturnSuccess, "Failed to configure the card share mode.");
+            
+            return kIOReturnSuccess;
+        };
+        
+        retVal = this->controller->withCustomCommandTransfer(action);
+        
+        if (retVal != kIOReturnSuccess)
+        {
+            perr("Failed to select the SD card. Error = 0x%x.", retVal);
+            
+            return retVal;
+        }
+        
+        pinfo("The SD card has been selected.");
+        
+        this->isRequestContextApplied = true;
+    }
+    else
+    {
+        pinfo("The clock and the card selection are still in effect.");
     }
-    
-    pinfo("The SD card has been selected.");
     
     // Guard: Dispatch the request
     pinfo("Servicing the request...");
@@ -1307,6 +1636,10 @@ IOReturn RealtekSDXCSlot::processRequest(IOSDHostRequest& request)
     {
         perr("Failed to service the request. Error = 0x%x.", retVal);
         
+        // The controller may have been reset to recover from the error,
+        // and the card clock may be adjusted if a DMA error has occurred
+        this->isRequestContextApplied = false;
+        
         return retVal;
     }
     
@@ -1627,6 +1960,9 @@ IOReturn RealtekSDXCSlot::setBusConfig(const IOSDBusConfig& config)
 {
     pinfo("The host driver requests to change the bus configuration.");
     
+    // The next request must apply the new clock and select the card again
+    this->isRequestContextApplied = false;
+    
     // Notify the card reader to enter the worker state
     this->controller->enterWorkerState();
     
@@ -1917,6 +2253,9 @@ IOReturn RealtekSDXCSlot::switchSignalVoltage3d3V()
 ///
 IOReturn RealtekSDXCSlot::switchSignalVoltage(const IOSDBusConfig& config)
 {
+    // The next request must apply the clock and select the card again
+    this->isRequestContextApplied = false;
+    
     // Guard: Check whether the card is still present
     if (!this->controller->isCardPresent())
     {
@@ -2356,6 +2695,93 @@ IOReturn RealtekSDXCSlot::isCardDataLineBusy(bool& result)
     return kIOReturnSuccess;
 }
 
+//
+// MARK: - Transfer Statistics
+//
+
+///
+/// Get the counters of the work performed by the host device
+///
+/// @param counters The counters on return
+///
+void RealtekSDXCSlot::getTransferCounters(TransferCounters& counters)
+{
+    const RealtekCardReaderController::TransferCounters& source = this->controller->getTransferCounters();
+    
+    counters.numRegisterAccesses = source.numRegisterAccesses;
+    
+    counters.numHostCommands = source.numHostCommands;
+    
+    counters.numCommandTransfers = source.numCommandTransfers;
+    
+    counters.numDMATransfers = source.numDMATransfers;
+    
+    counters.numInterrupts = source.numInterrupts;
+    
+    counters.numPolledCompletions = source.numPolledCompletions;
+}
+
+//
+// MARK: - Request Pipelining
+//
+
+///
+/// Prepare the DMA transfer of the given memory descriptor ahead of time
+///
+/// @param descriptor A non-null memory descriptor of the next pending block request
+/// @return `kIOReturnSuccess` on success, `kIOReturnUnsupported` if the controller cannot prepare a DMA transfer ahead of time.
+///
+IOReturn RealtekSDXCSlot::prepareDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    return this->controller->prepareDMATransferAhead(descriptor);
+}
+
+///
+/// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+///
+/// @param descriptor A non-null memory descriptor of a block request that has been serviced
+///
+void RealtekSDXCSlot::discardDMATransferAhead(IOMemoryDescriptor* descriptor)
+{
+    this->controller->discardDMATransferAhead(descriptor);
+}
+
+//
+// MARK: - Card Events
+//
+
+///
+/// [UPCALL] Notify the host device when a SD card is inserted
+///
+/// @param completion A nullable completion routine to be invoked when the card is attached
+/// @param options An optional value passed to the host driver
+/// @note This callback function runs in a gated context provided by the underlying card reader controller.
+///       The host device should implement this function without any blocking operations.
+///
+void RealtekSDXCSlot::onSDCardInsertedGated(IOSDCard::Completion* completion, IOSDCard::EventOptions options)
+{
+    // The card reader may have been reinitialized (e.g. wake from sleep)
+    this->isRequestContextApplied = false;
+    
+    super::onSDCardInsertedGated(completion, options);
+}
+
+///
+/// [UPCALL] Notify the host device when a SD card is removed
+///
+/// @param completion A nullable completion routine to be invoked when the card is detached
+/// @param options An optional value passed to the host driver
+/// @note This callback function runs in a gated context provided by the underlying card reader controller.
+///       The host device should implement this function without any blocking operations.
+///
+void RealtekSDXCSlot::onSDCardRemovedGated(IOSDCard::Completion* completion, IOSDCard::EventOptions options)
+{
+    // The card reader is about to be powered off or a different card may be inserted
+    this->isRequestContextApplied = false;
+    
+    super::onSDCardRemovedGated(completion, options);
+}
+
 //
 // MARK: - Manage Initial Modes
 //
@@ -2475,6 +2901,8 @@ bool RealtekSDXCSlot::init(OSDictionary* dictionary)
     
     this->powerMode = IOSDBusConfig::PowerMode::kPowerUndefined;
     
+    this->isRequestContextApplied = false;
+    
     return true;
 }
 
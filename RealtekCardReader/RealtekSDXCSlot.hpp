@@ -75,6 +75,16 @@ class RealtekSDXCSlot: public WolfsSDXCSlot
     /// The current bus power mode
     IOSDBusConfig::PowerMode powerMode;
     
+    ///
+    /// `True` if the card clock and the card selection have been applied for the current bus configuration
+    ///
+    /// @note `processRequest()` switches the clock and selects the card only if this flag is not set,
+    ///       so that subsequent requests do not reprogram the card reader with the same settings.
+    /// @note The flag is cleared when the bus configuration changes, when a card event occurs (including sleep and wake),
+    ///       and when a request fails, since the card reader may have been reset or left in a different state.
+    ///
+    bool isRequestContextApplied;
+    
     //
     // MARK: - SD Commander
     //
@@ -102,6 +112,79 @@ private:
     ///          i.e. The caller should invoke this function in between `Controller::beginCommandTransfer()` and `Controller::endCommandTransfer()`.
     ///
     IOReturn setSDCommandDataLength(UInt16 nblocks, UInt16 blockSize);
+    
+    ///
+    /// [Shared] [Helper] Enqueue a sequence of operations to send the given SD command and load its response
+    ///
+    /// @param command The SD command to be sent
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function is refactored from `sd_send_cmd_get_rsp()` defined in `rtsx_pci/usb_sdmmc.c`.
+    /// @note Once the session completes, the host buffer contains the value of `SD_TRANSFER`, the command response and the value of `SD_STAT1`
+    ///       starting at the offset where the response to the first operation enqueued by this function is stored.
+    ///       The caller should invoke `loadSDCommandResponse()` to verify the transfer status and fetch the response.
+    /// @warning This function is valid only when there is an active transfer session.
+    ///          i.e. The caller should invoke this function in between `Controller::beginCommandTransfer()` and `Controller::endCommandTransfer()`.
+    ///
+    IOReturn enqueueSDCommand(IOSDHostCommand& command);
+    
+    ///
+    /// [Shared] [Helper] Verify the transfer status and load the response of the given SD command from the host buffer
+    ///
+    /// @param command The SD command that has been sent via `enqueueSDCommand()`
+    /// @param offset The offset in the host buffer where the value of `SD_TRANSFER` enqueued by `enqueueSDCommand()` is stored
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function is refactored from `sd_send_cmd_get_rsp()` defined in `rtsx_pci/usb_sdmmc.c`.
+    /// @note This function checks whether the start and the transmission bits and the CRC7 checksum in the response are valid.
+    ///
+    IOReturn loadSDCommandResponse(IOSDHostCommand& command, IOByteCount offset);
+    
+    ///
+    /// [Case 3] [Shared] Invoked when the DMA transfer of a block request completes
+    ///
+    /// @param parameter The status of the transfer passed to `RealtekCardReaderController::waitForDMATransfer()`
+    /// @param status The final status of the transfer
+    /// @note This function runs in a gated context.
+    ///
+    void onDMATransferCompletion(void* parameter, IOReturn status);
+    
+    ///
+    /// [Case 3] [Shared] Send a SD command along with a DMA transfer
+    ///
+    /// @param request A block-oriented data transfer request to service
+    /// @param direction `kIODirectionIn` if the host reads blocks from the card, `kIODirectionOut` if the host writes blocks to the card
+    /// @param preCommands An array of SD commands to be sent before the data transfer command (e.g., CMD23 or CMD55 + ACMD23)
+    /// @param numPreCommands The number of commands in the given array
+    /// @param stopCommand A nullable STOP command to be sent once the data transfer completes
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note Port: This function replaces `sd_read_long_data()` and `sd_write_long_data()` defined in `rtsx_pci_sdmmc.c`.
+    /// @note Commands that precede the data transfer command are sent in the same session as the data transfer command.
+    /// @note By default, the data transfer command is sent by the card reader as part of the data transfer (i.e. `kTMAutoRead2` and `kTMAutoWrite2`),
+    ///       so that preceding commands, the data transfer command and the DMA transfer complete in a single host command transfer session.
+    ///       The boot argument `-rtsxscdt` restores the behavior of sending the data transfer command in a separate session.
+    /// @note If the STOP command is given, it is queued in the same host command transfer session as the data transfer,
+    ///       so the card reader sends it right after the data transfer completes, saving a separate session.
+    ///       The caller must pass `nullptr` if the controller cannot queue commands after a DMA transfer.
+    /// @seealso `RealtekCardReaderController::canQueueCommandsAfterDMATransfer()`.
+    /// @note The DMA transfer times out after the amount of time derived from the card parameters by the host driver,
+    ///       or after 10 seconds if the request does not specify one.
+    /// @note If a command sent in the same session fails before the data transfer (e.g. no response or a CRC error),
+    ///       the controller aborts the DMA transfer as soon as it learns the failure instead of waiting for the timeout.
+    ///       PCIe-based controllers learn it from the transfer failure interrupt, as `sd_read_long_data()` does,
+    ///       while USB-based controllers only learn it from the response loaded after the transfer.
+    ///
+    IOReturn runSDCommandWithDMATransfer(IOSDSingleBlockRequest& request, IODirection direction, IOSDHostCommand* preCommands, IOItemCount numPreCommands, IOSDHostCommand* stopCommand);
+    
+    ///
+    /// [Case 3] [Shared] Send a SD command along with a DMA transfer that accesses multiple blocks and then stop the transmission
+    ///
+    /// @param request A block-oriented data transfer request to service
+    /// @param direction `kIODirectionIn` if the host reads blocks from the card, `kIODirectionOut` if the host writes blocks to the card
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note The STOP command is queued in the same host command transfer session as the data transfer if the controller supports it.
+    ///       Otherwise, or if the data transfer fails, the STOP command is sent in a separate session.
+    /// @note The STOP command is not sent if the request uses a predefined transfer mode (i.e. CMD23) and the data transfer succeeds.
+    ///
+    IOReturn runSDCommandWithMultiBlocksDMATransfer(IOSDMultiBlocksRequest& request, IODirection direction);
  
 public:
     ///
@@ -117,6 +200,19 @@ public:
     ///
     IOReturn runSDCommand(IOSDHostCommand& command, UInt32 timeout = 100);
     
+    ///
+    /// [Case 1] Send a sequence of SD commands in a single session and wait for their responses
+    ///
+    /// @param preCommands An array of SD commands to be sent before the given command
+    /// @param numPreCommands The number of commands in the given array
+    /// @param command The last SD command to be sent
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note This function checks whether the start and the transmission bits and the CRC7 checksum in each response are valid.
+    /// @note The card reader stops executing the remaining commands once it fails to send a command,
+    ///       so subsequent commands are never sent to the card if a previous one fails.
+    ///
+    IOReturn runSDCommandSequence(IOSDHostCommand* preCommands, IOItemCount numPreCommands, IOSDHostCommand& command);
+    
     ///
     /// [Case 1] Send a SD command and wait for the response
     ///
@@ -458,6 +554,60 @@ public:
     DEPRECATE("Need further investigation. Will be replaced by Controller::isCardDataLineBusy().")
     IOReturn isCardDataLineBusy(bool& result) override;
     
+    //
+    // MARK: - Transfer Statistics
+    //
+    
+    ///
+    /// Get the counters of the work performed by the host device
+    ///
+    /// @param counters The counters on return
+    ///
+    void getTransferCounters(TransferCounters& counters) override;
+    
+    //
+    // MARK: - Request Pipelining
+    //
+    
+    ///
+    /// Prepare the DMA transfer of the given memory descriptor ahead of time
+    ///
+    /// @param descriptor A non-null memory descriptor of the next pending block request
+    /// @return `kIOReturnSuccess` on success, `kIOReturnUnsupported` if the controller cannot prepare a DMA transfer ahead of time.
+    ///
+    IOReturn prepareDMATransferAhead(IOMemoryDescriptor* descriptor) override;
+    
+    ///
+    /// Release the DMA transfer of the given memory descriptor if it has been prepared ahead of time but not performed yet
+    ///
+    /// @param descriptor A non-null memory descriptor of a block request that has been serviced
+    ///
+    void discardDMATransferAhead(IOMemoryDescriptor* descriptor) override;
+    
+    //
+    // MARK: - Card Events
+    //
+    
+    ///
+    /// [UPCALL] Notify the host device when a SD card is inserted
+    ///
+    /// @param completion A nullable completion routine to be invoked when the card is attached
+    /// @param options An optional value passed to the host driver
+    /// @note This callback function runs in a gated context provided by the underlying card reader controller.
+    ///       The host device should implement this function without any blocking operations.
+    ///
+    void onSDCardInsertedGated(IOSDCard::Completion* completion = nullptr, IOSDCard::EventOptions options = 0) override;
+    
+    ///
+    /// [UPCALL] Notify the host device when a SD card is removed
+    ///
+    /// @param completion A nullable completion routine to be invoked when the card is detached
+    /// @param options An optional value passed to the host driver
+    /// @note This callback function runs in a gated context provided by the underlying card reader controller.
+    ///       The host device should implement this function without any blocking operations.
+    ///
+    void onSDCardRemovedGated(IOSDCard::Completion* completion = nullptr, IOSDCard::EventOptions options = 0) override;
+    
     //
     // MARK: - Manage Initial Modes
     //
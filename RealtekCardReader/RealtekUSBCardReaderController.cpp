@@ -220,6 +220,8 @@ IOReturn RealtekUSBCardReaderController::readChipRegister(UInt16 address, UInt8&
         { address },
     };
     
+    this->transferCounters.numRegisterAccesses += 1;
+    
     IOReturn retVal = this->transferReadRegisterCommands(SimpleRegValuePairs(pairs), 100, Packet::Flags::kCR);
     
     if (retVal != kIOReturnSuccess)
@@ -250,6 +252,8 @@ IOReturn RealtekUSBCardReaderController::writeChipRegister(UInt16 address, UInt8
         { address, mask, value },
     };
     
+    this->transferCounters.numRegisterAccesses += 1;
+    
     return this->transferWriteRegisterCommands(SimpleRegValuePairs(pairs), 100, Packet::Flags::kC);
 }
 
@@ -388,14 +392,39 @@ IOReturn RealtekUSBCardReaderController::writeChipRegistersSequentially(UInt16 a
         return this->writeChipRegistersSequentially(address, count, reinterpret_cast<UInt8*>(bufferDescriptor->getBytesNoCopy()));
     }
     
-    // The controller must use an intermediate buffer
-    // Memory Descriptor -> Intermediate Buffer -> USB Endpoint
-    auto action = [&](const UInt8* buffer) -> IOReturn
+    // Guard: The host buffer must be able to hold the packet and the registers value
+    if (count > kHostBufferSize - Offset::kSeqRegsVal)
+    {
+        perr("The number of registers to write (%u) exceeds the capacity of the host buffer.", count);
+        
+        return kIOReturnBadArgument;
+    }
+    
+    // The registers value are copied from the given descriptor to the host buffer directly
+    // Memory Descriptor -> Host Buffer -> USB Endpoint
+    auto action = [&]() -> IOReturn
     {
-        return this->writeChipRegistersSequentially(address, count, buffer);
+        // Create the packet for writing registers sequentially and write it to the host buffer
+        this->writePacketToHostBufferGated(Packet::forSeqWriteCommand(count));
+        
+        // Set the starting register address in the host buffer
+        this->writeHostBufferValueGated(Offset::kHostCmdOff, OSSwapHostToBigInt16(address));
+        
+        // Copy the registers value to the host buffer
+        auto registers = reinterpret_cast<UInt8*>(this->hostBufferDescriptor->getBytesNoCopy()) + Offset::kSeqRegsVal;
+        
+        if (source->readBytes(0, registers, count) != count)
+        {
+            perr("Failed to copy the registers value to the host buffer.");
+            
+            return kIOReturnError;
+        }
+        
+        // Initiate the bulk transfer
+        return this->performOutboundBulkTransfer(this->hostBufferDescriptor, Offset::kSeqRegsVal + count, 100);
     };
     
-    return IOMemoryDescriptorWithIntermediateSourceBuffer(source, 0, count, action);
+    return IOCommandGateRunAction(this->commandGate, action);
 }
 
 ///
@@ -596,6 +625,9 @@ IOReturn RealtekUSBCardReaderController::enqueueCommandGated(const Command& comm
 ///             which makes the host device implementation independent of the card reader controller as much as possible.
 /// @note This function sends all commands in the queue to the device and initiates an inbound bulk transfer
 ///       if and only if the current transfer session contains at least one read or check register command.
+/// @note By default, the inbound bulk transfer is queued before the outbound one is initiated,
+///       so the card reader can return the response as soon as it has executed the host commands.
+///       The boot argument `-rtsxscrt` restores the behavior of initiating the inbound transfer after the outbound one completes.
 /// @note This function runs in a gated context.
 ///
 IOReturn RealtekUSBCardReaderController::endCommandTransferGated(UInt32 timeout, UInt32 flags)
@@ -605,9 +637,17 @@ IOReturn RealtekUSBCardReaderController::endCommandTransferGated(UInt32 timeout,
     
     this->writePacketToHostBufferGated(Packet::forBatchCommand(ncmds, static_cast<Packet::Flags>(flags & 0xFF)));
     
-    // Initiate the outbound bulk transfer to send the host commands
     UInt32 nbytes = Offset::kHostCmdOff + ncmds * sizeof(Command);
     
+    // Check whether the controller can overlap the command and the response transfers
+    IOByteCount plength = align(this->hostCommandCounter.getResponseLength(), 4ULL);
+    
+    if (plength != 0 && plength <= kTransferBufferSize && !UserConfigs::UCR::SerializeCommandAndResponseTransfers)
+    {
+        return this->performPipelinedCommandTransferGated(nbytes, plength, timeout);
+    }
+    
+    // Initiate the outbound bulk transfer to send the host commands
     IOReturn retVal = this->performOutboundBulkTransfer(this->hostBufferDescriptor, nbytes, timeout);
     
     if (retVal != kIOReturnSuccess)
@@ -633,6 +673,175 @@ IOReturn RealtekUSBCardReaderController::endCommandTransferGated(UInt32 timeout,
     return this->performInboundBulkTransfer(this->hostBufferDescriptor, align(rlength, 4ULL), timeout);
 }
 
+///
+/// [Helper] Send the host commands and load the response with overlapped bulk transfers
+///
+/// @param clength The number of bytes in the host buffer to send
+/// @param rlength The number of bytes of the response
+/// @param timeout Specify the amount of time in milliseconds
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note This function queues the inbound bulk transfer on the preallocated inbound transfer buffer
+///       before it sends the host commands, and copies the response to the host buffer once both transfers complete.
+/// @note Both bulk transfers are asynchronous, so the gate is released while this function waits for their completion.
+/// @note This function runs in a gated context.
+///
+IOReturn RealtekUSBCardReaderController::performPipelinedCommandTransferGated(IOByteCount clength, IOByteCount rlength, UInt32 timeout)
+{
+    pinfo("Sending %llu bytes of host commands and loading %llu bytes of response with overlapped bulk transfers...", clength, rlength);
+    
+    timeout = max(timeout, 600);
+    
+    // Queue the inbound bulk transfer first
+    // The card reader does not return the response until it has received and executed the host commands
+    this->pipelinedTransferStatus = kIOReturnSuccess;
+    
+    this->responseTransferLength = static_cast<UInt32>(rlength);
+    
+    this->responseTransferStatus = kIOReturnNotReady;
+    
+    IOReturn retVal = this->inputPipe->io(this->inboundTransferBuffer, this->responseTransferLength, &this->responseTransferCompletion, timeout);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to queue the inbound bulk transfer. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    // Send the host commands
+    // The outbound bulk transfer is asynchronous as well, since both completion routines need the gate
+    // Stalls are not retried here, because clearing the error requires the inbound pipe to be idle
+    this->commandTransferLength = static_cast<UInt32>(clength);
+    
+    this->commandTransferStatus = kIOReturnNotReady;
+    
+    retVal = this->outputPipe->io(this->hostBufferDescriptor, this->commandTransferLength, &this->commandTransferCompletion, timeout);
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to queue the outbound bulk transfer. Error = 0x%x.", retVal);
+        
+        this->commandTransferStatus = retVal;
+        
+        this->pipelinedTransferStatus = retVal;
+    }
+    
+    // Wait until both bulk transfers complete
+    // The card reader never returns the response if it has not received the host commands
+    bool aborted = false;
+    
+    while (this->commandTransferStatus == kIOReturnNotReady || this->responseTransferStatus == kIOReturnNotReady)
+    {
+        if (this->commandTransferStatus != kIOReturnNotReady && this->commandTransferStatus != kIOReturnSuccess && !aborted)
+        {
+            perr("Failed to send the host commands to the device. Error = 0x%x. Aborting the inbound bulk transfer...", this->commandTransferStatus);
+            
+            psoftassert(this->inputPipe->abort(IOUSBHostPipe::kAbortAsynchronous, kIOReturnAborted) == kIOReturnSuccess,
+                        "Failed to abort the inbound bulk transfer.");
+            
+            aborted = true;
+            
+            continue;
+        }
+        
+        this->commandGate->commandSleep(&this->pipelinedTransferStatus);
+    }
+    
+    retVal = this->pipelinedTransferStatus;
+    
+    // Guard: Clear the stall status once both pipes are idle
+    if (retVal == kUSBHostReturnPipeStalled)
+    {
+        perr("The pipe is stalled. Will clear the stall status.");
+        
+        psoftassert(this->inputPipe->clearStall(true) == kIOReturnSuccess, "Failed to clear the stall status of the inbound pipe.");
+        
+        psoftassert(this->outputPipe->clearStall(true) == kIOReturnSuccess, "Failed to clear the stall status of the outbound pipe.");
+        
+        this->clearError();
+        
+        return retVal;
+    }
+    
+    if (retVal != kIOReturnSuccess)
+    {
+        perr("Failed to send the host commands or to load the response. Error = 0x%x.", retVal);
+        
+        return retVal;
+    }
+    
+    // Copy the response to the host buffer
+    memcpy(this->hostBufferDescriptor->getBytesNoCopy(), this->inboundTransferBuffer->getBytesNoCopy(), rlength);
+    
+    return kIOReturnSuccess;
+}
+
+///
+/// [Completion] Invoked when the inbound bulk transfer queued by `performPipelinedCommandTransferGated()` completes
+///
+/// @param parameter An opaque client-supplied parameter pointer
+/// @param status `kIOReturnSuccess` if the transfer has succeeded, other values otherwise
+/// @param bytesTransferred The actual number of bytes transferred
+///
+void RealtekUSBCardReaderController::onResponseTransferCompletion(void* parameter, IOReturn status, UInt32 bytesTransferred)
+{
+    auto action = [&]() -> IOReturn
+    {
+        if (status == kIOReturnSuccess && bytesTransferred != this->responseTransferLength)
+        {
+            perr("The number of bytes transferred (%u) is not identical to the requested one (%u).", bytesTransferred, this->responseTransferLength);
+            
+            status = kIOReturnError;
+        }
+        
+        this->responseTransferStatus = status;
+        
+        if (this->pipelinedTransferStatus == kIOReturnSuccess)
+        {
+            this->pipelinedTransferStatus = status;
+        }
+        
+        this->commandGate->commandWakeup(&this->pipelinedTransferStatus);
+        
+        return kIOReturnSuccess;
+    };
+    
+    IOCommandGateRunAction(this->commandGate, action);
+}
+
+///
+/// [Completion] Invoked when the outbound bulk transfer queued by `performPipelinedCommandTransferGated()` completes
+///
+/// @param parameter An opaque client-supplied parameter pointer
+/// @param status `kIOReturnSuccess` if the transfer has succeeded, other values otherwise
+/// @param bytesTransferred The actual number of bytes transferred
+///
+void RealtekUSBCardReaderController::onCommandTransferCompletion(void* parameter, IOReturn status, UInt32 bytesTransferred)
+{
+    auto action = [&]() -> IOReturn
+    {
+        if (status == kIOReturnSuccess && bytesTransferred != this->commandTransferLength)
+        {
+            perr("The number of bytes transferred (%u) is not identical to the requested one (%u).", bytesTransferred, this->commandTransferLength);
+            
+            status = kIOReturnError;
+        }
+        
+        this->commandTransferStatus = status;
+        
+        if (this->pipelinedTransferStatus == kIOReturnSuccess)
+        {
+            this->pipelinedTransferStatus = status;
+        }
+        
+        this->commandGate->commandWakeup(&this->pipelinedTransferStatus);
+        
+        return kIOReturnSuccess;
+    };
+    
+    IOCommandGateRunAction(this->commandGate, action);
+}
+
 ///
 /// Finish the existing host command transfer session without waiting for the response
 ///
@@ -696,7 +905,9 @@ IOReturn RealtekUSBCardReaderController::loadCommandTransferResponseGated(UInt32
 ///
 IOReturn RealtekUSBCardReaderController::performDMARead(IOMemoryDescriptor* descriptor, UInt32 timeout)
 {
-    return this->performInboundBulkTransfer(descriptor, descriptor->getLength(), timeout);
+    this->transferCounters.numDMATransfers += 1;
+    
+    return this->performConcurrentBulkTransfer(this->inputPipe, descriptor, descriptor->getLength(), timeout);
 }
 
 ///
@@ -708,7 +919,9 @@ IOReturn RealtekUSBCardReaderController::performDMARead(IOMemoryDescriptor* desc
 ///
 IOReturn RealtekUSBCardReaderController::performDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout)
 {
-    return this->performOutboundBulkTransfer(descriptor, descriptor->getLength(), timeout);
+    this->transferCounters.numDMATransfers += 1;
+    
+    return this->performConcurrentBulkTransfer(this->outputPipe, descriptor, descriptor->getLength(), timeout);
 }
 
 //
@@ -1667,6 +1880,224 @@ IOReturn RealtekUSBCardReaderController::performBulkTransfer(IOUSBHostPipe* pipe
     return IOCommandGateRunAction(this->commandGate, action);
 }
 
+///
+/// [Completion] Invoked when a bulk transfer queued by `performConcurrentBulkTransferGated()` completes
+///
+/// @param parameter The bulk transfer that has completed
+/// @param status `kIOReturnSuccess` if the transfer has succeeded, other values otherwise
+/// @param bytesTransferred The actual number of bytes transferred
+///
+void RealtekUSBCardReaderController::onBulkTransferCompletion(void* parameter, IOReturn status, UInt32 bytesTransferred)
+{
+    auto action = [&]() -> IOReturn
+    {
+        auto transfer = reinterpret_cast<BulkTransfer*>(parameter);
+        
+        BulkTransferSession* session = transfer->session;
+        
+        if (status == kIOReturnSuccess && bytesTransferred != transfer->length)
+        {
+            perr("The number of bytes transferred (%u) is not identical to the requested one (%u).", bytesTransferred, transfer->length);
+            
+            status = kIOReturnError;
+        }
+        
+        // Keep the status of the first bulk transfer that has failed
+        if (status != kIOReturnSuccess && session->status == kIOReturnSuccess)
+        {
+            session->status = status;
+        }
+        
+        // Release the chunk
+        psoftassert(transfer->descriptor->complete() == kIOReturnSuccess, "Failed to complete the chunk.");
+        
+        OSSafeReleaseNULL(transfer->descriptor);
+        
+        // Wake up the thread that performs the DMA transfer
+        session->numInFlight -= 1;
+        
+        this->commandGate->commandWakeup(session);
+        
+        return kIOReturnSuccess;
+    };
+    
+    IOCommandGateRunAction(this->commandGate, action);
+}
+
+///
+/// [Helper] Perform a data transfer on the bulk endpoint by queuing multiple bulk transfers concurrently
+///
+/// @param pipe The bulk endpoint
+/// @param buffer A prepared memory descriptor that contains the data of interest
+/// @param length The total number of bytes to transfer
+/// @param timeout Specify the amount of time in milliseconds
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @note This function splits the transfer into chunks of `BulkTransferChunkSize` bytes
+///       and keeps up to `MaxNumOutstandingBulkTransfers` of them queued on the pipe,
+///       so that the bus does not idle between two consecutive bulk transfers.
+/// @note This function falls back to `performBulkTransferGated()` if the transfer fits in a single chunk,
+///       and retries the whole transfer with `performBulkTransferGated()` if the pipe is stalled.
+/// @note This function runs in a gated context.
+///
+IOReturn RealtekUSBCardReaderController::performConcurrentBulkTransferGated(IOUSBHostPipe* pipe, IOMemoryDescriptor* buffer, IOByteCount length, UInt32 timeout)
+{
+    IOByteCount chunkSize = UserConfigs::UCR::BulkTransferChunkSize;
+    
+    IOItemCount depth = min(UserConfigs::UCR::MaxNumOutstandingBulkTransfers, kMaxNumOutstandingBulkTransfers);
+    
+    // Guard: Check whether the transfer is worth splitting
+    if (depth <= 1 || length <= chunkSize)
+    {
+        return this->performBulkTransferGated(pipe, buffer, length, timeout);
+    }
+    
+    pinfo("Initiating a bulk transfer with length = %llu bytes in chunks of %llu bytes and timeout = %u ms...", length, chunkSize, timeout);
+    
+    timeout = max(timeout, 600);
+    
+    auto handler = OSMemberFunctionCast(IOUSBHostCompletionAction, this, &RealtekUSBCardReaderController::onBulkTransferCompletion);
+    
+    BulkTransferSession session;
+    
+    bzero(&session, sizeof(BulkTransferSession));
+    
+    for (IOItemCount index = 0; index < depth; index += 1)
+    {
+        session.transfers[index].session = &session;
+        
+        session.transfers[index].completion = { this, handler, &session.transfers[index] };
+    }
+    
+    // Keep the pipe busy until all chunks have been transferred or a chunk has failed
+    IOByteCount offset = 0;
+    
+    IOItemCount next = 0;
+    
+    bool aborted = false;
+    
+    while (true)
+    {
+        while (session.status == kIOReturnSuccess && session.numInFlight < depth && offset < length)
+        {
+            // The ring guarantees that the next transfer is not in flight
+            BulkTransfer& transfer = session.transfers[next];
+            
+            passert(transfer.descriptor == nullptr, "The next bulk transfer should not be in flight.");
+            
+            transfer.length = static_cast<UInt32>(min(chunkSize, length - offset));
+            
+            transfer.descriptor = IOSubMemoryDescriptor::withSubRange(buffer, offset, transfer.length, buffer->getDirection());
+            
+            if (transfer.descriptor == nullptr)
+            {
+                perr("Failed to create the descriptor for the chunk at offset %llu.", offset);
+                
+                session.status = kIOReturnNoMemory;
+                
+                break;
+            }
+            
+            IOReturn retVal = transfer.descriptor->prepare();
+            
+            if (retVal != kIOReturnSuccess)
+            {
+                perr("Failed to prepare the chunk at offset %llu. Error = 0x%x.", offset, retVal);
+                
+                OSSafeReleaseNULL(transfer.descriptor);
+                
+                session.status = retVal;
+                
+                break;
+            }
+            
+            session.numInFlight += 1;
+            
+            retVal = pipe->io(transfer.descriptor, transfer.length, &transfer.completion, timeout);
+            
+            if (retVal != kIOReturnSuccess)
+            {
+                perr("Failed to queue the bulk transfer at offset %llu. Error = 0x%x.", offset, retVal);
+                
+                psoftassert(transfer.descriptor->complete() == kIOReturnSuccess, "Failed to complete the chunk.");
+                
+                OSSafeReleaseNULL(transfer.descriptor);
+                
+                session.numInFlight -= 1;
+                
+                session.status = retVal;
+                
+                break;
+            }
+            
+            offset += transfer.length;
+            
+            next = (next + 1) % depth;
+        }
+        
+        // Guard: Check whether all bulk transfers have completed
+        if (session.numInFlight == 0)
+        {
+            break;
+        }
+        
+        // Guard: Cancel the remaining bulk transfers once a bulk transfer has failed
+        if (session.status != kIOReturnSuccess && !aborted)
+        {
+            perr("A bulk transfer has failed. Aborting the remaining ones... Error = 0x%x.", session.status);
+            
+            psoftassert(pipe->abort(IOUSBHostPipe::kAbortAsynchronous, kIOReturnAborted) == kIOReturnSuccess,
+                        "Failed to abort the remaining bulk transfers.");
+            
+            aborted = true;
+        }
+        
+        this->commandGate->commandSleep(&session);
+    }
+    
+    // Guard: Retry the whole transfer if the pipe is stalled
+    if (session.status == kUSBHostReturnPipeStalled)
+    {
+        perr("The given pipe is stalled. Will clear the stall status and retry the transfer.");
+        
+        psoftassert(pipe->clearStall(true) == kIOReturnSuccess, "Failed to clear the stall status.");
+        
+        this->clearError();
+        
+        return this->performBulkTransferGated(pipe, buffer, length, timeout);
+    }
+    
+    if (session.status != kIOReturnSuccess)
+    {
+        perr("Failed to complete the bulk transfer. Error = 0x%x.", session.status);
+    }
+    else
+    {
+        pinfo("The bulk transfer completed successfully.");
+    }
+    
+    return session.status;
+}
+
+///
+/// [Helper] Perform a data transfer on the bulk endpoint by queuing multiple bulk transfers concurrently
+///
+/// @param pipe The bulk endpoint
+/// @param buffer A prepared memory descriptor that contains the data of interest
+/// @param length The total number of bytes to transfer
+/// @param timeout Specify the amount of time in milliseconds
+/// @return `kIOReturnSuccess` on success, other values otherwise.
+/// @seealso `performConcurrentBulkTransferGated()`.
+///
+IOReturn RealtekUSBCardReaderController::performConcurrentBulkTransfer(IOUSBHostPipe* pipe, IOMemoryDescriptor* buffer, IOByteCount length, UInt32 timeout)
+{
+    auto action = [&]() -> IOReturn
+    {
+        return this->performConcurrentBulkTransferGated(pipe, buffer, length, timeout);
+    };
+    
+    return IOCommandGateRunAction(this->commandGate, action);
+}
+
 ///
 /// Perform an inbound transfer on the bulk endpoint
 ///
@@ -1680,6 +2111,29 @@ IOReturn RealtekUSBCardReaderController::performBulkTransfer(IOUSBHostPipe* pipe
 ///
 IOReturn RealtekUSBCardReaderController::performInboundBulkTransfer(void* buffer, IOByteCount length, UInt32 timeout)
 {
+    // Check whether the controller can use the preallocated transfer buffer
+    if (length <= kTransferBufferSize)
+    {
+        auto action = [&]() -> IOReturn
+        {
+            IOReturn retVal = this->performBulkTransferGated(this->inputPipe, this->inboundTransferBuffer, length, timeout);
+            
+            if (retVal != kIOReturnSuccess)
+            {
+                perr("Failed to complete the inbound bulk transfer. Error = 0x%x.", retVal);
+                
+                return retVal;
+            }
+            
+            memcpy(buffer, this->inboundTransferBuffer->getBytesNoCopy(), length);
+            
+            return kIOReturnSuccess;
+        };
+        
+        return IOCommandGateRunAction(this->commandGate, action);
+    }
+    
+    // The transfer is too large, so the controller must allocate an intermediate buffer
     auto action = [&](IOUSBHostInterface* interface, IOMemoryDescriptor* descriptor) -> IOReturn
     {
         IOReturn retVal = this->performInboundBulkTransfer(descriptor, length, timeout);
@@ -1712,6 +2166,20 @@ IOReturn RealtekUSBCardReaderController::performInboundBulkTransfer(void* buffer
 ///
 IOReturn RealtekUSBCardReaderController::performOutboundBulkTransfer(const void* buffer, IOByteCount length, UInt32 timeout)
 {
+    // Check whether the controller can use the preallocated transfer buffer
+    if (length <= kTransferBufferSize)
+    {
+        auto action = [&]() -> IOReturn
+        {
+            memcpy(this->outboundTransferBuffer->getBytesNoCopy(), buffer, length);
+            
+            return this->performBulkTransferGated(this->outputPipe, this->outboundTransferBuffer, length, timeout);
+        };
+        
+        return IOCommandGateRunAction(this->commandGate, action);
+    }
+    
+    // The transfer is too large, so the controller must allocate an intermediate buffer
     auto action = [&](IOUSBHostInterface* interface, IOMemoryDescriptor* descriptor) -> IOReturn
     {
         passert(descriptor->writeBytes(0, buffer, length) == length, "Should be able to write to the intermediate buffer.");
@@ -2061,7 +2529,7 @@ void RealtekUSBCardReaderController::resumePollingThread()
     {
         this->timer->enable();
         
-        this->timer->setTimeoutMS(UserConfigs::UCR::DeviceStatusPollingInterval);
+        this->timer->setTimeoutMS(this->deviceStatusPollingInterval);
         
         return kIOReturnSuccess;
     };
@@ -2092,6 +2560,70 @@ void RealtekUSBCardReaderController::onSDCardEventProcessedCompletion(void* para
     this->resumePollingThread();
 }
 
+///
+/// [Helper] Check whether the polling thread should skip fetching the device status and back off
+///
+/// @return `true` if the host has transferred data since the last run and the polling interval has not reached its maximum,
+///         `false` otherwise.
+/// @note This function updates the interval until the next run of the polling thread.
+/// @note This function runs in a gated context.
+///
+bool RealtekUSBCardReaderController::shouldSkipFetchingDeviceStatusGated()
+{
+    // Guard: The interval is fixed unless the adaptive polling is enabled
+    if (!UserConfigs::UCR::AdaptiveDeviceStatusPolling)
+    {
+        return false;
+    }
+    
+    // Guard: Check whether the host has transferred data since the last run
+    UInt64 numDMATransfers = this->transferCounters.numDMATransfers;
+    
+    if (numDMATransfers == this->deviceStatusPollingDMATransfers)
+    {
+        // The bus is idle, so poll at the highest rate
+        this->deviceStatusPollingInterval = UserConfigs::UCR::DeviceStatusPollingIntervalIdle;
+        
+        return false;
+    }
+    
+    this->deviceStatusPollingDMATransfers = numDMATransfers;
+    
+    // Guard: Fetch the device status anyway once the interval reaches its maximum,
+    //        so that the driver still notices the card removal while the host is busy
+    if (this->deviceStatusPollingInterval >= UserConfigs::UCR::DeviceStatusPollingIntervalBusy)
+    {
+        return false;
+    }
+    
+    // The bus is busy, so back off to avoid competing with data transfers
+    this->deviceStatusPollingInterval = min(this->deviceStatusPollingInterval * 2, UserConfigs::UCR::DeviceStatusPollingIntervalBusy);
+    
+    return true;
+}
+
+///
+/// [Helper] Publish the polling statistics in the I/O Registry
+///
+/// @param force `true` if the statistics should be published regardless of the number of runs of the polling thread
+/// @note The statistics are published once every `kNumDeviceStatusPollsPerPublish` runs unless `force` is `true`,
+///       since updating the I/O Registry on every run costs more than fetching the device status itself.
+/// @note This function runs in a gated context.
+///
+void RealtekUSBCardReaderController::publishDeviceStatusPollingStatisticsGated(bool force)
+{
+    if (!force && (this->numDeviceStatusPolls + this->numDeviceStatusPollsSkipped) % kNumDeviceStatusPollsPerPublish != 0)
+    {
+        return;
+    }
+    
+    psoftassert(this->setProperty("Device Status Polls", this->numDeviceStatusPolls, 64),
+                "Failed to update the number of device status polls.");
+    
+    psoftassert(this->setProperty("Device Status Polls Skipped", this->numDeviceStatusPollsSkipped, 64),
+                "Failed to update the number of device status polls skipped.");
+}
+
 ///
 /// Fetch the device status periodically
 ///
@@ -2100,6 +2632,23 @@ void RealtekUSBCardReaderController::onSDCardEventProcessedCompletion(void* para
 ///
 void RealtekUSBCardReaderController::fetchDeviceStatusGated(IOTimerEventSource* sender)
 {
+    // Check whether the host is busy transferring data
+    if (this->shouldSkipFetchingDeviceStatusGated())
+    {
+        pinfo("The host is transferring data. Will fetch the device status in %u ms.", this->deviceStatusPollingInterval);
+        
+        this->numDeviceStatusPollsSkipped += 1;
+        
+        this->publishDeviceStatusPollingStatisticsGated(false);
+        
+        if (!this->isInactive())
+        {
+            sender->setTimeoutMS(this->deviceStatusPollingInterval);
+        }
+        
+        return;
+    }
+    
     // -------------------------
     // | Before | Now | Action |
     // -------------------------
@@ -2117,9 +2666,14 @@ void RealtekUSBCardReaderController::fetchDeviceStatusGated(IOTimerEventSource*
     
     bool isCardPresentNow = this->isCardPresent();
     
+    // Count the number of polls so that users can measure the bus overhead
+    this->numDeviceStatusPolls += 1;
+    
     // Check whether the driver should take action to process the card event
     if (this->isCardPresentBefore ^ isCardPresentNow)
     {
+        this->publishDeviceStatusPollingStatisticsGated(true);
+        
         // Process the card event
         this->cardEventLock = 1;
         
@@ -2138,6 +2692,8 @@ void RealtekUSBCardReaderController::fetchDeviceStatusGated(IOTimerEventSource*
         return;
     }
     
+    this->publishDeviceStatusPollingStatisticsGated(false);
+    
     // Check whether the controller is terminated
     if (this->isInactive())
     {
@@ -2147,7 +2703,7 @@ void RealtekUSBCardReaderController::fetchDeviceStatusGated(IOTimerEventSource*
     }
     
     // Schedule the next action
-    sender->setTimeoutMS(UserConfigs::UCR::DeviceStatusPollingInterval);
+    sender->setTimeoutMS(this->deviceStatusPollingInterval);
 }
 
 //
@@ -2303,7 +2859,51 @@ bool RealtekUSBCardReaderController::setupHostBuffer()
     
     pinfo("The host buffer has been allocated.");
     
+    // Allocate the transfer buffers
+    pinfo("Allocating the transfer buffers...");
+    
+    this->inboundTransferBuffer = this->interface->createIOBuffer(kIODirectionIn, kTransferBufferSize);
+    
+    this->outboundTransferBuffer = this->interface->createIOBuffer(kIODirectionOut, kTransferBufferSize);
+    
+    if (this->inboundTransferBuffer == nullptr || this->outboundTransferBuffer == nullptr)
+    {
+        perr("Failed to allocate the transfer buffers.");
+        
+        goto error;
+    }
+    
+    // Page in and wire down the buffers
+    if (this->inboundTransferBuffer->prepare() != kIOReturnSuccess)
+    {
+        perr("Failed to wire down and page in the inbound transfer buffer.");
+        
+        goto error;
+    }
+    
+    if (this->outboundTransferBuffer->prepare() != kIOReturnSuccess)
+    {
+        perr("Failed to wire down and page in the outbound transfer buffer.");
+        
+        psoftassert(this->inboundTransferBuffer->complete() == kIOReturnSuccess, "Failed to complete the inbound transfer buffer.");
+        
+        goto error;
+    }
+    
+    pinfo("The transfer buffers have been allocated.");
+    
     return true;
+    
+error:
+    OSSafeReleaseNULL(this->inboundTransferBuffer);
+    
+    OSSafeReleaseNULL(this->outboundTransferBuffer);
+    
+    this->hostBufferDescriptor->complete();
+    
+    OSSafeReleaseNULL(this->hostBufferDescriptor);
+    
+    return false;
 }
 
 ///
@@ -2384,6 +2984,24 @@ void RealtekUSBCardReaderController::tearDownHostBuffer()
         
         this->hostBufferDescriptor = nullptr;
     }
+    
+    if (this->inboundTransferBuffer != nullptr)
+    {
+        this->inboundTransferBuffer->complete();
+        
+        this->inboundTransferBuffer->release();
+        
+        this->inboundTransferBuffer = nullptr;
+    }
+    
+    if (this->outboundTransferBuffer != nullptr)
+    {
+        this->outboundTransferBuffer->complete();
+        
+        this->outboundTransferBuffer->release();
+        
+        this->outboundTransferBuffer = nullptr;
+    }
 }
 
 ///
@@ -2467,6 +3085,10 @@ bool RealtekUSBCardReaderController::init(OSDictionary* dictionary)
     
     this->outputPipe = nullptr;
     
+    this->inboundTransferBuffer = nullptr;
+    
+    this->outboundTransferBuffer = nullptr;
+    
     this->timer = nullptr;
     
     this->isCardPresentBefore = false;
@@ -2479,8 +3101,42 @@ bool RealtekUSBCardReaderController::init(OSDictionary* dictionary)
     
     this->cardEventLock = 0;
     
+    this->deviceStatusPollingInterval = UserConfigs::UCR::AdaptiveDeviceStatusPolling ?
+                                        UserConfigs::UCR::DeviceStatusPollingIntervalIdle :
+                                        UserConfigs::UCR::DeviceStatusPollingInterval;
+    
+    this->deviceStatusPollingDMATransfers = 0;
+    
+    this->numDeviceStatusPolls = 0;
+    
+    this->numDeviceStatusPollsSkipped = 0;
+    
     this->cardEventCompletion = IOSDCard::Completion::withMemberFunction(this, &RealtekUSBCardReaderController::onSDCardEventProcessedCompletion);
     
+    this->responseTransferCompletion =
+    {
+        this,
+        OSMemberFunctionCast(IOUSBHostCompletionAction, this, &RealtekUSBCardReaderController::onResponseTransferCompletion),
+        nullptr
+    };
+    
+    this->responseTransferLength = 0;
+    
+    this->responseTransferStatus = kIOReturnSuccess;
+    
+    this->commandTransferCompletion =
+    {
+        this,
+        OSMemberFunctionCast(IOUSBHostCompletionAction, this, &RealtekUSBCardReaderController::onCommandTransferCompletion),
+        nullptr
+    };
+    
+    this->commandTransferLength = 0;
+    
+    this->commandTransferStatus = kIOReturnSuccess;
+    
+    this->pipelinedTransferStatus = kIOReturnSuccess;
+    
     return true;
 }
 
@@ -2556,7 +3212,15 @@ bool RealtekUSBCardReaderController::start(IOService* provider)
     this->setDeviceProperties();
     
     // Enable the polling timer
-    pinfo("User requests to poll for the device status every %u milliseconds.", UserConfigs::UCR::DeviceStatusPollingInterval);
+    if (UserConfigs::UCR::AdaptiveDeviceStatusPolling)
+    {
+        pinfo("User requests to poll for the device status every %u to %u milliseconds.",
+              UserConfigs::UCR::DeviceStatusPollingIntervalIdle, UserConfigs::UCR::DeviceStatusPollingIntervalBusy);
+    }
+    else
+    {
+        pinfo("User requests to poll for the device status every %u milliseconds.", UserConfigs::UCR::DeviceStatusPollingInterval);
+    }
     
     this->resumePollingThread();
     
@@ -9,6 +9,7 @@
 #define RealtekUSBCardReaderController_hpp
 
 #include <IOKit/IOTimerEventSource.h>
+#include <IOKit/IOSubMemoryDescriptor.h>
 #include "RealtekCardReaderController.hpp"
 #include "IOUSBHostDevice.hpp"
 #include "IOUSBHostInterface.hpp"
@@ -166,6 +167,23 @@ class RealtekUSBCardReaderController: public RealtekCardReaderController
     /// The host buffer can hold up to 254 commands
     static constexpr IOItemCount kMaxNumCommands = (kHostBufferSize - Offset::kHostCmdOff) / 4;
     
+    /// The size of each preallocated transfer buffer (by default 1024 bytes)
+    static constexpr IOByteCount kTransferBufferSize = 1024;
+    
+    //
+    // MARK: - Constants: Bulk Transfer
+    //
+    
+    /// The maximum number of bulk transfers in flight that belong to a single DMA transfer
+    static constexpr IOItemCount kMaxNumOutstandingBulkTransfers = 8;
+    
+    //
+    // MARK: - Constants: Device Status Polling
+    //
+    
+    /// The number of runs of the polling thread between two updates of the polling statistics in the I/O Registry
+    static constexpr UInt64 kNumDeviceStatusPollsPerPublish = 64;
+    
     //
     // MARK: - Data Structures (Private)
     //
@@ -345,6 +363,44 @@ class RealtekUSBCardReaderController: public RealtekCardReaderController
         kSDWriteProtected = 0x08,
     };
     
+    struct BulkTransferSession;
+    
+    ///
+    /// Represents a bulk transfer in flight that transfers a chunk of the data of a DMA transfer
+    ///
+    struct BulkTransfer
+    {
+        /// The session that owns this transfer
+        BulkTransferSession* session;
+        
+        /// A prepared memory descriptor that represents the chunk of data to transfer, `nullptr` if the transfer is not in flight
+        IOSubMemoryDescriptor* descriptor;
+        
+        /// The number of bytes to transfer
+        UInt32 length;
+        
+        /// The completion routine passed to the host pipe
+        IOUSBHostCompletion completion;
+    };
+    
+    ///
+    /// Represents a DMA transfer that is split into multiple bulk transfers queued on the same pipe
+    ///
+    /// @note The session lives on the stack of the thread that performs the DMA transfer,
+    ///       which waits until all bulk transfers of the session have completed.
+    ///
+    struct BulkTransferSession
+    {
+        /// A ring of bulk transfers
+        BulkTransfer transfers[kMaxNumOutstandingBulkTransfers];
+        
+        /// The number of bulk transfers in flight
+        IOItemCount numInFlight;
+        
+        /// The status of the first bulk transfer that has failed, `kIOReturnSuccess` otherwise
+        IOReturn status;
+    };
+    
     //
     // MARK: - IOKit Basics
     //
@@ -361,6 +417,21 @@ class RealtekUSBCardReaderController: public RealtekCardReaderController
     /// The output bulk pipe
     IOUSBHostPipe* outputPipe;
     
+    ///
+    /// A preallocated, prepared buffer that receives the data of inbound bulk transfers to a raw buffer
+    ///
+    /// @note The buffer is reused by every inbound bulk transfer no larger than `kTransferBufferSize` bytes,
+    ///       so that reading registers and the ping pong buffer does not allocate an intermediate buffer.
+    ///
+    IOBufferMemoryDescriptor* inboundTransferBuffer;
+    
+    ///
+    /// A preallocated, prepared buffer that provides the data of outbound bulk transfers from a raw buffer
+    ///
+    /// @note The buffer is reused by every outbound bulk transfer no larger than `kTransferBufferSize` bytes.
+    ///
+    IOBufferMemoryDescriptor* outboundTransferBuffer;
+    
     /// A timer that polls the device status every 100ms
     IOTimerEventSource* timer;
     
@@ -383,9 +454,42 @@ class RealtekUSBCardReaderController: public RealtekCardReaderController
     /// Non-zero if a card event is being processed thus the polling function should pause
     UInt32 cardEventLock;
     
+    /// The amount of time in milliseconds until the polling thread fetches the device status again
+    UInt32 deviceStatusPollingInterval;
+    
+    /// The number of DMA transfers observed by the polling thread when it last ran
+    UInt64 deviceStatusPollingDMATransfers;
+    
+    /// The number of times the polling thread has fetched the device status
+    UInt64 numDeviceStatusPolls;
+    
+    /// The number of times the polling thread has skipped fetching the device status because the host was transferring data
+    UInt64 numDeviceStatusPollsSkipped;
+    
     /// The completion descriptor that defines the callback routine when a card event has been processed
     IOSDCard::Completion cardEventCompletion;
     
+    /// The completion routine of the inbound bulk transfer that loads the response to a command transfer session
+    IOUSBHostCompletion responseTransferCompletion;
+    
+    /// The expected length of the response, in bytes
+    UInt32 responseTransferLength;
+    
+    /// The status of the inbound bulk transfer that loads the response, `kIOReturnNotReady` if the transfer is in flight
+    IOReturn responseTransferStatus;
+    
+    /// The completion routine of the outbound bulk transfer that sends the host commands of a pipelined command transfer session
+    IOUSBHostCompletion commandTransferCompletion;
+    
+    /// The number of bytes of host commands to send
+    UInt32 commandTransferLength;
+    
+    /// The status of the outbound bulk transfer that sends the host commands, `kIOReturnNotReady` if the transfer is in flight
+    IOReturn commandTransferStatus;
+    
+    /// The first error reported by either bulk transfer of a pipelined command transfer session
+    IOReturn pipelinedTransferStatus;
+    
     //
     // MARK: - Access Chip Registers (Common, Final)
     //
@@ -559,10 +663,45 @@ class RealtekUSBCardReaderController: public RealtekCardReaderController
     ///             which makes the host device implementation independent of the card reader controller as much as possible.
     /// @note This function sends all commands in the queue to the device and initiates an inbound bulk transfer
     ///       if and only if the current transfer session contains at least one read or check register command.
+    /// @note By default, the inbound bulk transfer is queued before the outbound one is initiated,
+    ///       so the card reader can return the response as soon as it has executed the host commands.
+    ///       The boot argument `-rtsxscrt` restores the behavior of initiating the inbound transfer after the outbound one completes.
     /// @note This function runs in a gated context.
     ///
     IOReturn endCommandTransferGated(UInt32 timeout, UInt32 flags) override final;
     
+    ///
+    /// [Helper] Send the host commands and load the response with overlapped bulk transfers
+    ///
+    /// @param clength The number of bytes in the host buffer to send
+    /// @param rlength The number of bytes of the response
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note This function queues the inbound bulk transfer on the preallocated inbound transfer buffer
+    ///       before it sends the host commands, and copies the response to the host buffer once both transfers complete.
+    /// @note Both bulk transfers are asynchronous, so the gate is released while this function waits for their completion.
+    /// @note This function runs in a gated context.
+    ///
+    IOReturn performPipelinedCommandTransferGated(IOByteCount clength, IOByteCount rlength, UInt32 timeout);
+    
+    ///
+    /// [Completion] Invoked when the outbound bulk transfer queued by `performPipelinedCommandTransferGated()` completes
+    ///
+    /// @param parameter An opaque client-supplied parameter pointer
+    /// @param status `kIOReturnSuccess` if the transfer has succeeded, other values otherwise
+    /// @param bytesTransferred The actual number of bytes transferred
+    ///
+    void onCommandTransferCompletion(void* parameter, IOReturn status, UInt32 bytesTransferred);
+    
+    ///
+    /// [Completion] Invoked when the inbound bulk transfer queued by `performPipelinedCommandTransferGated()` completes
+    ///
+    /// @param parameter An opaque client-supplied parameter pointer
+    /// @param status `kIOReturnSuccess` if the transfer has succeeded, other values otherwise
+    /// @param bytesTransferred The actual number of bytes transferred
+    ///
+    void onResponseTransferCompletion(void* parameter, IOReturn status, UInt32 bytesTransferred);
+    
     ///
     /// Finish the existing host command transfer session without waiting for the response
     ///
@@ -608,6 +747,16 @@ class RealtekUSBCardReaderController: public RealtekCardReaderController
     ///
     IOReturn performDMAWrite(IOMemoryDescriptor* descriptor, UInt32 timeout) override final;
     
+    ///
+    /// Check whether the controller can execute host commands queued after a DMA transfer in the same session
+    ///
+    /// @return `true` since the response to the host command list is loaded by a separate bulk transfer after the DMA transfer.
+    ///
+    inline bool canQueueCommandsAfterDMATransfer() override final
+    {
+        return true;
+    }
+    
     //
     // MARK: - Clear Error
     //
@@ -1004,6 +1153,44 @@ class RealtekUSBCardReaderController: public RealtekCardReaderController
     ///
     IOReturn performBulkTransfer(IOUSBHostPipe* pipe, IOMemoryDescriptor* buffer, IOByteCount length, UInt32 timeout, UInt32 retries = 3);
     
+    ///
+    /// [Completion] Invoked when a bulk transfer queued by `performConcurrentBulkTransferGated()` completes
+    ///
+    /// @param parameter The bulk transfer that has completed
+    /// @param status `kIOReturnSuccess` if the transfer has succeeded, other values otherwise
+    /// @param bytesTransferred The actual number of bytes transferred
+    ///
+    void onBulkTransferCompletion(void* parameter, IOReturn status, UInt32 bytesTransferred);
+    
+    ///
+    /// [Helper] Perform a data transfer on the bulk endpoint by queuing multiple bulk transfers concurrently
+    ///
+    /// @param pipe The bulk endpoint
+    /// @param buffer A prepared memory descriptor that contains the data of interest
+    /// @param length The total number of bytes to transfer
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @note This function splits the transfer into chunks of `BulkTransferChunkSize` bytes
+    ///       and keeps up to `MaxNumOutstandingBulkTransfers` of them queued on the pipe,
+    ///       so that the bus does not idle between two consecutive bulk transfers.
+    /// @note This function falls back to `performBulkTransferGated()` if the transfer fits in a single chunk,
+    ///       and retries the whole transfer with `performBulkTransferGated()` if the pipe is stalled.
+    /// @note This function runs in a gated context.
+    ///
+    IOReturn performConcurrentBulkTransferGated(IOUSBHostPipe* pipe, IOMemoryDescriptor* buffer, IOByteCount length, UInt32 timeout);
+    
+    ///
+    /// [Helper] Perform a data transfer on the bulk endpoint by queuing multiple bulk transfers concurrently
+    ///
+    /// @param pipe The bulk endpoint
+    /// @param buffer A prepared memory descriptor that contains the data of interest
+    /// @param length The total number of bytes to transfer
+    /// @param timeout Specify the amount of time in milliseconds
+    /// @return `kIOReturnSuccess` on success, other values otherwise.
+    /// @seealso `performConcurrentBulkTransferGated()`.
+    ///
+    IOReturn performConcurrentBulkTransfer(IOUSBHostPipe* pipe, IOMemoryDescriptor* buffer, IOByteCount length, UInt32 timeout);
+    
     ///
     /// Perform an inbound transfer on the bulk endpoint
     ///
@@ -1135,6 +1322,26 @@ protected:
     ///
     void onSDCardEventProcessedCompletion(void* parameter, IOReturn status, OSDictionary* characteristics);
     
+    ///
+    /// [Helper] Check whether the polling thread should skip fetching the device status and back off
+    ///
+    /// @return `true` if the host has transferred data since the last run and the polling interval has not reached its maximum,
+    ///         `false` otherwise.
+    /// @note This function updates the interval until the next run of the polling thread.
+    /// @note This function runs in a gated context.
+    ///
+    bool shouldSkipFetchingDeviceStatusGated();
+    
+    ///
+    /// [Helper] Publish the polling statistics in the I/O Registry
+    ///
+    /// @param force `true` if the statistics should be published regardless of the number of runs of the polling thread
+    /// @note The statistics are published once every `kNumDeviceStatusPollsPerPublish` runs unless `force` is `true`,
+    ///       since updating the I/O Registry on every run costs more than fetching the device status itself.
+    /// @note This function runs in a gated context.
+    ///
+    void publishDeviceStatusPollingStatisticsGated(bool force);
+    
     ///
     /// Fetch the device status periodically
     ///